@@ -0,0 +1,702 @@
+/**************************************************************************************************
+	Module:       CFlatHashTable.h
+
+	Open addressing hash table storing keys and associated values, with the same interface as
+	CHashTable. The key/value pairs are held in a single flat array rather than in lists, so
+	inserting doesn't allocate memory and looking up a key doesn't follow pointers. Better cache
+	behaviour than CHashTable for large tables. Can be used directly or selected for a CHashTable
+	instance through its constructor
+**************************************************************************************************/
+
+#ifndef GEN_C_FLAT_HASH_TABLE_H_INCLUDED
+#define GEN_C_FLAT_HASH_TABLE_H_INCLUDED
+
+#include <string.h>
+#include <iostream>
+using namespace std;
+
+#include "Defines.h"
+#include "Error.h"
+#include "HashFunctions.h"
+#include "HashTableStats.h"
+
+// Control bytes are tested 16 at a time using SSE2 instructions where available (always on x64,
+// and on x86 with the default /arch:SSE2 setting), otherwise with a simple loop
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+	#define GEN_FLAT_HASH_SSE2
+	#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace gen
+{
+
+// Return the index of the lowest set bit in a non-zero bit mask
+inline TUInt32 LowestSetBit( const TUInt32 iMask )
+{
+#if defined(_MSC_VER)
+	unsigned long iBit;
+	_BitScanForward( &iBit, iMask );
+	return iBit;
+#else
+	return __builtin_ctz( iMask );
+#endif
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	CFlatHashTable class
+---------------------------------------------------------------------------------------------*/
+
+// Template class, see the notes for CHashTable - the requirements on keys and values are the
+// same, except that both must also have a default constructor
+//
+// Each key/value pair is stored in a slot in a single array. A key is stored in the first free
+// slot found by stepping through the table from a position given by its hash value, and a look-up
+// steps through the same sequence until the key or an empty slot is found. This "open
+// addressing" is fast if the sequences are kept short, so the table is kept no more than 70% full
+// by default
+//
+// Each slot also has a control byte, these are held in a separate array. The control byte for a
+// slot holding a key contains 7 bits of the key's hash value. The other bit is only set for
+// empty slots and for slots whose key has been removed (which cannot simply be emptied or a
+// look-up passing through them would stop early). A look-up tests the control bytes for a group
+// of 16 slots at once against the 7 hash bits of the key. Only slots whose bits match have their
+// key compared, which is rarely more than one. This is the method used in Google's SwissTable
+template <class TKeyType, class TValueType, class THashPolicy = CHashFunctionPolicy<TKeyType> >
+class CFlatHashTable
+{
+
+/*---------------------------------------------------------------------------------------------
+	Constructors / Destructors
+---------------------------------------------------------------------------------------------*/
+public:
+	// Constructor takes initial table size (number of slots - rounded up to a power of 2), a
+	// hash policy (or hash function for the default policy), and the maximum load factor before
+	// the table is resized (at most 0.875)
+	CFlatHashTable
+	(
+		const TUInt32      iInitialSize,                 // Initial size for the hash table
+		const THashPolicy& hashPolicy = THashPolicy(),   // Hashing function to use
+		const TFloat32     fMaxLoadFactor = 0.7f         // Maximum load factor
+	) : m_kHashPolicy( hashPolicy ), m_kfMaxLoadFactor( fMaxLoadFactor )
+	{
+		GEN_GUARD;
+
+		// There must always be an empty slot somewhere or a search for a missing key would not end
+		GEN_ASSERT( fMaxLoadFactor > 0.0f && fMaxLoadFactor <= 0.875f, "Invalid load factor" );
+
+		// Allocate initial table
+		AllocateTable( m_Table, RoundUpSize( iInitialSize ) );
+
+		// Starting with no hash table entries, and not resizing
+		m_iNumEntries = 0;
+		m_iNumDeleted = 0;
+		m_OldTable.aControl = 0;
+		m_OldTable.aSlots = 0;
+		m_OldTable.iSize = 0;
+		m_iNextOldSlot = 0;
+		ResetStats();
+
+		GEN_ENDGUARD;
+	}
+
+private:
+	// Disallow use of copy constructor and assignment operator (private and not defined)
+	CFlatHashTable( const CFlatHashTable& );
+	CFlatHashTable& operator=( const CFlatHashTable& );
+
+public:
+	// Destructor to free hash table memory
+	~CFlatHashTable()
+	{
+		FreeTable( m_Table );
+		FreeTable( m_OldTable );
+	}
+
+
+/*---------------------------------------------------------------------------------------------
+	Public interface
+---------------------------------------------------------------------------------------------*/
+public:
+	// Looks up value associated with given key and puts in in given pointer. Returns true if
+	// the key was found
+	bool LookUpKey
+	(
+		const TKeyType& key,
+		TValueType*     pValue
+	)
+	{
+		// If the table is being resized, move a few more slots across
+		RehashStep();
+
+		TTable* pTable;
+		TUInt32 iSlot;
+		if (!FindKey( key, HashKey( key ), &pTable, &iSlot ))
+		{
+			GEN_HASH_STAT( ++m_Counters.iNumLookUpMisses );
+			return false;
+		}
+
+		// Found key, copy its value out and return true
+		*pValue = pTable->aSlots[iSlot].value;
+		GEN_HASH_STAT( ++m_Counters.iNumLookUpHits );
+		return true;
+	}
+
+
+	// Add the given key-value pair to the table, if the key already exists, just update its value
+	void SetKeyValue
+	(
+		const TKeyType&   key,
+		const TValueType& value
+	)
+	{
+		// If the table is being resized, move a few more slots across
+		RehashStep();
+
+		// If key already exists, simply update the value associated with it
+		TUInt32 iHash = HashKey( key );
+		TTable* pTable;
+		TUInt32 iSlot;
+		if (FindKey( key, iHash, &pTable, &iSlot ))
+		{
+			pTable->aSlots[iSlot].value = value;
+			return;
+		}
+
+		// Check loading of table - removed keys count as they lengthen searches in the same way
+		// as keys do. If too full then start doubling the table in size, unless it is mostly
+		// removed keys, in which case rebuilding it at the same size is enough to clear them. The
+		// key/value pairs are moved to the new table a few at a time in later operations
+		if (m_iNumEntries + m_iNumDeleted >= m_Table.iSize * m_kfMaxLoadFactor)
+		{
+			if (m_iNumEntries >= m_Table.iSize * m_kfMaxLoadFactor * 0.5f)
+			{
+				StartResize( m_Table.iSize * 2 );
+			}
+			else
+			{
+				StartResize( m_Table.iSize );
+			}
+		}
+
+		// New keys always go in the current table
+		iSlot = ClaimFreeSlot( iHash );
+		m_Table.aSlots[iSlot].key = key;
+		m_Table.aSlots[iSlot].value = value;
+
+		// Increase total number of entries in hash table
+		++m_iNumEntries;
+	}
+
+
+	// Remove the given key (and associated value) from the table, returns false if not found
+	bool RemoveKey(	const TKeyType& key )
+	{
+		// If the table is being resized, move a few more slots across
+		RehashStep();
+
+		TTable* pTable;
+		TUInt32 iSlot;
+		if (!FindKey( key, HashKey( key ), &pTable, &iSlot ))
+		{
+			return false;
+		}
+
+		// The slot must be marked as deleted so that look-ups for keys further along the sequence
+		// continue past it. However, if the slot's group still contains an empty slot then no
+		// look-up has ever continued past this group (it would have stopped at the empty slot),
+		// so the slot can be marked as empty instead. Deleted slots in the old table during a
+		// resize are not counted, the old table is discarded soon anyway
+		if (pTable == &m_Table && MatchEmpty( m_Table, iSlot & ~(kiGroupSize - 1) ))
+		{
+			m_Table.aControl[iSlot] = kiEmpty;
+		}
+		else
+		{
+			pTable->aControl[iSlot] = kiDeleted;
+			if (pTable == &m_Table)
+			{
+				++m_iNumDeleted;
+			}
+		}
+
+		// Release anything held by the key or value (e.g. string memory)
+		pTable->aSlots[iSlot] = TKeyValuePair();
+
+		// Decrease number of table entries - note that table is never resized downwards
+		--m_iNumEntries;
+
+		return true;
+	}
+
+
+	// Remove all keys and associated values
+	void RemoveAllKeys()
+	{
+		memset( m_Table.aControl, kiEmpty, m_Table.iSize );
+		for (TUInt32 iSlot = 0; iSlot < m_Table.iSize; ++iSlot)
+		{
+			m_Table.aSlots[iSlot] = TKeyValuePair();
+		}
+
+		// Any resize in progress is complete as there is nothing left to move
+		FreeTable( m_OldTable );
+		m_iNumEntries = 0;
+		m_iNumDeleted = 0;
+	}
+
+
+	// Make the table large enough to hold the given number of keys without resizing. Resizes the
+	// table immediately if necessary, so call before adding many keys (e.g. when loading a level)
+	// to avoid resizing during play
+	void Reserve( const TUInt32 iNumKeys )
+	{
+		TUInt32 iNewSize = RoundUpSize( static_cast<TUInt32>(iNumKeys / m_kfMaxLoadFactor) + 1 );
+		if (iNewSize > m_Table.iSize)
+		{
+			StartResize( iNewSize );
+			CompleteResize();
+		}
+	}
+
+
+	// Get statistics for the table (see HashTableStats.h). The counters are kept as operations
+	// happen, but the probe lengths are measured now by visiting the whole table, so call this
+	// occasionally (e.g. once a second) rather than every operation
+	void GetStats( SHashTableStats* pStats ) const
+	{
+		pStats->iNumEntries = m_iNumEntries;
+		pStats->iSize = m_Table.iSize;
+		pStats->fLoadFactor = static_cast<TFloat32>(m_iNumEntries) / m_Table.iSize;
+
+		// Probe lengths of the keys in the current table - keys still in the old table during a
+		// resize are not included
+		TUInt32 iMaxProbe = 0;
+		TFloat64 fTotalProbe = 0.0;
+		TUInt32 iUsedSlots = 0;
+		for (TUInt32 iSlot = 0; iSlot < m_Table.iSize; ++iSlot)
+		{
+			if (IsFull( m_Table, iSlot ))
+			{
+				TUInt32 iProbe = ProbeLength( iSlot );
+				if (iProbe > iMaxProbe)
+				{
+					iMaxProbe = iProbe;
+				}
+				fTotalProbe += iProbe;
+				++iUsedSlots;
+			}
+		}
+		pStats->iMaxProbeLength = iMaxProbe;
+		pStats->fMeanProbeLength = iUsedSlots ? static_cast<TFloat32>(fTotalProbe / iUsedSlots) : 0.0f;
+
+		// Copy counters
+#ifdef GEN_HASH_STATS
+		pStats->iNumResizes = m_Counters.iNumResizes;
+		pStats->iNumLookUpHits = m_Counters.iNumLookUpHits;
+		pStats->iNumLookUpMisses = m_Counters.iNumLookUpMisses;
+#else
+		pStats->iNumResizes = 0;
+		pStats->iNumLookUpHits = 0;
+		pStats->iNumLookUpMisses = 0;
+#endif
+	}
+
+	// Reset the look-up and resize counters
+	void ResetStats()
+	{
+		GEN_HASH_STAT( memset( &m_Counters, 0, sizeof(m_Counters) ) );
+	}
+
+
+	// Output a table showing how many groups of slots were searched to find each key (probe
+	// length). Ideally a key is always in the first group searched, keys that are further along
+	// take longer to look up. Long probes show up a poor hash function
+	void OutputDistribution() const
+	{
+		cout << "Flat Hash Table Distribution:" << endl << endl;
+		if (m_OldTable.aControl)
+		{
+			cout << "(Resize in progress, " << m_OldTable.iSize - m_iNextOldSlot
+			     << " old slots not included)" << endl;
+		}
+
+		const TUInt32 kiMaxProbeShown = 10;
+		TUInt32 aiProbeCounts[kiMaxProbeShown + 1] = { 0 };
+		TUInt32 iTotalProbe = 0;
+		TUInt32 iUsedSlots = 0;
+		for (TUInt32 iSlot = 0; iSlot < m_Table.iSize; ++iSlot)
+		{
+			if (IsFull( m_Table, iSlot ))
+			{
+				TUInt32 iProbe = ProbeLength( iSlot );
+				iTotalProbe += iProbe;
+				++aiProbeCounts[iProbe < kiMaxProbeShown ? iProbe : kiMaxProbeShown];
+				++iUsedSlots;
+			}
+		}
+		for (TUInt32 iProbe = 1; iProbe <= kiMaxProbeShown; ++iProbe)
+		{
+			cout << "Probe length " << iProbe << (iProbe == kiMaxProbeShown ? "+: " : ": ")
+			     << aiProbeCounts[iProbe] << endl;
+		}
+		cout << endl << "% used slots: " << 100.0f * static_cast<float>(iUsedSlots) / m_Table.iSize;
+		cout << endl << "% deleted slots: "
+		     << 100.0f * static_cast<float>(m_iNumDeleted) / m_Table.iSize;
+		cout << endl << "Average probe length: "
+		     << static_cast<float>(iTotalProbe) / iUsedSlots << endl;
+		cout << endl;
+	}
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	/*---------------------------------------------------------------------------------------------
+		Types / constants
+	---------------------------------------------------------------------------------------------*/
+
+	// A key/value pair held by the hash table
+	struct TKeyValuePair
+	{
+		TKeyType         key;
+		TValueType       value;
+	};
+
+	// The arrays making up a table - there are two tables while the hash table is being resized
+	struct TTable
+	{
+		TUInt8*        aControl; // Dynamically allocated array of control bytes, one per slot
+		TKeyValuePair* aSlots;   // Dynamically allocated array of key/value pair slots
+		TUInt32        iSize;    // Number of slots, a power of 2
+	};
+
+	// Number of slots whose control bytes are tested together
+	static const TUInt32 kiGroupSize = 16;
+
+	// Control bytes for slots without a key. Slots with a key have a control byte from 0 to 127
+	// (7 bits of the key's hash value), so the top bit marks a slot without a key
+	static const TUInt8 kiEmpty = 0x80;
+	static const TUInt8 kiDeleted = 0xfe;
+
+	// Number of old slots moved to the new table in each operation while the table is being
+	// resized. The resize completes long before the table is full enough to need another
+	static const TUInt32 kiRehashStep = 32;
+
+
+	/*---------------------------------------------------------------------------------------------
+		Support functions
+	---------------------------------------------------------------------------------------------*/
+
+	// Return the table size to use for the given number of slots - a power of 2, and at least
+	// one group
+	static TUInt32 RoundUpSize( const TUInt32 iMinSize )
+	{
+		TUInt32 iSize = kiGroupSize;
+		while (iSize < iMinSize)
+		{
+			iSize *= 2;
+		}
+		return iSize;
+	}
+
+	// Allocate empty arrays for a table of the given size
+	static void AllocateTable( TTable& table, const TUInt32 iSize )
+	{
+		table.iSize = iSize;
+		table.aControl = new TUInt8[iSize];
+		table.aSlots = new TKeyValuePair[iSize];
+		GEN_ASSERT( table.aControl && table.aSlots, "Fatal memory error reserving hash table memory" );
+		memset( table.aControl, kiEmpty, iSize );
+	}
+
+	// Free the arrays of a table
+	static void FreeTable( TTable& table )
+	{
+		delete[] table.aControl;
+		delete[] table.aSlots;
+		table.aControl = 0;
+		table.aSlots = 0;
+	}
+
+
+	// Get the hash value for a key
+	TUInt32 HashKey( const TKeyType& key ) const
+	{
+		return m_kHashPolicy( key );
+	}
+
+	// The lower 7 bits of a hash value are stored in the control byte of the key's slot, the
+	// remaining bits select the first group to search. This way the control byte gives more
+	// information than just repeating the group
+	static TUInt8 HashTag( const TUInt32 iHash )
+	{
+		return static_cast<TUInt8>(iHash & 0x7f);
+	}
+	static TUInt32 FirstGroup( const TTable& table, const TUInt32 iHash )
+	{
+		return (iHash >> 7) & (table.iSize / kiGroupSize - 1);
+	}
+
+	// Return true if the given slot holds a key
+	static bool IsFull( const TTable& table, const TUInt32 iSlot )
+	{
+		return (table.aControl[iSlot] & 0x80) == 0;
+	}
+
+
+	// Return a bit mask with a bit set for each slot in the group starting at the given slot that
+	// has the given control byte
+	static TUInt32 MatchControl( const TTable& table, const TUInt32 iFirstSlot, const TUInt8 iControl )
+	{
+#ifdef GEN_FLAT_HASH_SSE2
+		__m128i control = _mm_loadu_si128( reinterpret_cast<const __m128i*>(table.aControl + iFirstSlot) );
+		__m128i match = _mm_cmpeq_epi8( control, _mm_set1_epi8( static_cast<char>(iControl) ) );
+		return static_cast<TUInt32>(_mm_movemask_epi8( match ));
+#else
+		TUInt32 iMask = 0;
+		for (TUInt32 iSlot = 0; iSlot < kiGroupSize; ++iSlot)
+		{
+			if (table.aControl[iFirstSlot + iSlot] == iControl)
+			{
+				iMask |= 1 << iSlot;
+			}
+		}
+		return iMask;
+#endif
+	}
+
+	// Return a bit mask with a bit set for each empty slot in the group starting at the given slot
+	static TUInt32 MatchEmpty( const TTable& table, const TUInt32 iFirstSlot )
+	{
+		return MatchControl( table, iFirstSlot, kiEmpty );
+	}
+
+	// Return a bit mask with a bit set for each empty or deleted slot in the group starting at the
+	// given slot, i.e. each control byte with the top bit set
+	static TUInt32 MatchFree( const TTable& table, const TUInt32 iFirstSlot )
+	{
+#ifdef GEN_FLAT_HASH_SSE2
+		__m128i control = _mm_loadu_si128( reinterpret_cast<const __m128i*>(table.aControl + iFirstSlot) );
+		return static_cast<TUInt32>(_mm_movemask_epi8( control ));
+#else
+		TUInt32 iMask = 0;
+		for (TUInt32 iSlot = 0; iSlot < kiGroupSize; ++iSlot)
+		{
+			if (table.aControl[iFirstSlot + iSlot] & 0x80)
+			{
+				iMask |= 1 << iSlot;
+			}
+		}
+		return iMask;
+#endif
+	}
+
+
+	// Find the slot in the given table containing the given key (with the given hash value).
+	// Returns false if the key is not in the table. The groups are searched starting from the one
+	// given by the hash value, stepping on 1, 2, 3... groups each time. With a power of 2 number
+	// of groups this sequence visits every group before repeating
+	static bool FindSlot
+	(
+		const TTable&   table,
+		const TKeyType& key,
+		const TUInt32   iHash,
+		TUInt32*        piSlot
+	)
+	{
+		TUInt32 iGroupMask = table.iSize / kiGroupSize - 1;
+		TUInt32 iGroup = FirstGroup( table, iHash );
+		TUInt8 iTag = HashTag( iHash );
+		for (TUInt32 iStep = 1; ; ++iStep)
+		{
+			// Compare the key against each slot in the group with matching hash bits
+			TUInt32 iFirstSlot = iGroup * kiGroupSize;
+			TUInt32 iMatches = MatchControl( table, iFirstSlot, iTag );
+			while (iMatches)
+			{
+				TUInt32 iSlot = iFirstSlot + LowestSetBit( iMatches );
+				if (key == table.aSlots[iSlot].key)
+				{
+					*piSlot = iSlot;
+					return true;
+				}
+				iMatches &= iMatches - 1; // Clear lowest set bit
+			}
+
+			// The key would have been stored in an empty slot in this group, so stop if there is one
+			if (MatchEmpty( table, iFirstSlot ))
+			{
+				return false;
+			}
+			iGroup = (iGroup + iStep) & iGroupMask;
+		}
+	}
+
+	// Find the first empty or deleted slot in the given table in the sequence for the given hash
+	// value
+	static TUInt32 FindFreeSlot( const TTable& table, const TUInt32 iHash )
+	{
+		TUInt32 iGroupMask = table.iSize / kiGroupSize - 1;
+		TUInt32 iGroup = FirstGroup( table, iHash );
+		for (TUInt32 iStep = 1; ; ++iStep)
+		{
+			TUInt32 iFirstSlot = iGroup * kiGroupSize;
+			TUInt32 iFree = MatchFree( table, iFirstSlot );
+			if (iFree)
+			{
+				return iFirstSlot + LowestSetBit( iFree );
+			}
+			iGroup = (iGroup + iStep) & iGroupMask;
+		}
+	}
+
+	// Find the table and slot containing the given key (with the given hash value), returns false
+	// if the key is not in the hash table. While resizing, keys not yet moved are in the old table
+	bool FindKey
+	(
+		const TKeyType& key,
+		const TUInt32   iHash,
+		TTable**        ppTable,
+		TUInt32*        piSlot
+	)
+	{
+		if (FindSlot( m_Table, key, iHash, piSlot ))
+		{
+			*ppTable = &m_Table;
+			return true;
+		}
+		if (m_OldTable.aControl && FindSlot( m_OldTable, key, iHash, piSlot ))
+		{
+			*ppTable = &m_OldTable;
+			return true;
+		}
+		return false;
+	}
+
+	// Take the first free slot in the current table for a key with the given hash value, and set
+	// its control byte. Returns the slot, the caller sets its key and value
+	TUInt32 ClaimFreeSlot( const TUInt32 iHash )
+	{
+		TUInt32 iSlot = FindFreeSlot( m_Table, iHash );
+		if (m_Table.aControl[iSlot] == kiDeleted)
+		{
+			--m_iNumDeleted;
+		}
+		m_Table.aControl[iSlot] = HashTag( iHash );
+		return iSlot;
+	}
+
+	// Return the number of groups searched to find the key in the given slot of the current table
+	TUInt32 ProbeLength( const TUInt32 iSlot ) const
+	{
+		TUInt32 iGroupMask = m_Table.iSize / kiGroupSize - 1;
+		TUInt32 iGroup = FirstGroup( m_Table, HashKey( m_Table.aSlots[iSlot].key ) );
+		TUInt32 iProbe = 1;
+		while (iGroup != iSlot / kiGroupSize)
+		{
+			iGroup = (iGroup + iProbe) & iGroupMask;
+			++iProbe;
+		}
+		return iProbe;
+	}
+
+
+	// Start resizing the hash table. A new table is created and the old table is kept until all
+	// its key/value pairs have been moved across. This is done a few slots at a time in each
+	// operation (see RehashStep), so there is no stall while the whole table is rebuilt. Until
+	// then, keys are searched for in both tables. Also clears all deleted slots
+	void StartResize( const TUInt32 iNewSize )
+	{
+		GEN_GUARD;
+
+		// Finish any previous resize first
+		CompleteResize();
+		GEN_HASH_STAT( ++m_Counters.iNumResizes );
+
+		m_OldTable = m_Table;
+		AllocateTable( m_Table, iNewSize );
+		m_iNextOldSlot = 0;
+		m_iNumDeleted = 0;
+
+		GEN_ENDGUARD;
+	}
+
+	// Move the key/value pairs from the next few old slots into the new table, if the table is
+	// being resized. Frees the old table when all have been moved
+	void RehashStep( const TUInt32 iNumSlots = kiRehashStep )
+	{
+		if (!m_OldTable.aControl)
+		{
+			return;
+		}
+
+		TUInt32 iEndSlot = m_iNextOldSlot + iNumSlots;
+		if (iEndSlot > m_OldTable.iSize)
+		{
+			iEndSlot = m_OldTable.iSize;
+		}
+		for (; m_iNextOldSlot < iEndSlot; ++m_iNextOldSlot)
+		{
+			// The keys are known to be distinct so can go straight into a free slot. The old slot
+			// is marked as deleted so searches of the old table don't find the key again
+			if (IsFull( m_OldTable, m_iNextOldSlot ))
+			{
+				TKeyValuePair& oldPair = m_OldTable.aSlots[m_iNextOldSlot];
+				TUInt32 iSlot = ClaimFreeSlot( HashKey( oldPair.key ) );
+				m_Table.aSlots[iSlot] = oldPair;
+				m_OldTable.aControl[m_iNextOldSlot] = kiDeleted;
+			}
+		}
+
+		if (m_iNextOldSlot == m_OldTable.iSize)
+		{
+			FreeTable( m_OldTable );
+		}
+	}
+
+	// Immediately finish any resize in progress
+	void CompleteResize()
+	{
+		if (m_OldTable.aControl)
+		{
+			RehashStep( m_OldTable.iSize );
+		}
+	}
+
+
+	/*---------------------------------------------------------------------------------------------
+		Data
+	---------------------------------------------------------------------------------------------*/
+
+	TTable  m_Table;       // Current table
+	TUInt32 m_iNumEntries; // Number of key/value pairs in the table (in both tables when resizing)
+	TUInt32 m_iNumDeleted; // Number of slots in the current table marked as deleted
+
+	// While the table is being resized, the old table is kept here until all its key/value pairs
+	// have been moved to the current table. Arrays are 0 when not resizing
+	TTable  m_OldTable;
+	TUInt32 m_iNextOldSlot; // Old slots before this one have been moved
+
+#ifdef GEN_HASH_STATS
+	// Statistics counters, see HashTableStats.h
+	SHashTableCounters m_Counters;
+#endif
+
+	// Hash policy to use, calls the hash function for keys (see HashFunctions.h)
+	const THashPolicy m_kHashPolicy;
+
+	// If table becomes too full, then it is increased in size to keep searches short. In this
+	// implementation, the table is never decreased in size
+	const TFloat32 m_kfMaxLoadFactor;
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_FLAT_HASH_TABLE_H_INCLUDED
@@ -11,6 +11,9 @@
 	Templates are a form of "generic" programming. They are very powerful and encourage code reuse.
 	Be careful though, C++ template syntax is rather tricky.
 
+	The key/value pairs are stored in lists by default, but a table can be constructed to use the
+	flat storage of CFlatHashTable instead, which is better for large tables
+
 	Copyright 2007, University of Central Lancashire and Laurent Noel
 **************************************************************************************************/
 
@@ -18,33 +21,31 @@
 #define GEN_C_HASH_TABLE_H_INCLUDED
 
 #include <math.h>
+#include <string.h>
 #include <iostream>
 #include <list>
+#include <new>
 using namespace std;
 
 #include "Defines.h"
 #include "Error.h"
+#include "HashFunctions.h"
+#include "CFlatHashTable.h"
+#include "HashTableStats.h"
 
 namespace gen
 {
 
 /*------------------------------------------------------------------------------------------------
-	Hashing functions
+	Storage types
  ------------------------------------------------------------------------------------------------*/
 
-// This hash map class allows the use of different hash functions. To allow this we first define
-// a function pointer *type* for hash functions. This defines the function prototype for user-
-// provided hash functions: the parameters are a pointer to the key data (as a sequence of bytes),
-// and the length of the key data in bytes. This allows keys of any type to be hashed. The hash
-// function returns a 4-byte integer, the index to use for the value associated with the key
-typedef TUInt32 (*THashFunction)( const TUInt8* key, const TUInt32 keyLen );
-
-// Basic hashing function - simply adds up each byte in the key to give the resultant index
-TUInt32 AddUpHash( const TUInt8* pKey, const TUInt32 iKeyLen );
-
-// Jenkins one-at-a-time hashing function, a high performance hashing function with good
-// distribution of indexes (few collisions)
-TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
+// How a hash table stores its key/value pairs, chosen when the table is constructed
+enum EHashTableStorage
+{
+	kChainedStorage = 0, // Array of buckets, each a list of the key/value pairs in that bucket
+	kFlatStorage,        // Open addressing in a flat array (CFlatHashTable), faster for large tables
+};
 
 
 /*---------------------------------------------------------------------------------------------
@@ -65,8 +66,11 @@ TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
 // class would not compile.
 // A further restriction is that keys must not contain pointers (although values can). This is
 // because the hash function treats keys as a sequence of raw bytes, pointers are not followed
-// and the data pointed at will not be hashed
-template <class TKeyType, class TValueType>
+// and the data pointed at will not be hashed. That includes STL strings, which hold their
+// characters through a pointer. This restriction is lifted by giving a hash policy for the key
+// type as the third template parameter, e.g. CHashPolicy<string> (see HashFunctions.h). Integer
+// keys should also use CHashPolicy, it is much faster than hashing the key one byte at a time
+template <class TKeyType, class TValueType, class THashPolicy = CHashFunctionPolicy<TKeyType> >
 class CHashTable
 {
 
@@ -74,24 +78,46 @@ class CHashTable
 	Constructors / Destructore
 ---------------------------------------------------------------------------------------------*/
 public:
-	// Constructor takes initial table size, a hashing function, and the maximum load factor
-	// before the table is resized - see data section at end
+	// Constructor takes initial table size, a hash policy (or hashing function for the default
+	// policy), the maximum load factor before the table is resized - see data section at end,
+	// and the storage to use
 	CHashTable
 	(
-		const TUInt32  iInitialSize,         // Initial size for the hash table
-		THashFunction  pfHashFunction,       // Hashing function to use
-		const TFloat32 fMaxLoadFactor = 0.7f // Maximum load factor
-	) : m_kfMaxLoadFactor( fMaxLoadFactor ), m_kpfHashFunction( pfHashFunction )
+		const TUInt32           iInitialSize,                // Initial size for the hash table
+		const THashPolicy&      hashPolicy = THashPolicy(),  // Hashing function to use
+		const TFloat32          fMaxLoadFactor = 0.7f,       // Maximum load factor
+		const EHashTableStorage eStorage = kChainedStorage   // List or flat storage
+	) : m_kHashPolicy( hashPolicy ), m_kfMaxLoadFactor( fMaxLoadFactor )
 	{
 		GEN_GUARD;
 
-		// Allocate initial hash table array
-		m_iSize = iInitialSize;
-		m_aBuckets = new TBucket[m_iSize];
-		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
+		// Flat storage is provided by a separate table that all functions pass on to
+		if (eStorage == kFlatStorage)
+		{
+			m_pFlatTable = new TFlatTable( iInitialSize, hashPolicy, fMaxLoadFactor );
+			m_aBuckets = 0;
+			m_iSize = 0;
+		}
+		else
+		{
+			// Allocate initial hash table array and construct all its buckets
+			m_pFlatTable = 0;
+			m_iSize = iInitialSize;
+			m_aBuckets = AllocateBuckets( m_iSize );
+			for (TUInt32 iBucket = 0; iBucket < m_iSize; ++iBucket)
+			{
+				new (&m_aBuckets[iBucket]) TBucket;
+			}
+		}
 
-		// Starting with no hash table entries
+		// Starting with no hash table entries, and not resizing
 		m_iNumEntries = 0;
+		m_aOldBuckets = 0;
+		m_iOldSize = 0;
+		m_iNextOldBucket = 0;
+		m_aiBuiltBuckets = 0;
+		m_iNextBuiltBucket = 0;
+		ResetStats();
 
 		GEN_ENDGUARD;
 	}
@@ -108,7 +134,10 @@ public:
 	// Destructor to free hash table memory
 	~CHashTable()
 	{
-		delete[] m_aBuckets;
+		delete m_pFlatTable;
+		FreeBuckets( m_aBuckets, m_iSize, m_aiBuiltBuckets );
+		FreeBuckets( m_aOldBuckets, m_iOldSize, 0 );
+		delete[] m_aiBuiltBuckets;
 	}
 
 
@@ -124,20 +153,30 @@ public:
 		TValueType*     pValue
 	)
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
+		if (m_pFlatTable)
+		{
+			return m_pFlatTable->LookUpKey( key, pValue );
+		}
+
+		// If the table is being resized, move a few more buckets across
+		RehashStep();
+
+		// Find the bucket associated with this key (will use hashing function)
+		TBucket* pBucket = FindBucket( key );
 
 		// Search the bucket to find the the given key
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
+		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( pBucket, key );
 
 		// Not found (reached end of list), return false
-		if (itKeyValuePair == m_aBuckets[iBucket].end())
+		if (itKeyValuePair == pBucket->end())
 		{
+			GEN_HASH_STAT( ++m_Counters.iNumLookUpMisses );
 			return false;
 		}
 
 		// Found key, copy its value out and return true
 		*pValue = itKeyValuePair->value;
+		GEN_HASH_STAT( ++m_Counters.iNumLookUpHits );
 		return true;
 	}
 
@@ -149,30 +188,40 @@ public:
 		const TValueType& value
 	)
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->SetKeyValue( key, value );
+			return;
+		}
+
+		// If the table is being resized, move a few more buckets across
+		RehashStep();
+
+		// Find the bucket associated with this key (will use hashing function)
+		TBucket* pBucket = FindBucket( key );
 
 		// See if given key already exists in the bucket 
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
-		if (itKeyValuePair != m_aBuckets[iBucket].end())
+		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( pBucket, key );
+		if (itKeyValuePair != pBucket->end())
 		{
 			// If key already exists, simply update the value associated with it
 			itKeyValuePair->value = value;
 		}
 		else // otherwise a new key/value pair needs to be inserted in the bucket
 		{
-			// Check loading of table - if too full, then double it in size
+			// Check loading of table - if too full, then start doubling it in size. The key/value
+			// pairs are moved to the new buckets a few at a time in later operations
 			if (m_iNumEntries > m_iSize * m_kfMaxLoadFactor)
 			{
-				Resize( m_iSize * 2 );
-				iBucket = FindBucket( key ); // Find new bucket for key after resizing
+				StartResize( m_iSize * 2 );
+				pBucket = FindBucket( key ); // Find new bucket for key after resizing
 			}
 
 			// Create a new key/value pair and add it to the list in this bucket
 			TKeyValuePair newPair;
 			newPair.key = key;
 			newPair.value = value;
-			m_aBuckets[iBucket].push_back( newPair );
+			pBucket->push_back( newPair );
 
 			// Increase total number of entries in hash table
 			++m_iNumEntries;
@@ -183,20 +232,28 @@ public:
 	// Remove the given key (and associated value) from the table, returns false if not found
 	bool RemoveKey(	const TKeyType& key )
 	{
-		// Find the index of the bucket associated with this key (will use hashing function)
-		TUInt32 iBucket = FindBucket( key );
+		if (m_pFlatTable)
+		{
+			return m_pFlatTable->RemoveKey( key );
+		}
+
+		// If the table is being resized, move a few more buckets across
+		RehashStep();
+
+		// Find the bucket associated with this key (will use hashing function)
+		TBucket* pBucket = FindBucket( key );
 
 		// Search the bucket to find the the given key
-		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( iBucket, key );
+		TKeyValuePairIter itKeyValuePair = FindKeyValuePair( pBucket, key );
 
 		// If not found then nothing to do
-		if (itKeyValuePair == m_aBuckets[iBucket].end())
+		if (itKeyValuePair == pBucket->end())
 		{   
 			return false;
 		}
 
 		// Remove the found key from the bucket
-		m_aBuckets[iBucket].erase( itKeyValuePair );
+		pBucket->erase( itKeyValuePair );
 
 		// Decrease number of table entries - note that table is never resized downwards
 		--m_iNumEntries; 
@@ -208,10 +265,114 @@ public:
 	// Remove all keys and associated values
 	void RemoveAllKeys()
 	{
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->RemoveAllKeys();
+			return;
+		}
+
 		for (TUInt32 iBucket = 0; iBucket < m_iSize; ++iBucket)
 		{
-			m_aBuckets[iBucket].clear();
+			if (IsBucketBuilt( iBucket ))
+			{
+				m_aBuckets[iBucket].clear();
+			}
+		}
+
+		// Any resize in progress is complete as there is nothing left to move
+		if (m_aOldBuckets)
+		{
+			EndResize();
+		}
+		m_iNumEntries = 0;
+	}
+
+
+	// Make the table large enough to hold the given number of keys without resizing. Resizes the
+	// table immediately if necessary, so call before adding many keys (e.g. when loading a level)
+	// to avoid resizing during play
+	void Reserve( const TUInt32 iNumKeys )
+	{
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->Reserve( iNumKeys );
+			return;
+		}
+
+		// Number of buckets needed so the table is not loaded past the maximum
+		TUInt32 iNewSize = static_cast<TUInt32>(iNumKeys / m_kfMaxLoadFactor) + 1;
+		if (iNewSize > m_iSize)
+		{
+			StartResize( iNewSize );
+			CompleteResize();
+		}
+	}
+
+
+	// Get statistics for the table (see HashTableStats.h). The counters are kept as operations
+	// happen, but the probe lengths are measured now by visiting the whole table, so call this
+	// occasionally (e.g. once a second) rather than every operation
+	void GetStats( SHashTableStats* pStats ) const
+	{
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->GetStats( pStats );
+			return;
+		}
+
+		pStats->iNumEntries = m_iNumEntries;
+		pStats->iSize = m_iSize;
+		pStats->fLoadFactor = static_cast<TFloat32>(m_iNumEntries) / m_iSize;
+
+		// A key's probe length is its position in its bucket's list, so a bucket with n keys has
+		// probe lengths 1 to n. Old buckets not yet moved by a resize are included
+		TUInt32 iMaxBucketSize = 0;
+		TFloat64 fTotalProbe = 0.0;
+		for (TUInt32 iBucket = 0; iBucket < m_iSize + m_iOldSize; ++iBucket)
+		{
+			TUInt32 iBucketSize;
+			if (iBucket < m_iSize)
+			{
+				iBucketSize = BucketSize( iBucket );
+			}
+			else if (m_aOldBuckets && iBucket - m_iSize >= m_iNextOldBucket)
+			{
+				iBucketSize = static_cast<TUInt32>(m_aOldBuckets[iBucket - m_iSize].size());
+			}
+			else
+			{
+				continue;
+			}
+			if (iBucketSize > iMaxBucketSize)
+			{
+				iMaxBucketSize = iBucketSize;
+			}
+			fTotalProbe += 0.5 * iBucketSize * (iBucketSize + 1);
+		}
+		pStats->iMaxProbeLength = iMaxBucketSize;
+		pStats->fMeanProbeLength =
+			m_iNumEntries ? static_cast<TFloat32>(fTotalProbe / m_iNumEntries) : 0.0f;
+
+		// Copy counters
+#ifdef GEN_HASH_STATS
+		pStats->iNumResizes = m_Counters.iNumResizes;
+		pStats->iNumLookUpHits = m_Counters.iNumLookUpHits;
+		pStats->iNumLookUpMisses = m_Counters.iNumLookUpMisses;
+#else
+		pStats->iNumResizes = 0;
+		pStats->iNumLookUpHits = 0;
+		pStats->iNumLookUpMisses = 0;
+#endif
+	}
+
+	// Reset the look-up and resize counters
+	void ResetStats()
+	{
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->ResetStats();
 		}
+		GEN_HASH_STAT( memset( &m_Counters, 0, sizeof(m_Counters) ) );
 	}
 
 
@@ -224,7 +385,18 @@ public:
 	// of such situations. This function will show up good / bad hash functions
 	void OutputDistribution() const
 	{
+		if (m_pFlatTable)
+		{
+			m_pFlatTable->OutputDistribution();
+			return;
+		}
+
 		cout << "Hash Table Distribution:" << endl << endl;
+		if (m_aOldBuckets)
+		{
+			cout << "(Resize in progress, " << m_iOldSize - m_iNextOldBucket
+			     << " old buckets not included)" << endl;
+		}
 		
 		// Calculate the average size of those buckets that contain keys. This gives an idea of the
 		// efficiency to look up a key
@@ -235,7 +407,7 @@ public:
 		TUInt32 iBucket = 0;
 		while (iBucket != m_iSize)
 		{
-			TUInt32 iCollision = static_cast<TUInt32>(m_aBuckets[iBucket].size());
+			TUInt32 iCollision = BucketSize( iBucket );
 			// Output a digit if less than 10 entries in a bucket
 			if (iCollision < 10)
 			{
@@ -282,26 +454,99 @@ private:
 	// Use of templates is powerful, but can cause syntax headaches - the need for "typename"
 	// here is an example
 
+	// Table used for flat storage
+	typedef CFlatHashTable<TKeyType, TValueType, THashPolicy> TFlatTable;
+
+
+	// Number of old buckets moved to the new buckets in each operation while the table is being
+	// resized. The resize completes long before the table is full enough to need another
+	static const TUInt32 kiRehashStep = 4;
+
 
 	/*---------------------------------------------------------------------------------------------
 		Support functions
 	---------------------------------------------------------------------------------------------*/
 
-	// Find the index of the bucket that should contain the given key
-	TUInt32 FindBucket(	const TKeyType& key	) const
+	// Allocate uninitialised memory for the given number of buckets, the buckets must be
+	// constructed with placement new before use
+	static TBucket* AllocateBuckets( const TUInt32 iNumBuckets )
+	{
+		return static_cast<TBucket*>(::operator new( iNumBuckets * sizeof(TBucket) ));
+	}
+
+	// Destroy the buckets in an array allocated with AllocateBuckets and free its memory. Pass
+	// the bits marking which buckets have been constructed, or 0 if all have
+	static void FreeBuckets( TBucket* aBuckets, const TUInt32 iNumBuckets,
+	                         const TUInt32* aiBuiltBuckets )
+	{
+		if (!aBuckets)
+		{
+			return;
+		}
+		for (TUInt32 iBucket = 0; iBucket < iNumBuckets; ++iBucket)
+		{
+			if (!aiBuiltBuckets || (aiBuiltBuckets[iBucket >> 5] & (1u << (iBucket & 31))))
+			{
+				aBuckets[iBucket].~TBucket();
+			}
+		}
+		::operator delete( aBuckets );
+	}
+
+	// Return true if the given bucket has been constructed. All buckets are constructed except
+	// while the table is being resized
+	bool IsBucketBuilt( const TUInt32 iBucket ) const
+	{
+		return !m_aiBuiltBuckets || (m_aiBuiltBuckets[iBucket >> 5] & (1u << (iBucket & 31)));
+	}
+
+	// Return the bucket with the given index, constructing it first if it is a new bucket that
+	// hasn't been used yet
+	TBucket* GetBucket( const TUInt32 iBucket )
+	{
+		if (!IsBucketBuilt( iBucket ))
+		{
+			new (&m_aBuckets[iBucket]) TBucket;
+			m_aiBuiltBuckets[iBucket >> 5] |= 1u << (iBucket & 31);
+		}
+		return &m_aBuckets[iBucket];
+	}
+
+	// Return the number of key/value pairs in the given bucket, 0 if it hasn't been constructed
+	TUInt32 BucketSize( const TUInt32 iBucket ) const
 	{
-		// Get a pointer to the key as raw bytes - this cast is OK for this kind of purpose
-		const TUInt8* pKeyData = reinterpret_cast<const TUInt8*>(&key);
+		return IsBucketBuilt( iBucket ) ? static_cast<TUInt32>(m_aBuckets[iBucket].size()) : 0;
+	}
+
+	// Construct the new buckets, in order, up to the given bucket (not included)
+	void BuildBuckets( const TUInt32 iEndBucket )
+	{
+		while (m_iNextBuiltBucket < iEndBucket)
+		{
+			GetBucket( m_iNextBuiltBucket );
+			++m_iNextBuiltBucket;
+		}
+	}
 
-		// Use hashing function to convert key data to a single 4-byte integer
-		TUInt32 iIndex = m_kpfHashFunction( pKeyData, sizeof(TKeyType) );
+	// Find the bucket that should contain the given key. While the table is being resized, this
+	// is in the old buckets if the key's old bucket has not been moved yet
+	TBucket* FindBucket( const TKeyType& key )
+	{
+		// Use hash policy to convert key to a single 4-byte integer
+		TUInt32 iHash = m_kHashPolicy( key );
 		
 		// Convert this 4-byte hash value to a bucket index. We have m_iSize buckets, so just
 		// use the integer modulus operator. Could use faster bitwise operator if number of
 		// buckets was a power of 2, but will deal with the general case here
-		iIndex %= m_iSize;
-
-		return iIndex;
+		if (m_aOldBuckets)
+		{
+			TUInt32 iOldIndex = iHash % m_iOldSize;
+			if (iOldIndex >= m_iNextOldBucket)
+			{
+				return &m_aOldBuckets[iOldIndex];
+			}
+		}
+		return GetBucket( iHash % m_iSize );
 	}
 
 
@@ -309,13 +554,13 @@ private:
 	// Returns the end of list iterator if not found
 	TKeyValuePairIter FindKeyValuePair
 	(
-		const int       iBucket,
+		TBucket*        pBucket,
 		const TKeyType& key
 	) const
 	{
 		// Start at beginning of bucket and step through each key/value pair
-		TKeyValuePairIter itKeyValuePair = m_aBuckets[iBucket].begin();
-		while (itKeyValuePair != m_aBuckets[iBucket].end())
+		TKeyValuePairIter itKeyValuePair = pBucket->begin();
+		while (itKeyValuePair != pBucket->end())
 		{
 			// If we find a matching key, then quit loop
 			if (key == itKeyValuePair->key)
@@ -329,34 +574,94 @@ private:
 		return itKeyValuePair;
 	}
 
-	// Resize the hash table - reinserts all keys
-	void Resize( const TUInt32 iNewSize )
+	// Start resizing the hash table. Memory for the new buckets is allocated and the old buckets
+	// are kept until all their key/value pairs have been moved across. This is done a few
+	// buckets at a time in each operation (see RehashStep), so there is no stall while the whole
+	// table is rebuilt. Until then, keys are found in the old or new buckets (see FindBucket).
+	// The new buckets are not constructed yet - each is constructed when first used or when the
+	// rehash reaches it
+	void StartResize( const TUInt32 iNewSize )
 	{
 		GEN_GUARD;
 
-		// Store old buckets and size
-		TUInt32 iOldSize = m_iSize;
-		TBucket* aOldBuckets = m_aBuckets;
+		// Finish any previous resize first
+		CompleteResize();
+		GEN_HASH_STAT( ++m_Counters.iNumResizes );
 
-		// Update size and create new set of buckets
+		// Keep old buckets and size
+		m_iOldSize = m_iSize;
+		m_aOldBuckets = m_aBuckets;
+		m_iNextOldBucket = 0;
+
+		// Update size and allocate the new set of buckets, with none constructed
 		m_iSize = iNewSize;
-		m_aBuckets = new TBucket[m_iSize];
-		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
+		m_aBuckets = AllocateBuckets( m_iSize );
+		TUInt32 iNumWords = (m_iSize + 31) >> 5;
+		m_aiBuiltBuckets = new TUInt32[iNumWords];
+		memset( m_aiBuiltBuckets, 0, iNumWords * sizeof(TUInt32) );
+		m_iNextBuiltBucket = 0;
 
-		// Go through old buckets and set each key/value pair into new buckets
-		m_iNumEntries = 0;
-		for (TUInt32 iBucket = 0; iBucket < iOldSize; ++iBucket)
+		GEN_ENDGUARD;
+	}
+
+	// Move the key/value pairs from the next few old buckets into the new buckets, if the table
+	// is being resized. Deletes the old buckets when all have been moved
+	void RehashStep( const TUInt32 iNumBuckets = kiRehashStep )
+	{
+		if (!m_aOldBuckets)
+		{
+			return;
+		}
+
+		TUInt32 iEndBucket = m_iNextOldBucket + iNumBuckets;
+		if (iEndBucket > m_iOldSize)
+		{
+			iEndBucket = m_iOldSize;
+		}
+		while (m_iNextOldBucket < iEndBucket)
 		{
-			while (aOldBuckets[iBucket].size())
+			// The list nodes themselves are moved (spliced) into the new buckets, so nothing is
+			// copied or allocated
+			TBucket& oldBucket = m_aOldBuckets[m_iNextOldBucket];
+			while (!oldBucket.empty())
 			{
-				SetKeyValue( aOldBuckets[iBucket].front().key, aOldBuckets[iBucket].front().value );
-				aOldBuckets[iBucket].pop_front(); // Delete each old key/value pair after it is copied
+				TBucket* pBucket = GetBucket( m_kHashPolicy( oldBucket.front().key ) % m_iSize );
+				pBucket->splice( pBucket->end(), oldBucket, oldBucket.begin() );
 			}
+			++m_iNextOldBucket;
 		}
 
-		delete[] aOldBuckets;
+		// Construct new buckets at the same rate as old buckets are moved, so all are constructed
+		// by the time the resize is complete
+		BuildBuckets( static_cast<TUInt32>(static_cast<TUInt64>(m_iNextOldBucket) * m_iSize /
+		                                   m_iOldSize) );
 
-		GEN_ENDGUARD;
+		if (m_iNextOldBucket == m_iOldSize)
+		{
+			EndResize();
+		}
+	}
+
+	// Finish a resize once no key/value pairs are left in the old buckets - construct any new
+	// buckets not yet constructed and delete the old buckets
+	void EndResize()
+	{
+		BuildBuckets( m_iSize );
+		delete[] m_aiBuiltBuckets;
+		m_aiBuiltBuckets = 0;
+
+		FreeBuckets( m_aOldBuckets, m_iOldSize, 0 );
+		m_aOldBuckets = 0;
+		m_iOldSize = 0;
+	}
+
+	// Immediately finish any resize in progress
+	void CompleteResize()
+	{
+		if (m_aOldBuckets)
+		{
+			RehashStep( m_iOldSize );
+		}
 	}
 
 
@@ -366,11 +671,31 @@ private:
 
 	TBucket* m_aBuckets;    // Dynamically allocated array of buckets of key/value pairs
 	TUInt32  m_iSize;       // Size (capacity) of the table - number of buckets
-	TUInt32  m_iNumEntries; // Number of key/value pairs in the table
-
-	// Hash function to use is stored as a function pointer - converts a key given as a
-	// sequence of bytes into a 4-byte unsigned integer
-	const THashFunction m_kpfHashFunction;
+	TUInt32  m_iNumEntries; // Number of key/value pairs in the table (old and new buckets)
+
+	// While the table is being resized, the old buckets are kept here until all their key/value
+	// pairs have been moved to the new buckets above. 0 when not resizing
+	TBucket* m_aOldBuckets;
+	TUInt32  m_iOldSize;       // Number of old buckets
+	TUInt32  m_iNextOldBucket; // Old buckets before this one have been moved
+
+	// While the table is being resized, not all the new buckets have been constructed. There is a
+	// bit for each new bucket here, set once it has been constructed. 0 when not resizing
+	TUInt32* m_aiBuiltBuckets;
+	TUInt32  m_iNextBuiltBucket; // New buckets before this one have been constructed
+
+#ifdef GEN_HASH_STATS
+	// Statistics counters, see HashTableStats.h
+	SHashTableCounters m_Counters;
+#endif
+
+	// Table holding the key/value pairs if flat storage was selected, otherwise 0 (and the data
+	// above is unused)
+	TFlatTable* m_pFlatTable;
+
+	// Hash policy to use - converts a key into a 4-byte unsigned integer. The default policy
+	// holds a function pointer to a hash function taking the key as a sequence of bytes
+	const THashPolicy m_kHashPolicy;
 
 	// If table becomes too full, then it is increased in size to avoid hash collisions. The max
 	// load factor defines how full it needs to be before this happens. In this implementation, the
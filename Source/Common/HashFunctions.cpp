@@ -1,17 +1,15 @@
 /**************************************************************************************************
-	Module:       CHashTable.cpp
+	Module:       HashFunctions.cpp
 	Author:       Laurent Noel
 
-	Hash table class storing keys and associated values, supporting quick lookup of a value for a
-	given a key. A hashing function is needed for the mapping and can be specified through the
-	constructor
+	Hashing functions for the hash table classes
 
 	See header file for further notes
 
 	Copyright 2007, University of Central Lancashire and Laurent Noel
 **************************************************************************************************/
 
-#include "CHashTable.h"
+#include "HashFunctions.h"
 
 namespace gen
 {
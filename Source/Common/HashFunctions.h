@@ -0,0 +1,184 @@
+/**************************************************************************************************
+	Module:       HashFunctions.h
+
+	Hashing functions for the hash table classes (CHashTable and CFlatHashTable). A hash function
+	converts a key into a 4-byte integer, which the hash tables use to decide where to store the
+	value associated with the key
+
+	The hash tables call the hash function through a "hash policy" class given as a template
+	parameter. The default policy calls a hash function through a function pointer, other policies
+	hash particular key types directly so the hashing can be inlined
+**************************************************************************************************/
+
+#ifndef GEN_HASH_FUNCTIONS_H_INCLUDED
+#define GEN_HASH_FUNCTIONS_H_INCLUDED
+
+#include <string.h>
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	Hashing functions
+ ------------------------------------------------------------------------------------------------*/
+
+// The hash map classes allow the use of different hash functions. To allow this we first define
+// a function pointer *type* for hash functions. This defines the function prototype for user-
+// provided hash functions: the parameters are a pointer to the key data (as a sequence of bytes),
+// and the length of the key data in bytes. This allows keys of any type to be hashed. The hash
+// function returns a 4-byte integer, the index to use for the value associated with the key
+typedef TUInt32 (*THashFunction)( const TUInt8* key, const TUInt32 keyLen );
+
+// Basic hashing function - simply adds up each byte in the key to give the resultant index
+TUInt32 AddUpHash( const TUInt8* pKey, const TUInt32 iKeyLen );
+
+// Jenkins one-at-a-time hashing function, a high performance hashing function with good
+// distribution of indexes (few collisions)
+TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
+
+
+// Mix the bits of a 64-bit value so every bit of the input affects every bit of the result
+// (multiply / xor-shift mixing)
+inline TUInt64 MixBits64( TUInt64 iValue )
+{
+	iValue ^= iValue >> 32;
+	iValue *= 0xd6e8feb86659fd93ULL;
+	iValue ^= iValue >> 32;
+	return iValue;
+}
+
+// Fast hashing function for keys of any length, processes the key 8 bytes at a time rather than
+// byte by byte. Distribution is as good as JOneAtATimeHash. Inline so it can be optimised for
+// keys of a fixed size, but can also be used as a THashFunction
+inline TUInt32 FastHash( const TUInt8* pKey, const TUInt32 iKeyLen )
+{
+	const TUInt64 kiMultiplier = 0x9e3779b97f4a7c15ULL; // 2^64 divided by the golden ratio
+
+	// Whole 8-byte blocks (copied out with memcpy as the key may not be aligned)
+	TUInt64 iHash = iKeyLen * kiMultiplier;
+	const TUInt8* pBlocksEnd = pKey + (iKeyLen & ~7u);
+	while (pKey != pBlocksEnd)
+	{
+		TUInt64 iBlock;
+		memcpy( &iBlock, pKey, 8 );
+		iHash = (iHash ^ MixBits64( iBlock )) * kiMultiplier;
+		pKey += 8;
+	}
+
+	// Remaining 0-7 bytes
+	TUInt64 iBlock = 0;
+	memcpy( &iBlock, pKey, iKeyLen & 7 );
+	iHash = MixBits64( (iHash ^ MixBits64( iBlock )) * kiMultiplier );
+	return static_cast<TUInt32>(iHash) ^ static_cast<TUInt32>(iHash >> 32);
+}
+
+// Multiply-shift hashing for integers - multiply by a large odd constant, then fold the top 32
+// bits of the result onto the bottom 32. The top bits depend on all the bits of the key, but the
+// hash tables use the bottom bits (for the bucket or group index), so both halves are used. A
+// single multiplication
+inline TUInt32 MultiplyShiftHash( const TUInt64 iKey )
+{
+	TUInt64 iHash = iKey * 0x9e3779b97f4a7c15ULL;
+	return static_cast<TUInt32>(iHash >> 32) ^ static_cast<TUInt32>(iHash);
+}
+
+
+/*------------------------------------------------------------------------------------------------
+	Hash policies
+ ------------------------------------------------------------------------------------------------*/
+
+// A hash policy is a class with an operator() that takes a key and returns its hash value. The
+// hash tables take the policy type as a template parameter, and an instance of it in their
+// constructor
+
+// Hash policy calling a hash function through a function pointer, passing the raw bytes of the
+// key. This is the default policy for the hash tables, and has the same restrictions on keys as
+// CHashTable always had (no pointers in keys - see CHashTable.h). The policy can be constructed
+// from a hash function, so a hash function can be given wherever the policy is expected
+template <class TKeyType>
+class CHashFunctionPolicy
+{
+public:
+	CHashFunctionPolicy( THashFunction pfHashFunction = JOneAtATimeHash )
+	: m_pfHashFunction( pfHashFunction ) {}
+
+	TUInt32 operator()( const TKeyType& key ) const
+	{
+		// Get a pointer to the key as raw bytes - this cast is OK for this kind of purpose
+		return m_pfHashFunction( reinterpret_cast<const TUInt8*>(&key), sizeof(TKeyType) );
+	}
+
+private:
+	THashFunction m_pfHashFunction;
+};
+
+
+// Hash policy for keys of the given type, calling the hash function directly so it can be
+// inlined. This general version hashes the raw bytes of plain data keys (such as structures of
+// integers and floats) with FastHash. Such keys must not contain pointers or padding bytes (which
+// may hold any value). It is specialised below for integers, pointers and strings
+template <class TKeyType>
+class CHashPolicy
+{
+public:
+	TUInt32 operator()( const TKeyType& key ) const
+	{
+		return FastHash( reinterpret_cast<const TUInt8*>(&key), sizeof(TKeyType) );
+	}
+};
+
+// Integer keys use multiply-shift hashing
+#define GEN_INTEGER_HASH_POLICY( TIntType )\
+	template <> class CHashPolicy<TIntType>\
+	{\
+	public:\
+		TUInt32 operator()( const TIntType key ) const\
+		{\
+			return MultiplyShiftHash( static_cast<TUInt64>(key) );\
+		}\
+	};
+
+GEN_INTEGER_HASH_POLICY( char )
+GEN_INTEGER_HASH_POLICY( TInt8 )
+GEN_INTEGER_HASH_POLICY( TUInt8 )
+GEN_INTEGER_HASH_POLICY( TInt16 )
+GEN_INTEGER_HASH_POLICY( TUInt16 )
+GEN_INTEGER_HASH_POLICY( TInt32 )
+GEN_INTEGER_HASH_POLICY( TUInt32 )
+GEN_INTEGER_HASH_POLICY( long )
+GEN_INTEGER_HASH_POLICY( unsigned long )
+GEN_INTEGER_HASH_POLICY( TInt64 )
+GEN_INTEGER_HASH_POLICY( TUInt64 )
+
+#undef GEN_INTEGER_HASH_POLICY
+
+// Pointer keys hash the address (not the data pointed at) with multiply-shift hashing
+template <class TPointedType>
+class CHashPolicy<TPointedType*>
+{
+public:
+	TUInt32 operator()( TPointedType* const key ) const
+	{
+		return MultiplyShiftHash( reinterpret_cast<TUInt64>(key) );
+	}
+};
+
+// String keys hash the characters of the string with FastHash
+template <>
+class CHashPolicy<string>
+{
+public:
+	TUInt32 operator()( const string& key ) const
+	{
+		return FastHash( reinterpret_cast<const TUInt8*>(key.data()), static_cast<TUInt32>(key.size()) );
+	}
+};
+
+
+} // namespace gen
+
+#endif // GEN_HASH_FUNCTIONS_H_INCLUDED
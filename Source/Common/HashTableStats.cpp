@@ -0,0 +1,184 @@
+/**************************************************************************************************
+	Module:       HashTableStats.cpp
+
+	Statistics for the hash table classes (CHashTable and CFlatHashTable), used to check the
+	efficiency of a table and its hash function while the program is running. Also a benchmark
+	measuring the tables under an entity UID workload
+**************************************************************************************************/
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "HashTableStats.h"
+#include "CHashTable.h"
+#include "CTimer.h"
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	Statistics
+ ------------------------------------------------------------------------------------------------*/
+
+// Output the given hash table statistics to the console
+void OutputHashTableStats( const SHashTableStats& stats )
+{
+	cout << "Hash Table Statistics:" << endl << endl;
+	cout << "Entries: " << stats.iNumEntries << " in " << stats.iSize
+	     << " (load factor " << stats.fLoadFactor << ")" << endl;
+	cout << "Probe length: mean " << stats.fMeanProbeLength
+	     << ", max " << stats.iMaxProbeLength << endl;
+	cout << "Resizes: " << stats.iNumResizes << endl;
+	cout << "Look-ups: " << stats.iNumLookUpHits << " hits, "
+	     << stats.iNumLookUpMisses << " misses" << endl;
+	cout << endl;
+}
+
+
+/*------------------------------------------------------------------------------------------------
+	Benchmark
+ ------------------------------------------------------------------------------------------------*/
+
+namespace
+{
+	// Hash tables measured - entity UID keys mapped to entity indexes, hashed with a function
+	// pointer or with the inline integer hash policy
+	typedef CHashTable<TUInt32, TUInt32>                         TFunctionHashTable;
+	typedef CHashTable<TUInt32, TUInt32, CHashPolicy<TUInt32> > TPolicyHashTable;
+
+	// Entity UID format, as used by the entity manager - slot index in the lower bits, generation
+	// number in the upper bits, incremented each time a slot is reused
+	const TUInt32 kiUIDIndexBits = 20;
+	const TUInt32 kiUIDGenerationMask = 0xfff;
+
+	TUInt32 MakeUID( const TUInt32 iIndex, const TUInt32 iGeneration )
+	{
+		return ((iGeneration & kiUIDGenerationMask) << kiUIDIndexBits) | iIndex;
+	}
+
+	// Results of the look-ups are written here so the compiler can't remove them
+	volatile TUInt32 viLookUpSink;
+
+
+	// Run the entity UID workload on the given hash table, see BenchmarkEntityUIDHashTables
+	template <class THashTable>
+	void RunEntityUIDBenchmark
+	(
+		THashTable&                table,
+		const TUInt32              iNumEntities,
+		const TUInt32              iNumFrames,
+		SHashTableBenchmarkResult* pResult
+	)
+	{
+		vector<TUInt32> aiUIDs( iNumEntities );
+		vector<TUInt32> aiGenerations( iNumEntities, 0 );
+
+		// Create the initial entities
+		CTimer timer;
+		timer.Start();
+		for (TUInt32 iEntity = 0; iEntity < iNumEntities; ++iEntity)
+		{
+			aiUIDs[iEntity] = MakeUID( iEntity, 0 );
+			table.SetKeyValue( aiUIDs[iEntity], iEntity );
+		}
+		pResult->fBuildTime = timer.GetLapTime();
+
+		// Each frame, 2% of the entities are destroyed and their slots reused for new ones
+		TUInt32 iNumReplaced = iNumEntities / 50 + 1;
+		TUInt32 iNextReplaced = 0;
+		TUInt32 iLookUpTotal = 0;
+		pResult->fFrameTime = 0.0f;
+		pResult->fMaxFrameTime = 0.0f;
+		for (TUInt32 iFrame = 0; iFrame < iNumFrames; ++iFrame)
+		{
+			// Look up every entity, as when sending messages or following handles
+			TUInt32 iValue;
+			for (TUInt32 iEntity = 0; iEntity < iNumEntities; ++iEntity)
+			{
+				if (table.LookUpKey( aiUIDs[iEntity], &iValue ))
+				{
+					iLookUpTotal += iValue;
+				}
+			}
+
+			// Destroy and replace some entities. Look up each destroyed UID afterwards, as a
+			// stale handle would - these look-ups miss
+			for (TUInt32 iReplace = 0; iReplace < iNumReplaced; ++iReplace)
+			{
+				TUInt32 iEntity = iNextReplaced;
+				iNextReplaced = (iNextReplaced + 1) % iNumEntities;
+
+				TUInt32 iOldUID = aiUIDs[iEntity];
+				table.RemoveKey( iOldUID );
+				aiUIDs[iEntity] = MakeUID( iEntity, ++aiGenerations[iEntity] );
+				table.SetKeyValue( aiUIDs[iEntity], iEntity );
+				if (table.LookUpKey( iOldUID, &iValue ))
+				{
+					iLookUpTotal += iValue;
+				}
+			}
+
+			TFloat32 fFrameTime = timer.GetLapTime();
+			pResult->fFrameTime += fFrameTime;
+			if (fFrameTime > pResult->fMaxFrameTime)
+			{
+				pResult->fMaxFrameTime = fFrameTime;
+			}
+		}
+		if (iNumFrames > 0)
+		{
+			pResult->fFrameTime /= iNumFrames;
+		}
+
+		viLookUpSink = iLookUpTotal;
+		table.GetStats( &pResult->stats );
+	}
+}
+
+
+// Measure the hash tables mapping entity UIDs to entities, as the entity manager would. The given
+// number of entities are added, then each frame every entity is looked up once and a few are
+// destroyed and replaced. Destroyed UIDs are also looked up, as happens with stale entity handles.
+// UIDs are built like the entity manager's: a slot index in the lower 20 bits and a generation
+// number above. Results are written to the given array, one per set-up
+void BenchmarkEntityUIDHashTables
+(
+	const TUInt32             iNumEntities,
+	const TUInt32             iNumFrames,
+	SHashTableBenchmarkResult aResults[kiNumHashTableBenchmarks]
+)
+{
+	GEN_GUARD;
+
+	GEN_ASSERT( iNumEntities > 0 && iNumEntities <= (1u << kiUIDIndexBits),
+	            "Invalid number of entities for benchmark" );
+
+	// Tables start small so the resizes while the entities are added are included
+	const TUInt32 kiInitialSize = 1024;
+	{
+		TFunctionHashTable table( kiInitialSize, JOneAtATimeHash );
+		aResults[0].sSetup = "List buckets, JOneAtATimeHash";
+		RunEntityUIDBenchmark( table, iNumEntities, iNumFrames, &aResults[0] );
+	}
+	{
+		TPolicyHashTable table( kiInitialSize );
+		aResults[1].sSetup = "List buckets, CHashPolicy<TUInt32>";
+		RunEntityUIDBenchmark( table, iNumEntities, iNumFrames, &aResults[1] );
+	}
+	{
+		TFunctionHashTable table( kiInitialSize, JOneAtATimeHash, 0.7f, kFlatStorage );
+		aResults[2].sSetup = "Flat, JOneAtATimeHash";
+		RunEntityUIDBenchmark( table, iNumEntities, iNumFrames, &aResults[2] );
+	}
+	{
+		TPolicyHashTable table( kiInitialSize, CHashPolicy<TUInt32>(), 0.7f, kFlatStorage );
+		aResults[3].sSetup = "Flat, CHashPolicy<TUInt32>";
+		RunEntityUIDBenchmark( table, iNumEntities, iNumFrames, &aResults[3] );
+	}
+
+	GEN_ENDGUARD;
+}
+
+
+} // namespace gen
@@ -0,0 +1,103 @@
+/**************************************************************************************************
+	Module:       HashTableStats.h
+
+	Statistics for the hash table classes (CHashTable and CFlatHashTable), used to check the
+	efficiency of a table and its hash function while the program is running. Also a benchmark
+	measuring the tables under an entity UID workload
+**************************************************************************************************/
+
+#ifndef GEN_HASH_TABLE_STATS_H_INCLUDED
+#define GEN_HASH_TABLE_STATS_H_INCLUDED
+
+#include "Defines.h"
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	Statistics counters
+ ------------------------------------------------------------------------------------------------*/
+
+// The hash tables count look-ups and resizes as they happen. The counters are removed in release
+// builds if user defines GEN_NO_HASH_STATS_RELEASE before this point. The other statistics are
+// measured when requested so are always available
+#if defined(_DEBUG) || !defined(GEN_NO_HASH_STATS_RELEASE)
+	#define GEN_HASH_STATS
+#endif
+
+// Wrap statements that update the counters in this macro so they are removed with the counters
+#ifdef GEN_HASH_STATS
+	#define GEN_HASH_STAT( statement ) statement
+#else
+	#define GEN_HASH_STAT( statement )
+#endif
+
+
+/*------------------------------------------------------------------------------------------------
+	Statistics
+ ------------------------------------------------------------------------------------------------*/
+
+// Statistics for a hash table, returned by the tables' GetStats functions. The probe length of a
+// key is how far a look-up must search to find it: for list buckets, the position of the key in
+// its bucket's list; for flat storage, the number of groups of slots searched. Long probes mean a
+// poor hash function (many keys with similar hash values) or an overloaded table
+struct SHashTableStats
+{
+	TUInt32  iNumEntries;      // Number of key/value pairs in the table
+	TUInt32  iSize;            // Number of buckets (list storage) or slots (flat storage)
+	TFloat32 fLoadFactor;      // Number of entries / size
+	TUInt32  iMaxProbeLength;  // Longest probe length of any key in the table
+	TFloat32 fMeanProbeLength; // Average probe length of the keys in the table - the best is 1
+
+	// Counters - all 0 if the counters are compiled out (see above)
+	TUInt32  iNumResizes;      // Times the table has grown (or been rebuilt to clear removed keys)
+	TUInt32  iNumLookUpHits;   // Look-ups that found their key
+	TUInt32  iNumLookUpMisses; // Look-ups that did not find their key
+};
+
+// Counters kept by a hash table as operations happen (if GEN_HASH_STATS is defined)
+struct SHashTableCounters
+{
+	TUInt32 iNumResizes;
+	TUInt32 iNumLookUpHits;
+	TUInt32 iNumLookUpMisses;
+};
+
+// Output the given hash table statistics to the console
+void OutputHashTableStats( const SHashTableStats& stats );
+
+
+/*------------------------------------------------------------------------------------------------
+	Benchmark
+ ------------------------------------------------------------------------------------------------*/
+
+// Result for one hash table set-up from the entity UID benchmark
+struct SHashTableBenchmarkResult
+{
+	const char*     sSetup;        // Description of the storage and hash function used
+	TFloat32        fBuildTime;    // Time to add the initial entities (seconds)
+	TFloat32        fFrameTime;    // Average time for the hash table operations in a frame (seconds)
+	TFloat32        fMaxFrameTime; // Longest time for a frame's operations (seconds) - shows resizes
+	SHashTableStats stats;         // Table statistics at the end of the benchmark
+};
+
+// Number of set-ups measured by the benchmark - list and flat storage, each using the Jenkins
+// one-at-a-time function and the inline integer hash policy
+const TUInt32 kiNumHashTableBenchmarks = 4;
+
+// Measure the hash tables mapping entity UIDs to entities, as the entity manager would. The given
+// number of entities are added, then each frame every entity is looked up once and a few are
+// destroyed and replaced. Destroyed UIDs are also looked up, as happens with stale entity handles.
+// UIDs are built like the entity manager's: a slot index in the lower 20 bits and a generation
+// number above. Results are written to the given array, one per set-up
+void BenchmarkEntityUIDHashTables
+(
+	const TUInt32             iNumEntities,
+	const TUInt32             iNumFrames,
+	SHashTableBenchmarkResult aResults[kiNumHashTableBenchmarks]
+);
+
+
+} // namespace gen
+
+#endif // GEN_HASH_TABLE_STATS_H_INCLUDED
@@ -0,0 +1,61 @@
+/**************************************************************************************************
+	Module:       StringTable.cpp
+
+	String table mapping strings to small integer symbols (string interning)
+**************************************************************************************************/
+
+#include "StringTable.h"
+
+namespace gen
+{
+
+/*---------------------------------------------------------------------------------------------
+	CStringTable class
+---------------------------------------------------------------------------------------------*/
+
+// Constructor adds the empty string as symbol 0
+CStringTable::CStringTable()
+{
+	Intern( "" );
+}
+
+
+// Return the symbol for the given string, adding the string to the table if it is new
+TSymbol CStringTable::Intern( const string& str )
+{
+	// Insert does nothing if the string is already in the map, either way it returns the entry
+	TSymbol newSymbol = static_cast<TSymbol>(m_Strings.size());
+	pair<TSymbolMapIter, bool> entry = m_Symbols.insert( TSymbolMap::value_type( str, newSymbol ) );
+	if (entry.second)
+	{
+		m_Strings.push_back( &entry.first->first );
+	}
+	return entry.first->second;
+}
+
+// Return the symbol for the given string, or NoSymbol if the string is not in the table
+TSymbol CStringTable::Find( const string& str ) const
+{
+	TSymbolMapConstIter entry = m_Symbols.find( str );
+	if (entry == m_Symbols.end())
+	{
+		return NoSymbol;
+	}
+	return entry->second;
+}
+
+
+/*------------------------------------------------------------------------------------------------
+	Name table
+ ------------------------------------------------------------------------------------------------*/
+
+// The string table shared by all names in the application. A function static is used so the
+// table exists before any global objects that use it are constructed
+CStringTable& NameTable()
+{
+	static CStringTable nameTable;
+	return nameTable;
+}
+
+
+} // namespace gen
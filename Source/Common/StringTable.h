@@ -0,0 +1,129 @@
+/**************************************************************************************************
+	Module:       StringTable.h
+
+	String table mapping strings to small integer symbols (string interning). Each distinct
+	string is stored once and identified by its symbol, so symbols can be copied and compared as
+	plain integers instead of strings. Used for entity, template and template type names
+**************************************************************************************************/
+
+#ifndef GEN_STRING_TABLE_H_INCLUDED
+#define GEN_STRING_TABLE_H_INCLUDED
+
+#include <string>
+#include <vector>
+#include <map>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+/*------------------------------------------------------------------------------------------------
+	Symbol type
+ ------------------------------------------------------------------------------------------------*/
+
+// A symbol is the index of a string in a string table. Symbols are allocated in order starting
+// from 0, so can also be used directly as array indexes
+typedef TUInt32 TSymbol;
+
+// The empty string always has symbol 0
+const TSymbol NullSymbol = 0;
+
+// Returned when looking up a string that has not been interned. Never equal to a valid symbol
+const TSymbol NoSymbol = 0xffffffff;
+
+
+/*---------------------------------------------------------------------------------------------
+	CStringTable class
+---------------------------------------------------------------------------------------------*/
+
+// The string table holds one copy of each string added to it, and gives each a symbol. Adding
+// or finding a string requires a string look-up, but getting the string for a symbol is a
+// simple array access. Strings are never removed from the table
+class CStringTable
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor adds the empty string as symbol 0
+	CStringTable();
+
+	// No destructor needed
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CStringTable( const CStringTable& );
+	CStringTable& operator=( const CStringTable& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Return the symbol for the given string, adding the string to the table if it is new
+	TSymbol Intern( const string& str );
+
+	// Return the symbol for the given string, or NoSymbol if the string is not in the table. Use
+	// for look-ups to avoid adding strings that are only searched for
+	TSymbol Find( const string& str ) const;
+
+	// Return the string for the given symbol
+	const string& GetString( TSymbol symbol ) const
+	{
+		return *m_Strings[symbol];
+	}
+
+	// Return the number of strings in the table (one more than the largest symbol)
+	TUInt32 NumSymbols() const
+	{
+		return static_cast<TUInt32>(m_Strings.size());
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Map from strings to symbols - the map holds the only copy of each string
+	typedef map<string, TSymbol> TSymbolMap;
+	typedef TSymbolMap::iterator TSymbolMapIter;
+	typedef TSymbolMap::const_iterator TSymbolMapConstIter;
+	TSymbolMap m_Symbols;
+
+	// Pointers to the strings in the map above, indexed by symbol (map keys don't move in memory)
+	vector<const string*> m_Strings;
+};
+
+
+/*------------------------------------------------------------------------------------------------
+	Name table
+ ------------------------------------------------------------------------------------------------*/
+
+// The string table shared by all names in the application (entity names, template names and
+// types). Created on first use
+CStringTable& NameTable();
+
+// Return the symbol for the given name, adding it to the name table if it is new
+inline TSymbol InternName( const string& name )
+{
+	return NameTable().Intern( name );
+}
+
+// Return the symbol for the given name, or NoSymbol if the name has never been interned
+inline TSymbol FindName( const string& name )
+{
+	return NameTable().Find( name );
+}
+
+// Return the name for the given symbol
+inline const string& NameString( TSymbol symbol )
+{
+	return NameTable().GetString( symbol );
+}
+
+
+} // namespace gen
+
+#endif // GEN_STRING_TABLE_H_INCLUDED
@@ -57,4 +57,54 @@ string LastDelimitedSubstr
 }
 
 
+// Return true if a string matches a wildcard pattern. In the pattern '*' matches any sequence of
+// characters (including none) and '?' matches any single character
+bool MatchWildcard
+(
+	const string& sPattern,
+	const string& sString
+)
+{
+	string::size_type patternPos = 0;
+	string::size_type stringPos = 0;
+
+	// Position of the last '*' seen in the pattern and the string position it was matched at. If
+	// a later part of the pattern fails to match, the '*' is extended by one character and the
+	// match continues from there (no need to go back further than the last '*')
+	string::size_type starPos = string::npos;
+	string::size_type starMatch = 0;
+
+	while (stringPos < sString.length())
+	{
+		if (patternPos < sPattern.length() &&
+		    (sPattern[patternPos] == '?' || sPattern[patternPos] == sString[stringPos]))
+		{
+			++patternPos;
+			++stringPos;
+		}
+		else if (patternPos < sPattern.length() && sPattern[patternPos] == '*')
+		{
+			starPos = patternPos++;
+			starMatch = stringPos;
+		}
+		else if (starPos != string::npos)
+		{
+			patternPos = starPos + 1;
+			stringPos = ++starMatch;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// Whole string used, any remaining pattern must be '*'s
+	while (patternPos < sPattern.length() && sPattern[patternPos] == '*')
+	{
+		++patternPos;
+	}
+	return patternPos == sPattern.length();
+}
+
+
 } // namespace gen
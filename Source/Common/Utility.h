@@ -98,6 +98,24 @@ string LastDelimitedSubstr
 );
 
 
+// Return true if a string matches a wildcard pattern. In the pattern '*' matches any sequence of
+// characters (including none) and '?' matches any single character, e.g. "Tank*" or "A?"
+bool MatchWildcard
+(
+	const string& sPattern,
+	const string& sString
+);
+
+// Return true if a string contains wildcard characters (see MatchWildcard)
+inline bool HasWildcards
+(
+	const string& sPattern
+)
+{
+	return sPattern.find_first_of( "*?" ) != string::npos;
+}
+
+
 } // namespace gen
 
 #endif // GEN_UTILITY_H_INCLUDED
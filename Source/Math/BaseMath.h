@@ -33,14 +33,14 @@ namespace gen
 	Mathematical constants
 -----------------------------------------------------------------------------------------*/
 
-const TFloat32 kfPi = 3.1415926535897932384626433832795f;
-const TFloat64 kfPi64 = 3.1415926535897932384626433832795;
+constexpr TFloat32 kfPi = 3.1415926535897932384626433832795f;
+constexpr TFloat64 kfPi64 = 3.1415926535897932384626433832795;
 
 // Default epsilon values (margin of error for approximations), suitable for values known
 // to be around 1.0. Provided for convenience, read the extensive commentary below regarding
 // floating point approximation before considering if these values are appropriate
-const TFloat32 kfEpsilon = 0.5e-6f;    // For 32-bit floats
-const TFloat64 kfEpsilon64 = 0.5e-15f; // For 64-bit floats
+constexpr TFloat32 kfEpsilon = 0.5e-6f;    // For 32-bit floats
+constexpr TFloat64 kfEpsilon64 = 0.5e-15f; // For 64-bit floats
 
 
 /*-----------------------------------------------------------------------------------------
@@ -207,46 +207,160 @@ inline void SinCos
 }
 
 
+/*-----------------------------------------------------------------------------------------
+	Fast approximations
+-----------------------------------------------------------------------------------------*/
+// Faster, less accurate versions of the functions above for use in code called many times per
+// frame, such as AI steering and facing tests. They contain no library calls and no branches
+// that depend on the input other than simple selects, so loops over them can be vectorised by the
+// compiler. Maximum errors are given for each function, measured over the stated input range
+// against the exact versions (see BenchmarkFastMath in MathBenchmark.h)
+
+// Approximate 1 / Sqrt for x > 0, using an integer approximation of the float's logarithm
+// refined with two Newton-Raphson steps. Maximum relative error 5e-6
+inline TFloat32 FastInvSqrt( const TFloat32 x )
+{
+	union { TFloat32 f; TUInt32 i; } bits;
+	bits.f = x;
+	bits.i = 0x5f375a86 - (bits.i >> 1);
+	TFloat32 y = bits.f;
+	TFloat32 halfX = 0.5f * x;
+	y = y * (1.5f - halfX * y * y);
+	y = y * (1.5f - halfX * y * y);
+	return y;
+}
+
+// Approximate Sqrt for x >= 0, as x * FastInvSqrt(x). Returns 0 for x = 0. Maximum relative
+// error 5e-6
+inline TFloat32 FastSqrt( const TFloat32 x )
+{
+	return x > 0.0f ? x * FastInvSqrt( x ) : 0.0f;
+}
+
+// Return the angle x (radians) reduced to the range [-pi,pi]. Precision is lost for very large
+// x, the result is within 1e-6 of the exact value for |x| < 100
+inline TFloat32 ReduceAngle( const TFloat32 x )
+{
+	// The multiple of 2pi is subtracted in two parts for precision, the first is exact in a float
+	TFloat32 k = Floor( x * (0.5f / kfPi) + 0.5f );
+	return (x - k * 6.28125f) - k * 1.9353071795864769e-3f;
+}
+
+// Approximate Sin for any x (radians), see ReduceAngle for precision of large x. Maximum absolute
+// error 3e-7 for |x| < 100
+inline TFloat32 FastSin( TFloat32 x )
+{
+	// Reduce to [-pi,pi], then reflect into [-pi/2,pi/2] using sin(x) = sin(pi - x)
+	x = ReduceAngle( x );
+	TFloat32 halfPi = 0.5f * kfPi;
+	x = (x > halfPi) ? kfPi - x : ((x < -halfPi) ? -kfPi - x : x);
+
+	// Taylor series to the x^11 term
+	TFloat32 x2 = x * x;
+	return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f +
+	            x2 * (2.7557319e-6f - x2 * 2.5052108e-8f)))));
+}
+
+// Approximate Cos for any x (radians), as FastSin(x + pi/2) - x is reduced first so the addition
+// doesn't lose precision. Maximum absolute error 5e-7 for |x| < 100
+inline TFloat32 FastCos( const TFloat32 x )
+{
+	return FastSin( ReduceAngle( x ) + 0.5f * kfPi );
+}
+
+// Get approximate sin and cos of x, see FastSin and FastCos
+inline void FastSinCos
+(
+	TFloat32  x,
+	TFloat32* pSin,
+	TFloat32* pCos
+)
+{
+	*pSin = FastSin( x );
+	*pCos = FastCos( x );
+}
+
+// Approximate ACos (radians). x is clamped to [-1,1], so small rounding errors outside that range
+// (e.g. the dot product of two normalised vectors) give 0 or pi rather than an invalid result.
+// Uses Abramowitz & Stegun 4.4.46. Maximum absolute error 1e-5 radians
+inline TFloat32 FastACos( TFloat32 x )
+{
+	x = (x > 1.0f) ? 1.0f : ((x < -1.0f) ? -1.0f : x);
+	TFloat32 a = Abs( x );
+	TFloat32 r = -1.2624911e-3f;
+	r = r * a + 6.6700901e-3f;
+	r = r * a - 1.70881256e-2f;
+	r = r * a + 3.08918810e-2f;
+	r = r * a - 5.01743046e-2f;
+	r = r * a + 8.89789874e-2f;
+	r = r * a - 2.145988016e-1f;
+	r = r * a + 1.5707963050f;
+	r *= FastSqrt( 1.0f - a );
+	return (x < 0.0f) ? kfPi - r : r;
+}
+
+// Approximate ATan of y / x (radians), giving a result in [-pi,pi] using the signs of x and y,
+// same parameter order as ATan( y, x ). Returns 0 if both are 0. Maximum absolute error 3e-6
+// radians
+inline TFloat32 FastATan( const TFloat32 y, const TFloat32 x )
+{
+	TFloat32 absX = Abs( x );
+	TFloat32 absY = Abs( y );
+	TFloat32 maxXY = (absX > absY) ? absX : absY;
+	TFloat32 minXY = (absX > absY) ? absY : absX;
+	TFloat32 a = (maxXY > 0.0f) ? minXY / maxXY : 0.0f;
+
+	// Polynomial for atan(a) with a in [0,1] (Hastings), then use the octant to get the full
+	// angle
+	TFloat32 s = a * a;
+	TFloat32 r = a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f +
+	             s * (0.05265332f - s * 0.01172120f)))));
+	r = (absY > absX) ? 0.5f * kfPi - r : r;
+	r = (x < 0.0f) ? kfPi - r : r;
+	return (y < 0.0f) ? -r : r;
+}
+
+
 /*-----------------------------------------------------------------------------------------
 	Angle conversion functions
 -----------------------------------------------------------------------------------------*/
 
 // Convert radians to degrees
-inline TFloat32 ToDegrees( const TFloat32 r )
+constexpr TFloat32 ToDegrees( const TFloat32 r )
 {
 	return (r * 180.0f) / kfPi;
 }
 
 // Convert radians to degrees
-inline TFloat64 ToDegrees( const TFloat64 r )
+constexpr TFloat64 ToDegrees( const TFloat64 r )
 {
 	return (r * 180.0) / kfPi64;
 }
 
 // Convert radians to degrees
-inline TFloat32 ToDegrees( const TInt32 r ) { return ToDegrees(static_cast<TFloat32>(r)); }
+constexpr TFloat32 ToDegrees( const TInt32 r ) { return ToDegrees(static_cast<TFloat32>(r)); }
 
 // Convert radians to degrees
-inline TFloat64 ToDegrees( const TInt64 r ) { return ToDegrees(static_cast<TFloat64>(r)); }
+constexpr TFloat64 ToDegrees( const TInt64 r ) { return ToDegrees(static_cast<TFloat64>(r)); }
 
 
 // Convert degrees to radians
-inline TFloat32 ToRadians( const TFloat32 d )
+constexpr TFloat32 ToRadians( const TFloat32 d )
 {
 	return (d * kfPi) / 180.0f;
 }
 
 // Convert degrees to radians
-inline TFloat64 ToRadians( const TFloat64 d )
+constexpr TFloat64 ToRadians( const TFloat64 d )
 {
 	return (d * kfPi64) / 180.0;
 }
 
 // Convert degrees to radians
-inline TFloat32 ToRadians( const TInt32 d ) { return ToRadians(static_cast<TFloat32>(d)); }
+constexpr TFloat32 ToRadians( const TInt32 d ) { return ToRadians(static_cast<TFloat32>(d)); }
 
 // Convert degrees to radians
-inline TFloat64 ToRadians( const TInt64 d ) { return ToRadians(static_cast<TFloat64>(d)); }
+constexpr TFloat64 ToRadians( const TInt64 d ) { return ToRadians(static_cast<TFloat64>(d)); }
 
 
 /*-----------------------------------------------------------------------------------------
@@ -0,0 +1,668 @@
+/**************************************************************************************************
+	Module:       BatchKernels.cpp
+
+	Reference and SSE versions of the batch vector kernels, and validation of the selected
+	kernels against the reference versions
+**************************************************************************************************/
+
+#include <vector>
+using namespace std;
+
+#include "BatchKernels.h"
+#include "BaseMath.h"
+
+namespace gen
+{
+
+// Return a pointer to the vector at the given index in an AoS array with the given stride
+static inline const TFloat32* VectorAt( const void* pVectors, TUInt32 iStride, TUInt32 iIndex )
+{
+	return reinterpret_cast<const TFloat32*>(static_cast<const TUInt8*>(pVectors) + iIndex * iStride);
+}
+static inline TFloat32* VectorAt( void* pVectors, TUInt32 iStride, TUInt32 iIndex )
+{
+	return reinterpret_cast<TFloat32*>(static_cast<TUInt8*>(pVectors) + iIndex * iStride);
+}
+
+// Return SoA arrays starting at the given index in other SoA arrays
+static inline SVector3Arrays ArraysFrom( const SVector3Arrays& arrays, TUInt32 iIndex )
+{
+	SVector3Arrays offsetArrays = { arrays.x + iIndex, arrays.y + iIndex, arrays.z + iIndex };
+	return offsetArrays;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Reference kernels
+-----------------------------------------------------------------------------------------*/
+
+// Transform points by a matrix
+void Vector3TransformPointsRef( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		Matrix4x4TransformPointRef( afM, VectorAt( pIn, iInStride, i ), VectorAt( pOut, iOutStride, i ) );
+	}
+}
+
+// Transform vectors by a matrix
+void Vector3TransformVectorsRef( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                 void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		Matrix4x4TransformVectorRef( afM, VectorAt( pIn, iInStride, i ), VectorAt( pOut, iOutStride, i ) );
+	}
+}
+
+// Normalise vectors in place
+void Vector3NormaliseRef( void* pVectors, TUInt32 iStride, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		TFloat32* v = VectorAt( pVectors, iStride, i );
+		TFloat32 lengthSq = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+		if (IsZero( lengthSq ))
+		{
+			v[0] = v[1] = v[2] = 0.0f;
+		}
+		else
+		{
+			TFloat32 invLength = InvSqrt( lengthSq );
+			v[0] *= invLength;
+			v[1] *= invLength;
+			v[2] *= invLength;
+		}
+	}
+}
+
+// Dot products of pairs of vectors
+void Vector3DotRef( const void* pA, TUInt32 iStrideA, const void* pB, TUInt32 iStrideB,
+                    TFloat32* afOut, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		const TFloat32* a = VectorAt( pA, iStrideA, i );
+		const TFloat32* b = VectorAt( pB, iStrideB, i );
+		afOut[i] = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+	}
+}
+
+// Lengths of vectors
+void Vector3LengthRef( const void* pVectors, TUInt32 iStride, TFloat32* afOut, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		const TFloat32* v = VectorAt( pVectors, iStride, i );
+		afOut[i] = Sqrt( v[0]*v[0] + v[1]*v[1] + v[2]*v[2] );
+	}
+}
+
+// Bounds and largest length of points
+void Vector3BoundsRef( const void* pVectors, TUInt32 iStride, TUInt32 iCount,
+                       TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength )
+{
+	const TFloat32* v = VectorAt( pVectors, iStride, 0 );
+	TFloat32 maxLengthSq = 0.0f;
+	for (TUInt32 axis = 0; axis < 3; ++axis)
+	{
+		afMin[axis] = afMax[axis] = v[axis];
+	}
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		v = VectorAt( pVectors, iStride, i );
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			afMin[axis] = Min( afMin[axis], v[axis] );
+			afMax[axis] = Max( afMax[axis], v[axis] );
+		}
+		maxLengthSq = Max( maxLengthSq, v[0]*v[0] + v[1]*v[1] + v[2]*v[2] );
+	}
+	if (pfMaxLength)
+	{
+		*pfMaxLength = Sqrt( maxLengthSq );
+	}
+}
+
+
+// Transform SoA points by a matrix
+void Vector3TransformPointsSoARef( const TFloat32* afM, const SVector3Arrays& in,
+                                   const SVector3Arrays& out, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		TFloat32 x = in.x[i], y = in.y[i], z = in.z[i];
+		out.x[i] = x*afM[0] + y*afM[4] + z*afM[8]  + afM[12];
+		out.y[i] = x*afM[1] + y*afM[5] + z*afM[9]  + afM[13];
+		out.z[i] = x*afM[2] + y*afM[6] + z*afM[10] + afM[14];
+	}
+}
+
+// Transform SoA vectors by a matrix
+void Vector3TransformVectorsSoARef( const TFloat32* afM, const SVector3Arrays& in,
+                                    const SVector3Arrays& out, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		TFloat32 x = in.x[i], y = in.y[i], z = in.z[i];
+		out.x[i] = x*afM[0] + y*afM[4] + z*afM[8];
+		out.y[i] = x*afM[1] + y*afM[5] + z*afM[9];
+		out.z[i] = x*afM[2] + y*afM[6] + z*afM[10];
+	}
+}
+
+// Normalise SoA vectors in place
+void Vector3NormaliseSoARef( const SVector3Arrays& vectors, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		TFloat32 lengthSq = vectors.x[i]*vectors.x[i] + vectors.y[i]*vectors.y[i] +
+		                    vectors.z[i]*vectors.z[i];
+		TFloat32 invLength = IsZero( lengthSq ) ? 0.0f : InvSqrt( lengthSq );
+		vectors.x[i] *= invLength;
+		vectors.y[i] *= invLength;
+		vectors.z[i] *= invLength;
+	}
+}
+
+// Dot products of pairs of SoA vectors
+void Vector3DotSoARef( const SVector3Arrays& a, const SVector3Arrays& b, TFloat32* afOut,
+                       TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		afOut[i] = a.x[i]*b.x[i] + a.y[i]*b.y[i] + a.z[i]*b.z[i];
+	}
+}
+
+// Lengths of SoA vectors
+void Vector3LengthSoARef( const SVector3Arrays& vectors, TFloat32* afOut, TUInt32 iCount )
+{
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		afOut[i] = Sqrt( vectors.x[i]*vectors.x[i] + vectors.y[i]*vectors.y[i] +
+		                 vectors.z[i]*vectors.z[i] );
+	}
+}
+
+// Bounds and largest length of SoA points
+void Vector3BoundsSoARef( const SVector3Arrays& vectors, TUInt32 iCount,
+                          TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength )
+{
+	afMin[0] = afMax[0] = vectors.x[0];
+	afMin[1] = afMax[1] = vectors.y[0];
+	afMin[2] = afMax[2] = vectors.z[0];
+	TFloat32 maxLengthSq = 0.0f;
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		afMin[0] = Min( afMin[0], vectors.x[i] );
+		afMin[1] = Min( afMin[1], vectors.y[i] );
+		afMin[2] = Min( afMin[2], vectors.z[i] );
+		afMax[0] = Max( afMax[0], vectors.x[i] );
+		afMax[1] = Max( afMax[1], vectors.y[i] );
+		afMax[2] = Max( afMax[2], vectors.z[i] );
+		maxLengthSq = Max( maxLengthSq, vectors.x[i]*vectors.x[i] + vectors.y[i]*vectors.y[i] +
+		                                vectors.z[i]*vectors.z[i] );
+	}
+	if (pfMaxLength)
+	{
+		*pfMaxLength = Sqrt( maxLengthSq );
+	}
+}
+
+
+#ifdef GEN_MATH_SSE
+
+/*-----------------------------------------------------------------------------------------
+	SSE kernels
+-----------------------------------------------------------------------------------------*/
+
+// Load the three floats of a vector, with 0 in the 4th element. Doesn't read past the 3rd float
+static inline __m128 LoadXYZ( const TFloat32* afV )
+{
+	__m128 xy = _mm_loadl_pi( _mm_setzero_ps(), reinterpret_cast<const __m64*>(afV) );
+	return _mm_movelh_ps( xy, _mm_load_ss( afV + 2 ) );
+}
+
+// Store the first three elements of an SSE vector
+static inline void StoreXYZ( TFloat32* afV, __m128 v )
+{
+	_mm_storel_pi( reinterpret_cast<__m64*>(afV), v );
+	_mm_store_ss( afV + 2, _mm_movehl_ps( v, v ) );
+}
+
+// Load four AoS vectors and return their x, y and z elements in separate SSE vectors
+static inline void LoadFourXYZ( const void* pVectors, TUInt32 iStride, TUInt32 iFirst,
+                                __m128& x, __m128& y, __m128& z )
+{
+	__m128 v0 = LoadXYZ( VectorAt( pVectors, iStride, iFirst ) );
+	__m128 v1 = LoadXYZ( VectorAt( pVectors, iStride, iFirst + 1 ) );
+	__m128 v2 = LoadXYZ( VectorAt( pVectors, iStride, iFirst + 2 ) );
+	__m128 v3 = LoadXYZ( VectorAt( pVectors, iStride, iFirst + 3 ) );
+	_MM_TRANSPOSE4_PS( v0, v1, v2, v3 );
+	x = v0;
+	y = v1;
+	z = v2;
+}
+
+// Return the smallest or largest of the four elements of v
+static inline TFloat32 HorizontalMinSSE( __m128 v )
+{
+	v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_cvtss_f32( _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1,0,3,2) ) ) );
+}
+static inline TFloat32 HorizontalMaxSSE( __m128 v )
+{
+	v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_cvtss_f32( _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1,0,3,2) ) ) );
+}
+
+// Return v normalised, or zero if its squared length is nearly zero (as IsZero). Inputs are passed
+// by reference, 32-bit Visual C++ can't pass more than three __m128 parameters by value
+static inline __m128 NormaliseSSE( const __m128& x, const __m128& y, const __m128& z,
+                                   const __m128& lengthSq, __m128& outY, __m128& outZ )
+{
+	__m128 nonZero = _mm_cmpge_ps( lengthSq, _mm_set1_ps( kfEpsilon ) );
+	__m128 invLength = _mm_and_ps( _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( lengthSq ) ), nonZero );
+	outY = _mm_mul_ps( y, invLength );
+	outZ = _mm_mul_ps( z, invLength );
+	return _mm_mul_ps( x, invLength );
+}
+
+
+// Transform points by a matrix. Each point is the sum of the matrix rows scaled by its elements
+void Vector3TransformPointsSSE( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	__m128 r0 = _mm_loadu_ps( afM );
+	__m128 r1 = _mm_loadu_ps( afM + 4 );
+	__m128 r2 = _mm_loadu_ps( afM + 8 );
+	__m128 r3 = _mm_loadu_ps( afM + 12 );
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		const TFloat32* p = VectorAt( pIn, iInStride, i );
+		__m128 sum = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( p[0] ), r0 ), r3 );
+		sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( p[1] ), r1 ) );
+		sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( p[2] ), r2 ) );
+		StoreXYZ( VectorAt( pOut, iOutStride, i ), sum );
+	}
+}
+
+// Transform vectors by a matrix
+void Vector3TransformVectorsSSE( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                 void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	__m128 r0 = _mm_loadu_ps( afM );
+	__m128 r1 = _mm_loadu_ps( afM + 4 );
+	__m128 r2 = _mm_loadu_ps( afM + 8 );
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		const TFloat32* v = VectorAt( pIn, iInStride, i );
+		__m128 sum = _mm_mul_ps( _mm_set1_ps( v[0] ), r0 );
+		sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( v[1] ), r1 ) );
+		sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( v[2] ), r2 ) );
+		StoreXYZ( VectorAt( pOut, iOutStride, i ), sum );
+	}
+}
+
+// Normalise vectors in place, four at a time
+void Vector3NormaliseSSE( void* pVectors, TUInt32 iStride, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x, y, z;
+		LoadFourXYZ( pVectors, iStride, i, x, y, z );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		x = NormaliseSSE( x, y, z, lengthSq, y, z );
+
+		// Transpose back to four vectors
+		__m128 w = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS( x, y, z, w );
+		StoreXYZ( VectorAt( pVectors, iStride, i ), x );
+		StoreXYZ( VectorAt( pVectors, iStride, i + 1 ), y );
+		StoreXYZ( VectorAt( pVectors, iStride, i + 2 ), z );
+		StoreXYZ( VectorAt( pVectors, iStride, i + 3 ), w );
+	}
+	Vector3NormaliseRef( VectorAt( pVectors, iStride, i ), iStride, iCount - i );
+}
+
+// Dot products of pairs of vectors, four at a time
+void Vector3DotSSE( const void* pA, TUInt32 iStrideA, const void* pB, TUInt32 iStrideB,
+                    TFloat32* afOut, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 ax, ay, az, bx, by, bz;
+		LoadFourXYZ( pA, iStrideA, i, ax, ay, az );
+		LoadFourXYZ( pB, iStrideB, i, bx, by, bz );
+		__m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ),
+		                         _mm_mul_ps( az, bz ) );
+		_mm_storeu_ps( afOut + i, dot );
+	}
+	Vector3DotRef( VectorAt( pA, iStrideA, i ), iStrideA, VectorAt( pB, iStrideB, i ), iStrideB,
+	               afOut + i, iCount - i );
+}
+
+// Lengths of vectors, four at a time
+void Vector3LengthSSE( const void* pVectors, TUInt32 iStride, TFloat32* afOut, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x, y, z;
+		LoadFourXYZ( pVectors, iStride, i, x, y, z );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		_mm_storeu_ps( afOut + i, _mm_sqrt_ps( lengthSq ) );
+	}
+	Vector3LengthRef( VectorAt( pVectors, iStride, i ), iStride, afOut + i, iCount - i );
+}
+
+// Bounds and largest length of points. Four points are compared at a time, with separate
+// minimums and maximums kept for each of the four, then combined at the end
+void Vector3BoundsSSE( const void* pVectors, TUInt32 iStride, TUInt32 iCount,
+                       TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength )
+{
+	// Start from the bounds of the points that don't fill a group of four
+	TUInt32 iNumGroups = iCount / 4;
+	TUInt32 iRemainder = iCount - iNumGroups * 4;
+	TFloat32 maxLength;
+	Vector3BoundsRef( VectorAt( pVectors, iStride, iNumGroups * 4 - (iRemainder ? 0 : 4) ), iStride,
+	                  iRemainder ? iRemainder : 4, afMin, afMax, &maxLength );
+
+	__m128 minX = _mm_set1_ps( afMin[0] ), minY = _mm_set1_ps( afMin[1] ), minZ = _mm_set1_ps( afMin[2] );
+	__m128 maxX = _mm_set1_ps( afMax[0] ), maxY = _mm_set1_ps( afMax[1] ), maxZ = _mm_set1_ps( afMax[2] );
+	__m128 maxLengthSq = _mm_set1_ps( maxLength * maxLength );
+	for (TUInt32 i = 0; i < iNumGroups * 4; i += 4)
+	{
+		__m128 x, y, z;
+		LoadFourXYZ( pVectors, iStride, i, x, y, z );
+		minX = _mm_min_ps( minX, x );
+		minY = _mm_min_ps( minY, y );
+		minZ = _mm_min_ps( minZ, z );
+		maxX = _mm_max_ps( maxX, x );
+		maxY = _mm_max_ps( maxY, y );
+		maxZ = _mm_max_ps( maxZ, z );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		maxLengthSq = _mm_max_ps( maxLengthSq, lengthSq );
+	}
+
+	afMin[0] = HorizontalMinSSE( minX );
+	afMin[1] = HorizontalMinSSE( minY );
+	afMin[2] = HorizontalMinSSE( minZ );
+	afMax[0] = HorizontalMaxSSE( maxX );
+	afMax[1] = HorizontalMaxSSE( maxY );
+	afMax[2] = HorizontalMaxSSE( maxZ );
+	if (pfMaxLength)
+	{
+		*pfMaxLength = Sqrt( HorizontalMaxSSE( maxLengthSq ) );
+	}
+}
+
+
+// Transform SoA points by a matrix, four at a time
+void Vector3TransformPointsSoASSE( const TFloat32* afM, const SVector3Arrays& in,
+                                   const SVector3Arrays& out, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x = _mm_loadu_ps( in.x + i );
+		__m128 y = _mm_loadu_ps( in.y + i );
+		__m128 z = _mm_loadu_ps( in.z + i );
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			__m128 result = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( afM[axis] ) ),
+			                            _mm_mul_ps( y, _mm_set1_ps( afM[4 + axis] ) ) );
+			result = _mm_add_ps( result, _mm_mul_ps( z, _mm_set1_ps( afM[8 + axis] ) ) );
+			result = _mm_add_ps( result, _mm_set1_ps( afM[12 + axis] ) );
+			_mm_storeu_ps( (axis == 0 ? out.x : axis == 1 ? out.y : out.z) + i, result );
+		}
+	}
+	Vector3TransformPointsSoARef( afM, ArraysFrom( in, i ), ArraysFrom( out, i ), iCount - i );
+}
+
+// Transform SoA vectors by a matrix, four at a time
+void Vector3TransformVectorsSoASSE( const TFloat32* afM, const SVector3Arrays& in,
+                                    const SVector3Arrays& out, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x = _mm_loadu_ps( in.x + i );
+		__m128 y = _mm_loadu_ps( in.y + i );
+		__m128 z = _mm_loadu_ps( in.z + i );
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			__m128 result = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( afM[axis] ) ),
+			                            _mm_mul_ps( y, _mm_set1_ps( afM[4 + axis] ) ) );
+			result = _mm_add_ps( result, _mm_mul_ps( z, _mm_set1_ps( afM[8 + axis] ) ) );
+			_mm_storeu_ps( (axis == 0 ? out.x : axis == 1 ? out.y : out.z) + i, result );
+		}
+	}
+	Vector3TransformVectorsSoARef( afM, ArraysFrom( in, i ), ArraysFrom( out, i ), iCount - i );
+}
+
+// Normalise SoA vectors in place, four at a time
+void Vector3NormaliseSoASSE( const SVector3Arrays& vectors, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x = _mm_loadu_ps( vectors.x + i );
+		__m128 y = _mm_loadu_ps( vectors.y + i );
+		__m128 z = _mm_loadu_ps( vectors.z + i );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		x = NormaliseSSE( x, y, z, lengthSq, y, z );
+		_mm_storeu_ps( vectors.x + i, x );
+		_mm_storeu_ps( vectors.y + i, y );
+		_mm_storeu_ps( vectors.z + i, z );
+	}
+	Vector3NormaliseSoARef( ArraysFrom( vectors, i ), iCount - i );
+}
+
+// Dot products of pairs of SoA vectors, four at a time
+void Vector3DotSoASSE( const SVector3Arrays& a, const SVector3Arrays& b, TFloat32* afOut,
+                       TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 dot = _mm_mul_ps( _mm_loadu_ps( a.x + i ), _mm_loadu_ps( b.x + i ) );
+		dot = _mm_add_ps( dot, _mm_mul_ps( _mm_loadu_ps( a.y + i ), _mm_loadu_ps( b.y + i ) ) );
+		dot = _mm_add_ps( dot, _mm_mul_ps( _mm_loadu_ps( a.z + i ), _mm_loadu_ps( b.z + i ) ) );
+		_mm_storeu_ps( afOut + i, dot );
+	}
+	Vector3DotSoARef( ArraysFrom( a, i ), ArraysFrom( b, i ), afOut + i, iCount - i );
+}
+
+// Lengths of SoA vectors, four at a time
+void Vector3LengthSoASSE( const SVector3Arrays& vectors, TFloat32* afOut, TUInt32 iCount )
+{
+	TUInt32 i = 0;
+	for (; i + 4 <= iCount; i += 4)
+	{
+		__m128 x = _mm_loadu_ps( vectors.x + i );
+		__m128 y = _mm_loadu_ps( vectors.y + i );
+		__m128 z = _mm_loadu_ps( vectors.z + i );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		_mm_storeu_ps( afOut + i, _mm_sqrt_ps( lengthSq ) );
+	}
+	Vector3LengthSoARef( ArraysFrom( vectors, i ), afOut + i, iCount - i );
+}
+
+// Bounds and largest length of SoA points, four at a time as the AoS version
+void Vector3BoundsSoASSE( const SVector3Arrays& vectors, TUInt32 iCount,
+                          TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength )
+{
+	TUInt32 iNumGroups = iCount / 4;
+	TUInt32 iRemainder = iCount - iNumGroups * 4;
+	TFloat32 maxLength;
+	Vector3BoundsSoARef( ArraysFrom( vectors, iNumGroups * 4 - (iRemainder ? 0 : 4) ),
+	                     iRemainder ? iRemainder : 4, afMin, afMax, &maxLength );
+
+	__m128 minX = _mm_set1_ps( afMin[0] ), minY = _mm_set1_ps( afMin[1] ), minZ = _mm_set1_ps( afMin[2] );
+	__m128 maxX = _mm_set1_ps( afMax[0] ), maxY = _mm_set1_ps( afMax[1] ), maxZ = _mm_set1_ps( afMax[2] );
+	__m128 maxLengthSq = _mm_set1_ps( maxLength * maxLength );
+	for (TUInt32 i = 0; i < iNumGroups * 4; i += 4)
+	{
+		__m128 x = _mm_loadu_ps( vectors.x + i );
+		__m128 y = _mm_loadu_ps( vectors.y + i );
+		__m128 z = _mm_loadu_ps( vectors.z + i );
+		minX = _mm_min_ps( minX, x );
+		minY = _mm_min_ps( minY, y );
+		minZ = _mm_min_ps( minZ, z );
+		maxX = _mm_max_ps( maxX, x );
+		maxY = _mm_max_ps( maxY, y );
+		maxZ = _mm_max_ps( maxZ, z );
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+		                              _mm_mul_ps( z, z ) );
+		maxLengthSq = _mm_max_ps( maxLengthSq, lengthSq );
+	}
+
+	afMin[0] = HorizontalMinSSE( minX );
+	afMin[1] = HorizontalMinSSE( minY );
+	afMin[2] = HorizontalMinSSE( minZ );
+	afMax[0] = HorizontalMaxSSE( maxX );
+	afMax[1] = HorizontalMaxSSE( maxY );
+	afMax[2] = HorizontalMaxSSE( maxZ );
+	if (pfMaxLength)
+	{
+		*pfMaxLength = Sqrt( HorizontalMaxSSE( maxLengthSq ) );
+	}
+}
+
+#endif // GEN_MATH_SSE
+
+
+/*-----------------------------------------------------------------------------------------
+	Validation
+-----------------------------------------------------------------------------------------*/
+
+// Return the largest difference between two arrays of results, relative to the size of the
+// reference results (or absolute for results smaller than 1)
+static TFloat32 MaxRelativeError( const TFloat32* afResult, const TFloat32* afRef,
+                                  const TUInt32 iCount )
+{
+	TFloat32 fScale = 1.0f;
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		fScale = Max( fScale, Abs( afRef[i] ) );
+	}
+	TFloat32 fError = 0.0f;
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		fError = Max( fError, Abs( afResult[i] - afRef[i] ) / fScale );
+	}
+	return fError;
+}
+
+// Compare the selected kernels against the reference kernels on random vectors
+TFloat32 ValidateBatchKernels( const TUInt32 iNumVectors )
+{
+#ifdef GEN_MATH_SSE
+	if (iNumVectors == 0)
+	{
+		return 0.0f;
+	}
+
+	// Random matrix, and random vectors in both layouts. The AoS vectors have a stride of 5 floats
+	// to test vertex-like data. One vector is zero length to test normalisation of it
+	const TUInt32 kStride = 5 * sizeof(TFloat32);
+	TFloat32 afM[16];
+	for (TUInt32 i = 0; i < 16; ++i)
+	{
+		afM[i] = Random( -10.0f, 10.0f );
+	}
+	vector<TFloat32> aos( iNumVectors * 5 ), soa( iNumVectors * 3 );
+	for (TUInt32 i = 0; i < iNumVectors * 5; ++i)
+	{
+		aos[i] = Random( -10.0f, 10.0f );
+	}
+	aos[0] = aos[1] = aos[2] = 0.0f;
+	for (TUInt32 i = 0; i < iNumVectors; ++i)
+	{
+		soa[i] = aos[i * 5];
+		soa[iNumVectors + i] = aos[i * 5 + 1];
+		soa[iNumVectors * 2 + i] = aos[i * 5 + 2];
+	}
+	SVector3Arrays soaIn = { &soa[0], &soa[iNumVectors], &soa[iNumVectors * 2] };
+
+	// Outputs - AoS results are written packed (stride 12) to test different strides
+	vector<TFloat32> out( iNumVectors * 3 ), ref( iNumVectors * 3 );
+	SVector3Arrays soaOut = { &out[0], &out[iNumVectors], &out[iNumVectors * 2] };
+	SVector3Arrays soaRef = { &ref[0], &ref[iNumVectors], &ref[iNumVectors * 2] };
+	const TUInt32 kOutStride = 3 * sizeof(TFloat32);
+
+	TFloat32 fMaxError = 0.0f;
+	Vector3TransformPointsSSE( afM, &aos[0], kStride, &out[0], kOutStride, iNumVectors );
+	Vector3TransformPointsRef( afM, &aos[0], kStride, &ref[0], kOutStride, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors * 3 ) );
+
+	Vector3TransformVectorsSSE( afM, &aos[0], kStride, &out[0], kOutStride, iNumVectors );
+	Vector3TransformVectorsRef( afM, &aos[0], kStride, &ref[0], kOutStride, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors * 3 ) );
+
+	Vector3DotSSE( &aos[0], kStride, &aos[1], kStride, &out[0], iNumVectors );
+	Vector3DotRef( &aos[0], kStride, &aos[1], kStride, &ref[0], iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors ) );
+
+	Vector3LengthSSE( &aos[0], kStride, &out[0], iNumVectors );
+	Vector3LengthRef( &aos[0], kStride, &ref[0], iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors ) );
+
+	TFloat32 afBounds[7], afBoundsRef[7];
+	Vector3BoundsSSE( &aos[0], kStride, iNumVectors, afBounds, afBounds + 3, afBounds + 6 );
+	Vector3BoundsRef( &aos[0], kStride, iNumVectors, afBoundsRef, afBoundsRef + 3, afBoundsRef + 6 );
+	fMaxError = Max( fMaxError, MaxRelativeError( afBounds, afBoundsRef, 7 ) );
+
+	Vector3TransformPointsSoASSE( afM, soaIn, soaOut, iNumVectors );
+	Vector3TransformPointsSoARef( afM, soaIn, soaRef, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors * 3 ) );
+
+	Vector3TransformVectorsSoASSE( afM, soaIn, soaOut, iNumVectors );
+	Vector3TransformVectorsSoARef( afM, soaIn, soaRef, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors * 3 ) );
+
+	Vector3DotSoASSE( soaIn, soaIn, &out[0], iNumVectors );
+	Vector3DotSoARef( soaIn, soaIn, &ref[0], iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors ) );
+
+	Vector3LengthSoASSE( soaIn, &out[0], iNumVectors );
+	Vector3LengthSoARef( soaIn, &ref[0], iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors ) );
+
+	Vector3BoundsSoASSE( soaIn, iNumVectors, afBounds, afBounds + 3, afBounds + 6 );
+	Vector3BoundsSoARef( soaIn, iNumVectors, afBoundsRef, afBoundsRef + 3, afBoundsRef + 6 );
+	fMaxError = Max( fMaxError, MaxRelativeError( afBounds, afBoundsRef, 7 ) );
+
+	// Normalise in place last, as it changes the inputs. Copy the SoA vectors to the outputs
+	// first, then normalise them with both versions
+	for (TUInt32 i = 0; i < iNumVectors * 3; ++i)
+	{
+		out[i] = ref[i] = soa[i];
+	}
+	Vector3NormaliseSoASSE( soaOut, iNumVectors );
+	Vector3NormaliseSoARef( soaRef, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &out[0], &ref[0], iNumVectors * 3 ) );
+
+	vector<TFloat32> aosRef = aos;
+	Vector3NormaliseSSE( &aos[0], kStride, iNumVectors );
+	Vector3NormaliseRef( &aosRef[0], kStride, iNumVectors );
+	fMaxError = Max( fMaxError, MaxRelativeError( &aos[0], &aosRef[0], iNumVectors * 5 ) );
+
+	return fMaxError;
+#else
+	return 0.0f;
+#endif
+}
+
+
+} // namespace gen
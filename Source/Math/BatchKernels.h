@@ -0,0 +1,199 @@
+/**************************************************************************************************
+	Module:       BatchKernels.h
+
+	Kernels that process arrays of 3D vectors in one call: transforming points or normals by a
+	matrix, normalising, dot products, lengths and bounds. Use these in place of per-vector loops
+	over CVector3 when processing mesh data or large numbers of entities
+
+	Two data layouts are supported:
+	- AoS (array of structures): x,y,z floats together for each vector, with a given stride in
+	  bytes between vectors. Use sizeof(CVector3) for a CVector3 array, or the vertex size for
+	  positions/normals inside vertex data. The stride must be at least 12 bytes
+	- SoA (structure of arrays): separate arrays of x, y and z, given by an SVector3Arrays. This
+	  layout suits SIMD best - four vectors are processed together with no shuffling
+
+	As with MatrixKernels.h, each kernel has a scalar reference version (suffix Ref) and an SSE
+	version (suffix SSE), with the unsuffixed kernel chosen at compile time. Matrices are arrays
+	of 16 floats in CMatrix4x4 order (e.g. &m.e00). Outputs may be the same arrays as the inputs
+	(with the same layout), but must not otherwise overlap them
+**************************************************************************************************/
+
+#ifndef GEN_BATCH_KERNELS_H_INCLUDED
+#define GEN_BATCH_KERNELS_H_INCLUDED
+
+#include "Defines.h"
+#include "MatrixKernels.h" // For GEN_MATH_SSE
+
+namespace gen
+{
+
+// Separate arrays of x, y and z for SoA kernels. Each must hold the number of vectors given to
+// the kernel. The arrays need not be aligned
+struct SVector3Arrays
+{
+	TFloat32* x;
+	TFloat32* y;
+	TFloat32* z;
+};
+
+
+/*-----------------------------------------------------------------------------------------
+	Reference kernels
+-----------------------------------------------------------------------------------------*/
+
+// Transform points (4th element taken as 1) or vectors (4th element taken as 0) by a matrix.
+// Normals should be transformed as vectors by the inverse transpose of the matrix if it
+// contains non-uniform scaling
+void Vector3TransformPointsRef( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                void* pOut, TUInt32 iOutStride, TUInt32 iCount );
+void Vector3TransformVectorsRef( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                 void* pOut, TUInt32 iOutStride, TUInt32 iCount );
+
+// Normalise vectors in place. Zero length vectors are set to zero, as CVector3::Normalise
+void Vector3NormaliseRef( void* pVectors, TUInt32 iStride, TUInt32 iCount );
+
+// Dot products of pairs of vectors, written to an array of floats
+void Vector3DotRef( const void* pA, TUInt32 iStrideA, const void* pB, TUInt32 iStrideB,
+                    TFloat32* afOut, TUInt32 iCount );
+
+// Lengths of vectors, written to an array of floats
+void Vector3LengthRef( const void* pVectors, TUInt32 iStride, TFloat32* afOut, TUInt32 iCount );
+
+// Find the axis-aligned bounds of points (written to 3 element arrays afMin and afMax) and,
+// if pfMaxLength is not 0, the largest distance of any point from the origin. Requires at
+// least one point
+void Vector3BoundsRef( const void* pVectors, TUInt32 iStride, TUInt32 iCount,
+                       TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength );
+
+// SoA versions of the kernels above
+void Vector3TransformPointsSoARef( const TFloat32* afM, const SVector3Arrays& in,
+                                   const SVector3Arrays& out, TUInt32 iCount );
+void Vector3TransformVectorsSoARef( const TFloat32* afM, const SVector3Arrays& in,
+                                    const SVector3Arrays& out, TUInt32 iCount );
+void Vector3NormaliseSoARef( const SVector3Arrays& vectors, TUInt32 iCount );
+void Vector3DotSoARef( const SVector3Arrays& a, const SVector3Arrays& b, TFloat32* afOut,
+                       TUInt32 iCount );
+void Vector3LengthSoARef( const SVector3Arrays& vectors, TFloat32* afOut, TUInt32 iCount );
+void Vector3BoundsSoARef( const SVector3Arrays& vectors, TUInt32 iCount,
+                          TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength );
+
+
+#ifdef GEN_MATH_SSE
+
+/*-----------------------------------------------------------------------------------------
+	SSE kernels
+-----------------------------------------------------------------------------------------*/
+// Same behaviour as the reference versions. The AoS kernels never read or write past the
+// third float of a vector, so are safe at the end of an array or with tightly packed data
+
+void Vector3TransformPointsSSE( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                void* pOut, TUInt32 iOutStride, TUInt32 iCount );
+void Vector3TransformVectorsSSE( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                 void* pOut, TUInt32 iOutStride, TUInt32 iCount );
+void Vector3NormaliseSSE( void* pVectors, TUInt32 iStride, TUInt32 iCount );
+void Vector3DotSSE( const void* pA, TUInt32 iStrideA, const void* pB, TUInt32 iStrideB,
+                    TFloat32* afOut, TUInt32 iCount );
+void Vector3LengthSSE( const void* pVectors, TUInt32 iStride, TFloat32* afOut, TUInt32 iCount );
+void Vector3BoundsSSE( const void* pVectors, TUInt32 iStride, TUInt32 iCount,
+                       TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength );
+
+void Vector3TransformPointsSoASSE( const TFloat32* afM, const SVector3Arrays& in,
+                                   const SVector3Arrays& out, TUInt32 iCount );
+void Vector3TransformVectorsSoASSE( const TFloat32* afM, const SVector3Arrays& in,
+                                    const SVector3Arrays& out, TUInt32 iCount );
+void Vector3NormaliseSoASSE( const SVector3Arrays& vectors, TUInt32 iCount );
+void Vector3DotSoASSE( const SVector3Arrays& a, const SVector3Arrays& b, TFloat32* afOut,
+                       TUInt32 iCount );
+void Vector3LengthSoASSE( const SVector3Arrays& vectors, TFloat32* afOut, TUInt32 iCount );
+void Vector3BoundsSoASSE( const SVector3Arrays& vectors, TUInt32 iCount,
+                          TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength );
+
+#endif // GEN_MATH_SSE
+
+
+/*-----------------------------------------------------------------------------------------
+	Selected kernels
+-----------------------------------------------------------------------------------------*/
+// SSE versions if available, otherwise reference versions
+
+#ifdef GEN_MATH_SSE
+	#define GEN_BATCH_KERNEL( name ) name##SSE
+#else
+	#define GEN_BATCH_KERNEL( name ) name##Ref
+#endif
+
+inline void Vector3TransformPoints( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                    void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3TransformPoints )( afM, pIn, iInStride, pOut, iOutStride, iCount );
+}
+inline void Vector3TransformVectors( const TFloat32* afM, const void* pIn, TUInt32 iInStride,
+                                     void* pOut, TUInt32 iOutStride, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3TransformVectors )( afM, pIn, iInStride, pOut, iOutStride, iCount );
+}
+inline void Vector3Normalise( void* pVectors, TUInt32 iStride, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3Normalise )( pVectors, iStride, iCount );
+}
+inline void Vector3Dot( const void* pA, TUInt32 iStrideA, const void* pB, TUInt32 iStrideB,
+                        TFloat32* afOut, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3Dot )( pA, iStrideA, pB, iStrideB, afOut, iCount );
+}
+inline void Vector3Length( const void* pVectors, TUInt32 iStride, TFloat32* afOut,
+                           TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3Length )( pVectors, iStride, afOut, iCount );
+}
+inline void Vector3Bounds( const void* pVectors, TUInt32 iStride, TUInt32 iCount,
+                           TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength = 0 )
+{
+	GEN_BATCH_KERNEL( Vector3Bounds )( pVectors, iStride, iCount, afMin, afMax, pfMaxLength );
+}
+
+inline void Vector3TransformPointsSoA( const TFloat32* afM, const SVector3Arrays& in,
+                                       const SVector3Arrays& out, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3TransformPointsSoA )( afM, in, out, iCount );
+}
+inline void Vector3TransformVectorsSoA( const TFloat32* afM, const SVector3Arrays& in,
+                                        const SVector3Arrays& out, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3TransformVectorsSoA )( afM, in, out, iCount );
+}
+inline void Vector3NormaliseSoA( const SVector3Arrays& vectors, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3NormaliseSoA )( vectors, iCount );
+}
+inline void Vector3DotSoA( const SVector3Arrays& a, const SVector3Arrays& b, TFloat32* afOut,
+                           TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3DotSoA )( a, b, afOut, iCount );
+}
+inline void Vector3LengthSoA( const SVector3Arrays& vectors, TFloat32* afOut, TUInt32 iCount )
+{
+	GEN_BATCH_KERNEL( Vector3LengthSoA )( vectors, afOut, iCount );
+}
+inline void Vector3BoundsSoA( const SVector3Arrays& vectors, TUInt32 iCount,
+                              TFloat32* afMin, TFloat32* afMax, TFloat32* pfMaxLength = 0 )
+{
+	GEN_BATCH_KERNEL( Vector3BoundsSoA )( vectors, iCount, afMin, afMax, pfMaxLength );
+}
+
+#undef GEN_BATCH_KERNEL
+
+
+/*-----------------------------------------------------------------------------------------
+	Validation
+-----------------------------------------------------------------------------------------*/
+
+// Compare the selected kernels against the reference kernels on the given number of random
+// vectors. Returns the largest difference found in any output element, relative to the size
+// of the reference result. Returns 0 if the reference kernels are selected
+TFloat32 ValidateBatchKernels( const TUInt32 iNumVectors );
+
+
+} // namespace gen
+
+#endif // GEN_BATCH_KERNELS_H_INCLUDED
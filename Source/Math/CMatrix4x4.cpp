@@ -17,6 +17,7 @@
 **************************************************************************************************/
 
 #include "CMatrix4x4.h"
+#include "MatrixKernels.h"
 
 #include "Error.h"
 #include "CVector4.h"
@@ -31,36 +32,6 @@ namespace gen
 	Constructors/Destructors
 -----------------------------------------------------------------------------------------*/
 
-// Construct by value
-CMatrix4x4::CMatrix4x4
-(
-	const TFloat32 elt00, const TFloat32 elt01, const TFloat32 elt02, const TFloat32 elt03,
-	const TFloat32 elt10, const TFloat32 elt11, const TFloat32 elt12, const TFloat32 elt13,
-	const TFloat32 elt20, const TFloat32 elt21, const TFloat32 elt22, const TFloat32 elt23,
-	const TFloat32 elt30, const TFloat32 elt31, const TFloat32 elt32, const TFloat32 elt33
-)
-{
-	e00 = elt00;
-	e01 = elt01;
-	e02 = elt02;
-	e03 = elt03;
-
-	e10 = elt10;
-	e11 = elt11;
-	e12 = elt12;
-	e13 = elt13;
-
-	e20 = elt20;
-	e21 = elt21;
-	e22 = elt22;
-	e23 = elt23;
-
-	e30 = elt30;
-	e31 = elt31;
-	e32 = elt32;
-	e33 = elt33;
-}
-
 // Construct through pointer to 16 floats, may specify row/column order of data
 CMatrix4x4::CMatrix4x4
 (
@@ -233,32 +204,6 @@ CMatrix4x4::CMatrix4x4
 	}
 }
  
-// Construct affine transformation from position (translation) only
-CMatrix4x4::CMatrix4x4( const CVector3& position )
-{
-	// Take most elements from identity
-	e00 = 1.0f;
-	e01 = 0.0f;
-	e02 = 0.0f;
-	e03 = 0.0f;
-
-	e10 = 0.0f;
-	e11 = 1.0f;
-	e12 = 0.0f;
-	e13 = 0.0f;
-
-	e20 = 0.0f;
-	e21 = 0.0f;
-	e22 = 1.0f;
-	e23 = 0.0f;
-
-	// Put position (translation) in bottom row
-	e30 = position.x;
-	e31 = position.y;
-	e32 = position.z;
-	e33 = 1.0f;
-}
-
 // Construct affine transformation from position, Euler angles and optional scaling, with 
 // remaining elements taken from the identity matrix. May specify order to apply rotations
 // Matrix is effectively built in this order: M = Scale*Rotation*Translation
@@ -292,53 +237,6 @@ CMatrix4x4::CMatrix4x4
 	e32 = position.z;
 }
 
-// Construct affine transformation from quaternion and optional position & scaling, with 
-// remaining elements taken from the identity matrix
-// Matrix is effectively built in this order: M = Scale*Rotation*Translation
-CMatrix4x4::CMatrix4x4
-(
-	const CQuaternion& quat,
-	const CVector3&    position /*= CVector3::kOrigin*/,
-	const CVector3&    scale /*= CVector3::kOne*/
-)
-{
-	// Efficiently precalculate some values from the quaternion
-	TFloat32 xx = 2*quat.x;
-	TFloat32 yy = 2*quat.y;
-	TFloat32 zz = 2*quat.z;
-	TFloat32 xy = xx*quat.y;
-	TFloat32 yz = yy*quat.z;
-	TFloat32 zx = zz*quat.x;
-	TFloat32 wx = quat.w*xx;
-	TFloat32 wy = quat.w*yy;
-	TFloat32 wz = quat.w*zz;
-	xx *= quat.x;
-	yy *= quat.y;
-	zz *= quat.z;
-
-	// Fill upper 3x3 matrix, combining scaling with rotation values from the quaternion
-	e00  = scale.x * (1 - yy - zz);
-	e01  = scale.x * (xy + wz);
-	e02  = scale.x * (zx - wy);
-	e03  = 0.0f; // Add 0's in fourth column
-
-	e10  = scale.y * (xy - wz);
-	e11  = scale.y * (1 - xx - zz);
-	e12  = scale.y * (yz + wx);
-	e13  = 0.0f;
-
-	e20  = scale.z * (zx + wy);
-	e21  = scale.z * (yz - wx);
-	e22 = scale.z * (1 - xx - yy);
-	e23 = 0.0f;
-
-	// Put position (translation) in bottom row
-	e30 = position.x;
-	e31 = position.y;
-	e32 = position.z;
-	e33 = 1.0f;
-}
-
 // Construct affine transformation from axis/angle of rotation and optional position & scaling,
 // with remaining elements taken from the identity matrix
 // Matrix is effectively built in this order: M = Scale*Rotation*Translation
@@ -436,57 +334,6 @@ CMatrix4x4::CMatrix4x4
 }
 
 
-// Copy constructor
-CMatrix4x4::CMatrix4x4( const CMatrix4x4& m )
-{
-	e00 = m.e00;
-	e01 = m.e01;
-	e02 = m.e02;
-	e03 = m.e03;
-
-	e10 = m.e10;
-	e11 = m.e11;
-	e12 = m.e12;
-	e13 = m.e13;
-
-	e20 = m.e20;
-	e21 = m.e21;
-	e22 = m.e22;
-	e23 = m.e23;
-
-	e30 = m.e30;
-	e31 = m.e31;
-	e32 = m.e32;
-	e33 = m.e33;
-}
-
-// Assignment operator
-CMatrix4x4& CMatrix4x4::operator=( const CMatrix4x4& m )
-{
-	if ( this != &m )
-	{
-		e00 = m.e00;
-		e01 = m.e01;
-		e02 = m.e02;
-		e03 = m.e03;
-
-		e10 = m.e10;
-		e11 = m.e11;
-		e12 = m.e12;
-		e13 = m.e13;
-
-		e20 = m.e20;
-		e21 = m.e21;
-		e22 = m.e22;
-		e23 = m.e23;
-
-		e30 = m.e30;
-		e31 = m.e31;
-		e32 = m.e32;
-		e33 = m.e33;
-	}
-	return *this;
-}
 
 
 /*-----------------------------------------------------------------------------------------
@@ -1656,31 +1503,7 @@ CMatrix4x4 Orthogonalise3x3
 // This is also the (most efficient) inverse for a rotation matrix
 void CMatrix4x4::Transpose()
 {
-	TFloat32 t;
-
-	t   = e01;
-	e01 = e10;
-	e10 = t;
-
-	t   = e02;
-	e02 = e20;
-	e20 = t;
-
-	t   = e12;
-	e12 = e21;
-	e21 = t;
-
-	t   = e03;
-	e03 = e30;
-	e30 = t;
-
-	t   = e13;
-	e13 = e31;
-	e31 = t;
-
-	t   = e23;
-	e23 = e32;
-	e32 = t;
+	Matrix4x4Transpose( &e00, &e00 );
 }
     
 // Return the transpose of given matrix (matrix reflected through its diagonal)
@@ -1688,27 +1511,7 @@ void CMatrix4x4::Transpose()
 CMatrix4x4 Transpose( const CMatrix4x4& m )
 {
 	CMatrix4x4 transMat;
-
-	transMat.e00 = m.e00;
-	transMat.e01 = m.e10;
-	transMat.e02 = m.e20;
-	transMat.e03 = m.e30;
-
-	transMat.e10 = m.e01;
-	transMat.e11 = m.e11;
-	transMat.e12 = m.e21;
-	transMat.e13 = m.e31;
-
-	transMat.e20 = m.e02;
-	transMat.e21 = m.e12;
-	transMat.e22 = m.e22;
-	transMat.e23 = m.e32;
-
-	transMat.e30 = m.e03;
-	transMat.e31 = m.e13;
-	transMat.e32 = m.e23;
-	transMat.e33 = m.e33;
-
+	Matrix4x4Transpose( &m.e00, &transMat.e00 );
 	return transMat;
 }
 
@@ -1879,39 +1682,8 @@ CMatrix4x4 InverseAffine( const CMatrix4x4& m )
 	GEN_GUARD;
 
 	CMatrix4x4 mOut;
-
-	// Calculate determinant of upper left 3x3
-	TFloat32 det0 = m.e11*m.e22 - m.e12*m.e21;
-	TFloat32 det1 = m.e12*m.e20 - m.e10*m.e22;
-	TFloat32 det2 = m.e10*m.e21 - m.e11*m.e20;
-	TFloat32 det = m.e00*det0 + m.e01*det1 + m.e02*det2;
+	TFloat32 det = Matrix4x4InverseAffine( &m.e00, &mOut.e00 );
 	GEN_ASSERT( !IsZero(det), "Singular matrix" );
-
-	// Calculate inverse of upper left 3x3
-	TFloat32 invDet = 1.0f / det;
-	mOut.e00 = invDet * det0;
-	mOut.e10 = invDet * det1;
-	mOut.e20 = invDet * det2;
-		  
-	mOut.e01 = invDet * (m.e21*m.e02 - m.e22*m.e01);
-	mOut.e11 = invDet * (m.e22*m.e00 - m.e20*m.e02);
-	mOut.e21 = invDet * (m.e20*m.e01 - m.e21*m.e00);
-		  
-	mOut.e02 = invDet * (m.e01*m.e12 - m.e02*m.e11);
-	mOut.e12 = invDet * (m.e02*m.e10 - m.e00*m.e12);
-	mOut.e22 = invDet * (m.e00*m.e11 - m.e01*m.e10);
-
-	// Transform negative translation by inverted 3x3 to get inverse
-	mOut.e30 = -m.e30*mOut.e00 - m.e31*mOut.e10 - m.e32*mOut.e20;
-	mOut.e31 = -m.e30*mOut.e01 - m.e31*mOut.e11 - m.e32*mOut.e21;
-	mOut.e32 = -m.e30*mOut.e02 - m.e31*mOut.e12 - m.e32*mOut.e22;
-
-	// Fill in right column for affine matrix
-	mOut.e03 = 0.0f;
-	mOut.e13 = 0.0f;
-	mOut.e23 = 0.0f;
-	mOut.e33 = 1.0f;
-
 	return mOut;
 
 	GEN_ENDGUARD;
@@ -1974,22 +1746,8 @@ CMatrix4x4 Inverse( const CMatrix4x4& m )
 	GEN_GUARD;
 
 	CMatrix4x4 mOut;
-
-	// Calculate determinant
-	TFloat32 det = m.e00 * Cofactor( m, 0, 0 ) + m.e01 * Cofactor( m, 0, 1 ) + 
-	               m.e02 * Cofactor( m, 0, 2 ) + m.e03 * Cofactor( m, 0, 3 ); 
+	TFloat32 det = Matrix4x4Inverse( &m.e00, &mOut.e00 );
 	GEN_ASSERT( !IsZero(det), "Singular matrix" );
-
-	// Inverse is (1/determinant)*adjoint matrix. Adjoint matrix is transposed matrix of cofactors
-	TFloat32 invDet = 1.0f / det;
-	for (TUInt32 i = 0; i < 4; ++i)
-	{
-		for (TUInt32 j = 0; j < 4; ++j)
-		{
-			mOut[i][j] = invDet * Cofactor( m, j, i );
-		}
-	}
-
 	return mOut;
 
 	GEN_ENDGUARD;
@@ -3116,11 +2874,7 @@ CVector4 operator*
 )
 {
     CVector4 vOut;
-    vOut.x = v.x*m.e00 + v.y*m.e10 + v.z*m.e20 + v.w*m.e30;
-    vOut.y = v.x*m.e01 + v.y*m.e11 + v.z*m.e21 + v.w*m.e31;
-    vOut.z = v.x*m.e02 + v.y*m.e12 + v.z*m.e22 + v.w*m.e32;
-    vOut.w = v.x*m.e03 + v.y*m.e13 + v.z*m.e23 + v.w*m.e33;
-
+    Matrix4x4Transform( &m.e00, &v.x, &vOut.x );
     return vOut;
 }
 
@@ -3146,11 +2900,7 @@ CVector4 operator*
 CVector4 CMatrix4x4::Transform(	const CVector4& v ) const
 {
 	CVector4 vOut;
-	vOut.x = v.x*e00 + v.y*e10 + v.z*e20 + v.w*e30;
-	vOut.y = v.x*e01 + v.y*e11 + v.z*e21 + v.w*e31;
-	vOut.z = v.x*e02 + v.y*e12 + v.z*e22 + v.w*e32;
-	vOut.w = v.x*e03 + v.y*e13 + v.z*e23 + v.w*e33;
-
+	Matrix4x4Transform( &e00, &v.x, &vOut.x );
 	return vOut;
 }
 
@@ -3159,10 +2909,7 @@ CVector4 CMatrix4x4::Transform(	const CVector4& v ) const
 CVector3 CMatrix4x4::TransformVector( const CVector3& v ) const
 {
 	CVector3 vOut;
-	vOut.x = v.x*e00 + v.y*e10 + v.z*e20;
-	vOut.y = v.x*e01 + v.y*e11 + v.z*e21;
-	vOut.z = v.x*e02 + v.y*e12 + v.z*e22;
-
+	Matrix4x4TransformVector( &e00, &v.x, &vOut.x );
 	return vOut;
 }
 
@@ -3171,10 +2918,7 @@ CVector3 CMatrix4x4::TransformVector( const CVector3& v ) const
 CVector3 CMatrix4x4::TransformPoint( const CVector3& p ) const
 {
 	CVector3 pOut;
-	pOut.x = p.x*e00 + p.y*e10 + p.z*e20 + e30;
-	pOut.y = p.x*e01 + p.y*e11 + p.z*e21 + e31;
-	pOut.z = p.x*e02 + p.y*e12 + p.z*e22 + e32;
-
+	Matrix4x4TransformPoint( &e00, &p.x, &pOut.x );
 	return pOut;
 }
 
@@ -3192,39 +2936,8 @@ CMatrix4x4& CMatrix4x4::operator*=( const CMatrix4x4& m )
 	}
 	else
 	{
-		TFloat32 t0, t1, t2;
-
-		t0  = e00*m.e00 + e01*m.e10 + e02*m.e20 + e03*m.e30;
-		t1  = e00*m.e01 + e01*m.e11 + e02*m.e21 + e03*m.e31;
-		t2  = e00*m.e02 + e01*m.e12 + e02*m.e22 + e03*m.e32;
-		e03 = e00*m.e03 + e01*m.e13 + e02*m.e23 + e03*m.e33;
-		e00 = t0;
-		e01 = t1;
-		e02 = t2;
-
-		t0  = e10*m.e00 + e11*m.e10 + e12*m.e20 + e13*m.e30;
-		t1  = e10*m.e01 + e11*m.e11 + e12*m.e21 + e13*m.e31;
-		t2  = e10*m.e02 + e11*m.e12 + e12*m.e22 + e13*m.e32;
-		e13 = e10*m.e03 + e11*m.e13 + e12*m.e23 + e13*m.e33;
-		e10 = t0;
-		e11 = t1;
-		e12 = t2;
-
-		t0  = e20*m.e00 + e21*m.e10 + e22*m.e20 + e23*m.e30;
-		t1  = e20*m.e01 + e21*m.e11 + e22*m.e21 + e23*m.e31;
-		t2  = e20*m.e02 + e21*m.e12 + e22*m.e22 + e23*m.e32;
-		e23 = e20*m.e03 + e21*m.e13 + e22*m.e23 + e23*m.e33;
-		e20 = t0;
-		e21 = t1;
-		e22 = t2;
-
-		t0  = e30*m.e00 + e31*m.e10 + e32*m.e20 + e33*m.e30;
-		t1  = e30*m.e01 + e31*m.e11 + e32*m.e21 + e33*m.e31;
-		t2  = e30*m.e02 + e31*m.e12 + e32*m.e22 + e33*m.e32;
-		e33 = e30*m.e03 + e31*m.e13 + e32*m.e23 + e33*m.e33;
-		e30 = t0;
-		e31 = t1;
-		e32 = t2;
+		// Kernel allows the output to be the first input
+		Matrix4x4Multiply( &e00, &m.e00, &e00 );
 	}
 	return *this;
 }
@@ -3238,27 +2951,7 @@ CMatrix4x4 operator*
 )
 {
 	CMatrix4x4 mOut;
-
-	mOut.e00 = m1.e00*m2.e00 + m1.e01*m2.e10 + m1.e02*m2.e20 + m1.e03*m2.e30;
-	mOut.e01 = m1.e00*m2.e01 + m1.e01*m2.e11 + m1.e02*m2.e21 + m1.e03*m2.e31;
-	mOut.e02 = m1.e00*m2.e02 + m1.e01*m2.e12 + m1.e02*m2.e22 + m1.e03*m2.e32;
-	mOut.e03 = m1.e00*m2.e03 + m1.e01*m2.e13 + m1.e02*m2.e23 + m1.e03*m2.e33;
-
-	mOut.e10 = m1.e10*m2.e00 + m1.e11*m2.e10 + m1.e12*m2.e20 + m1.e13*m2.e30;
-	mOut.e11 = m1.e10*m2.e01 + m1.e11*m2.e11 + m1.e12*m2.e21 + m1.e13*m2.e31;
-	mOut.e12 = m1.e10*m2.e02 + m1.e11*m2.e12 + m1.e12*m2.e22 + m1.e13*m2.e32;
-	mOut.e13 = m1.e10*m2.e03 + m1.e11*m2.e13 + m1.e12*m2.e23 + m1.e13*m2.e33;
-
-	mOut.e20 = m1.e20*m2.e00 + m1.e21*m2.e10 + m1.e22*m2.e20 + m1.e23*m2.e30;
-	mOut.e21 = m1.e20*m2.e01 + m1.e21*m2.e11 + m1.e22*m2.e21 + m1.e23*m2.e31;
-	mOut.e22 = m1.e20*m2.e02 + m1.e21*m2.e12 + m1.e22*m2.e22 + m1.e23*m2.e32;
-	mOut.e23 = m1.e20*m2.e03 + m1.e21*m2.e13 + m1.e22*m2.e23 + m1.e23*m2.e33;
-
-	mOut.e30 = m1.e30*m2.e00 + m1.e31*m2.e10 + m1.e32*m2.e20 + m1.e33*m2.e30;
-	mOut.e31 = m1.e30*m2.e01 + m1.e31*m2.e11 + m1.e32*m2.e21 + m1.e33*m2.e31;
-	mOut.e32 = m1.e30*m2.e02 + m1.e31*m2.e12 + m1.e32*m2.e22 + m1.e33*m2.e32;
-	mOut.e33 = m1.e30*m2.e03 + m1.e31*m2.e13 + m1.e32*m2.e23 + m1.e33*m2.e33;
-
+	Matrix4x4Multiply( &m1.e00, &m2.e00, &mOut.e00 );
 	return mOut;
 }
 
@@ -3273,31 +2966,8 @@ CMatrix4x4& CMatrix4x4::MultiplyAffine( const CMatrix4x4& m )
 	}
 	else
 	{
-		TFloat32 t0, t1;
-
-		t0  = e00*m.e00 + e01*m.e10 + e02*m.e20;
-		t1  = e00*m.e01 + e01*m.e11 + e02*m.e21;
-		e02 = e00*m.e02 + e01*m.e12 + e02*m.e22;
-		e00 = t0;
-		e01 = t1;
-
-		t0  = e10*m.e00 + e11*m.e10 + e12*m.e20;
-		t1  = e10*m.e01 + e11*m.e11 + e12*m.e21;
-		e12 = e10*m.e02 + e11*m.e12 + e12*m.e22;
-		e10 = t0;
-		e11 = t1;
-
-		t0  = e20*m.e00 + e21*m.e10 + e22*m.e20;
-		t1  = e20*m.e01 + e21*m.e11 + e22*m.e21;
-		e22 = e20*m.e02 + e21*m.e12 + e22*m.e22;
-		e20 = t0;
-		e21 = t1;
-
-		t0  = e30*m.e00 + e31*m.e10 + e32*m.e20 + m.e30;
-		t1  = e30*m.e01 + e31*m.e11 + e32*m.e21 + m.e31;
-		e32 = e30*m.e02 + e31*m.e12 + e32*m.e22 + m.e32;
-		e30 = t0;
-		e31 = t1;
+		// Kernel allows the output to be the first input
+		Matrix4x4MultiplyAffine( &e00, &m.e00, &e00 );
 	}
 
 	return *this;
@@ -3311,27 +2981,7 @@ CMatrix4x4 MultiplyAffine
 )
 {
 	CMatrix4x4 mOut;
-
-	mOut.e00 = m1.e00*m2.e00 + m1.e01*m2.e10 + m1.e02*m2.e20;
-	mOut.e01 = m1.e00*m2.e01 + m1.e01*m2.e11 + m1.e02*m2.e21;
-	mOut.e02 = m1.e00*m2.e02 + m1.e01*m2.e12 + m1.e02*m2.e22;
-	mOut.e03 = 0.0f;
-
-	mOut.e10 = m1.e10*m2.e00 + m1.e11*m2.e10 + m1.e12*m2.e20;
-	mOut.e11 = m1.e10*m2.e01 + m1.e11*m2.e11 + m1.e12*m2.e21;
-	mOut.e12 = m1.e10*m2.e02 + m1.e11*m2.e12 + m1.e12*m2.e22;
-	mOut.e13 = 0.0f;
-
-	mOut.e20 = m1.e20*m2.e00 + m1.e21*m2.e10 + m1.e22*m2.e20;
-	mOut.e21 = m1.e20*m2.e01 + m1.e21*m2.e11 + m1.e22*m2.e21;
-	mOut.e22 = m1.e20*m2.e02 + m1.e21*m2.e12 + m1.e22*m2.e22;
-	mOut.e23 = 0.0f;
-
-	mOut.e30 = m1.e30*m2.e00 + m1.e31*m2.e10 + m1.e32*m2.e20 + m2.e30;
-	mOut.e31 = m1.e30*m2.e01 + m1.e31*m2.e11 + m1.e32*m2.e21 + m2.e31;
-	mOut.e32 = m1.e30*m2.e02 + m1.e31*m2.e12 + m1.e32*m2.e22 + m2.e32;
-	mOut.e33 = 1.0f;
-
+	Matrix4x4MultiplyAffine( &m1.e00, &m2.e00, &mOut.e00 );
 	return mOut;
 }
 
@@ -3346,5 +2996,11 @@ const CMatrix4x4 CMatrix4x4::kIdentity(1.0f, 0.0f, 0.0f, 0.0f,
                                        0.0f, 0.0f, 1.0f, 0.0f,
                                        0.0f, 0.0f, 0.0f, 1.0f);
 
+// Check affine matrix construction can be evaluated at compile time
+static_assert( CMatrix4x4( CQuaternion( 0.0f, 0.0f, 1.0f, 0.0f ), CVector3( 1.0f, 2.0f, 3.0f ),
+                           CVector3( 2.0f, 2.0f, 2.0f ) ).e00 == -2.0f &&
+               CMatrix4x4( CVector3( 1.0f, 2.0f, 3.0f ) ).e31 == 2.0f,
+               "CMatrix4x4 construction must be constexpr" );
+
 
 } // namespace gen
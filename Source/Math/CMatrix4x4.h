@@ -82,13 +82,17 @@ public:
 	CMatrix4x4() {}
 
 	// Construct by value
-	CMatrix4x4
+	constexpr CMatrix4x4
 	(
 		const TFloat32 elt00, const TFloat32 elt01, const TFloat32 elt02, const TFloat32 elt03,
 		const TFloat32 elt10, const TFloat32 elt11, const TFloat32 elt12, const TFloat32 elt13,
 		const TFloat32 elt20, const TFloat32 elt21, const TFloat32 elt22, const TFloat32 elt23,
 		const TFloat32 elt30, const TFloat32 elt31, const TFloat32 elt32, const TFloat32 elt33
-	);
+	) : e00( elt00 ), e01( elt01 ), e02( elt02 ), e03( elt03 ),
+	    e10( elt10 ), e11( elt11 ), e12( elt12 ), e13( elt13 ),
+	    e20( elt20 ), e21( elt21 ), e22( elt22 ), e23( elt23 ),
+	    e30( elt30 ), e31( elt31 ), e32( elt32 ), e33( elt33 )
+	{}
 
 	// Construct through pointer to 16 floats, may specify row/column order of data
 	explicit CMatrix4x4
@@ -123,7 +127,12 @@ public:
 
 
 	// Construct affine transformation from position (translation) only
-	explicit CMatrix4x4( const CVector3& position );
+	explicit constexpr CMatrix4x4( const CVector3& position )
+		: e00( 1.0f ), e01( 0.0f ), e02( 0.0f ), e03( 0.0f ),
+		  e10( 0.0f ), e11( 1.0f ), e12( 0.0f ), e13( 0.0f ),
+		  e20( 0.0f ), e21( 0.0f ), e22( 1.0f ), e23( 0.0f ),
+		  e30( position.x ), e31( position.y ), e32( position.z ), e33( 1.0f )
+	{}
 	// Require explicit conversion from position only (see above)
 
 	// Construct affine transformation from position, Euler angles and optional scaling, with 
@@ -140,7 +149,9 @@ public:
 	// Construct affine transformation from quaternion and optional position & scaling, with 
 	// remaining elements taken from the identity matrix
 	// Matrix is effectively built in this order: M = Scale*Rotation*Translation
-	explicit CMatrix4x4
+	// Defined in CQuaternion.h, which must be included to use it. Pass the position and scale
+	// explicitly to use it in constant expressions (the default arguments are not constexpr)
+	explicit constexpr CMatrix4x4
 	(
 		const CQuaternion& quat,
 		const CVector3&    position = CVector3::kOrigin,
@@ -180,10 +191,40 @@ public:
 
 
 	// Copy constructor
-    CMatrix4x4( const CMatrix4x4& m );
+    constexpr CMatrix4x4( const CMatrix4x4& m )
+		: e00( m.e00 ), e01( m.e01 ), e02( m.e02 ), e03( m.e03 ),
+		  e10( m.e10 ), e11( m.e11 ), e12( m.e12 ), e13( m.e13 ),
+		  e20( m.e20 ), e21( m.e21 ), e22( m.e22 ), e23( m.e23 ),
+		  e30( m.e30 ), e31( m.e31 ), e32( m.e32 ), e33( m.e33 )
+	{}
 
 	// Assignment operator
-    CMatrix4x4& operator=( const CMatrix4x4& m );
+    constexpr CMatrix4x4& operator=( const CMatrix4x4& m )
+	{
+		if ( this != &m )
+		{
+			e00 = m.e00;
+			e01 = m.e01;
+			e02 = m.e02;
+			e03 = m.e03;
+
+			e10 = m.e10;
+			e11 = m.e11;
+			e12 = m.e12;
+			e13 = m.e13;
+
+			e20 = m.e20;
+			e21 = m.e21;
+			e22 = m.e22;
+			e23 = m.e23;
+
+			e30 = m.e30;
+			e31 = m.e31;
+			e32 = m.e32;
+			e33 = m.e33;
+		}
+		return *this;
+	}
 
 
 	/*-----------------------------------------------------------------------------------------
@@ -11,49 +11,6 @@
 namespace gen
 {
 
-/*-----------------------------------------------------------------------------------------
-	Transformation operations
------------------------------------------------------------------------------------------*/
-
-// Combine this transform by the given one
-CQuatTransform& CQuatTransform::operator*=
-(
-	const CQuatTransform& q
-)
-{
-	// Just use binary operator*
-	*this = *this * q;
-	return *this;
-}
-
-// Combine two transforms together - non-member function
-CQuatTransform operator*
-(
-	const CQuatTransform& q1,
-	const CQuatTransform& q2
-)
-{
-	CQuatTransform qr;  // Result transform
-
-	// See Van Verth 3.4.3 for rationale behind this method (uses rotation matrix in book rather
-	// than quaternion, but principle is the same)
-
-	// Combine scales and quaternions simply
-	qr.scale.Set( q1.scale.x * q2.scale.x, q1.scale.y * q2.scale.y, q1.scale.z * q2.scale.z );
-	qr.quat = q1.quat * q2.quat; // Reversed from maths text for our left-handed system
-
-	// Formula to combine position is: quat2 * (scale2 * pos1) + pos2
-	// This is because the position from the first transform will be scaled and rotated by the
-	// second transform before the second transform's position is added
-	
-	// First calculate scale2 * pos1...
-	CVector3 scalePos( q2.scale.x * q1.pos.x, q2.scale.y * q1.pos.y, q2.scale.z * q1.pos.z );
-	qr.pos = q2.quat.Rotate( scalePos ) + q2.pos;  // ...then complete the formula
-
-	return qr;
-}
-
-
 /*---------------------------------------------------------------------------------------------
 	Interpolation
 ---------------------------------------------------------------------------------------------*/
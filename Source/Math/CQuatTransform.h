@@ -31,7 +31,7 @@ public:
 	CQuatTransform() {}
 
 	// Constructor by value
-    CQuatTransform
+    constexpr CQuatTransform
 	(
 		const CQuaternion& initQuat,
 		const CVector3&    initPos,
@@ -57,13 +57,13 @@ public:
 
 
 	// Copy constructor
-    CQuatTransform
+    constexpr CQuatTransform
 	(
 		const CQuatTransform& src
 	) : quat( src.quat ), pos( src.pos ), scale( src.scale ) {}
 
 	// Assignment operator
-    CQuatTransform& operator=
+    constexpr CQuatTransform& operator=
 	(
 		const CQuatTransform& src
 	)
@@ -77,8 +77,6 @@ public:
 		return *this;
 	}
 
-	// Destructor
-	~CQuatTransform() {}
 
 
 /*-----------------------------------------------------------------------------------------
@@ -114,7 +112,7 @@ public:
 	// Addition / subtraction
 
 	// Add another quaternion transform to this one
-    CQuatTransform& operator+=
+    constexpr CQuatTransform& operator+=
 	(
 		const CQuatTransform& qt
 	)
@@ -126,7 +124,7 @@ public:
 	}
 
 	// Subtract another quaternion transform to this one
-    CQuatTransform& operator-=
+    constexpr CQuatTransform& operator-=
 	(
 		const CQuatTransform& qt
 	)
@@ -142,7 +140,7 @@ public:
 	// Scalar operations
 
 	// Scalar multiplication
-    CQuatTransform& operator*=
+    constexpr CQuatTransform& operator*=
 	(
 		const TFloat32& scalar
 	)
@@ -172,7 +170,7 @@ public:
 
 	// Return the given CVector3 transformed by this quaternion-transform
 	// Assuming it is a vector rather then a point
-    CVector3 TransformVector
+    constexpr CVector3 TransformVector
 	(
 		const CVector3& vec
 	) const
@@ -186,7 +184,7 @@ public:
 
 	// Return the given CVector3 transformed by this quaternion-transform
 	// Assuming it is a point rather than a vector
-    CVector3 TransformPoint
+    constexpr CVector3 TransformPoint
 	(
 		const CVector3& vec
 	) const
@@ -200,13 +198,13 @@ public:
 
 
 	// Combine this transform by the given one
-    CQuatTransform& operator*=
+    constexpr CQuatTransform& operator*=
 	(
 		const CQuatTransform& q
 	);
 	
 	// Combine two transforms together - non-member function
-	friend CQuatTransform operator*
+	friend constexpr CQuatTransform operator*
 	(
 		const CQuatTransform& q1,
 		const CQuatTransform& q2
@@ -261,6 +259,49 @@ public:
 };
 
 
+/*-----------------------------------------------------------------------------------------
+	Transformation operations
+-----------------------------------------------------------------------------------------*/
+
+// Combine two transforms together - non-member function
+constexpr CQuatTransform operator*
+(
+	const CQuatTransform& q1,
+	const CQuatTransform& q2
+)
+{
+	// See Van Verth 3.4.3 for rationale behind this method (uses rotation matrix in book rather
+	// than quaternion, but principle is the same)
+
+	// Formula to combine position is: quat2 * (scale2 * pos1) + pos2
+	// This is because the position from the first transform will be scaled and rotated by the
+	// second transform before the second transform's position is added
+	
+	// First calculate scale2 * pos1...
+	const CVector3 scalePos( q2.scale.x * q1.pos.x, q2.scale.y * q1.pos.y, q2.scale.z * q1.pos.z );
+
+	// ...then complete the formula. Combine scales and quaternions simply (quaternion order is
+	// reversed from maths text for our left-handed system)
+	return CQuatTransform
+	(
+		q1.quat * q2.quat,
+		q2.quat.Rotate( scalePos ) + q2.pos,
+		CVector3( q1.scale.x * q2.scale.x, q1.scale.y * q2.scale.y, q1.scale.z * q2.scale.z )
+	);
+}
+
+// Combine this transform by the given one
+constexpr CQuatTransform& CQuatTransform::operator*=
+(
+	const CQuatTransform& q
+)
+{
+	// Just use binary operator*
+	*this = *this * q;
+	return *this;
+}
+
+
 /*-----------------------------------------------------------------------------------------
 	Non-member Operators
 -----------------------------------------------------------------------------------------*/
@@ -269,7 +310,7 @@ public:
 // Addition / subtraction
 
 // Addition
-inline CQuatTransform operator+
+constexpr CQuatTransform operator+
 (
 	const CQuatTransform& qt1,
 	const CQuatTransform& qt2
@@ -279,7 +320,7 @@ inline CQuatTransform operator+
 }
 
 // Subtraction
-inline CQuatTransform operator-
+constexpr CQuatTransform operator-
 (
 	const CQuatTransform& qt1,
 	const CQuatTransform& qt2
@@ -289,7 +330,7 @@ inline CQuatTransform operator-
 }
 
 // Unary positive (for completeness)
-inline CQuatTransform operator+
+constexpr CQuatTransform operator+
 (
 	const CQuatTransform& qt
 )
@@ -298,7 +339,7 @@ inline CQuatTransform operator+
 }
 
 // Unary negation
-inline CQuatTransform operator-
+constexpr CQuatTransform operator-
 (
 	const CQuatTransform& qt
 )
@@ -311,7 +352,7 @@ inline CQuatTransform operator-
 // Scalar operations
 
 // Scalar multiplication
-inline CQuatTransform operator*
+constexpr CQuatTransform operator*
 (
 	const CQuatTransform& qt1,
 	const TFloat32        scalar
@@ -102,24 +102,6 @@ CQuaternion::CQuaternion
 }
 
 
-/*-----------------------------------------------------------------------------------------
-	Quaternion multiplication
------------------------------------------------------------------------------------------*/
-
-// Return the quaternion result of multiplying two quaternions - non-member function
-CQuaternion operator*
-(
-	const CQuaternion& q1,
-	const CQuaternion& q2
-)
-{
-	const CVector3& v1 = q1.Vector();
-	const CVector3& v2 = q2.Vector();
-
-	return CQuaternion( q1.w*q2.w - Dot( v1, v2 ), q1.w*v2 + q2.w*v1 + Cross( v2, v1 ) );
-}
-
-
 /*-----------------------------------------------------------------------------------------
 	Length operations
 -----------------------------------------------------------------------------------------*/
@@ -165,23 +147,6 @@ CQuaternion Normalise
 }
 
 
-/*-----------------------------------------------------------------------------------------
-	Vector transformation
------------------------------------------------------------------------------------------*/
-
-// Rotate a CVector3 by this quaternion
-CVector3 CQuaternion::Rotate
-(
-	const CVector3& p
-) const
-{
-	const CVector3& v = Vector();
-
-	float tmp = 2.0f*w;
-	return CVector3( (tmp*w-1.0f)*p + (2.0f*gen::Dot( v, p ))*v + tmp*Cross( v, p ) );
-}
-
-
 /*---------------------------------------------------------------------------------------------
 	Interpolation
 ---------------------------------------------------------------------------------------------*/
@@ -36,7 +36,7 @@ public:
 	CQuaternion() {}
 
 	// Construct by value - four floats
-	CQuaternion
+	constexpr CQuaternion
 	(
 		const TFloat32 initW,
 		const TFloat32 initX,
@@ -45,7 +45,7 @@ public:
 	) : w( initW ), x( initX ), y( initY ), z( initZ ) {}
 
 	// Construct by value - float and CVector3
-	CQuaternion
+	constexpr CQuaternion
 	(
 		const TFloat32 initW,
 		const CVector3 initV
@@ -53,16 +53,16 @@ public:
 
 	// Construct through pointer to four floats
 	// Specifying explicit avoids defining an implicit conversion
-	explicit CQuaternion
+	explicit constexpr CQuaternion
 	(
 		const TFloat32* pWXYZ
 	) : w( pWXYZ[0] ), x( pWXYZ[1] ), y( pWXYZ[2] ), z( pWXYZ[3] ) {}
 
  	// Construct from a CVector3 - w value becomes 0
-	explicit CQuaternion
+	explicit constexpr CQuaternion
 	(
 		const CVector3& src
-	) : w( 0.0f ), x( src.x ), y( src.y ), z( src.z ) {};
+	) : w( 0.0f ), x( src.x ), y( src.y ), z( src.z ) {}
 
  	// Construct from a CMatrix4x4 - uses upper left 3x3 only
 	explicit CQuaternion
@@ -72,13 +72,13 @@ public:
 
 
 	// Copy constructor
-    CQuaternion
+    constexpr CQuaternion
 	(
 		const CQuaternion& src
 	) : w( src.w ), x( src.x ), y( src.y ), z( src.z ) {}
 
 	// Assignment operator
-    CQuaternion& operator=
+    constexpr CQuaternion& operator=
 	(
 		const CQuaternion& src
 	)
@@ -93,8 +93,6 @@ public:
 		return *this;
 	}
 
-	// Destructor
-	~CQuaternion() {}
 
 
 	/*-----------------------------------------------------------------------------------------
@@ -247,7 +245,7 @@ public:
 	// Addition / subtraction
 
 	// Add another quaternion to this quaternion
-    CQuaternion& operator+=
+    constexpr CQuaternion& operator+=
 	(
 		const CQuaternion& quat
 	)
@@ -260,7 +258,7 @@ public:
 	}
 
 	// Subtract another quaternion from this quaternion
-    CQuaternion& operator-=
+    constexpr CQuaternion& operator-=
 	(
 		const CQuaternion& quat
 	)
@@ -277,7 +275,7 @@ public:
 	// Scalar multiplication & division
 
 	// Multiply this quaternion by a scalar
-	CQuaternion& operator*=
+	constexpr CQuaternion& operator*=
 	(
 		const TFloat32 scalar
 	)
@@ -307,14 +305,14 @@ public:
 	// Quaternion multiplication
 
 	// Binary form as friend to define function below
-	friend CQuaternion operator*
+	friend constexpr CQuaternion operator*
 	(
 		const CQuaternion& quat1,
 		const CQuaternion& quat2
 	);
 
 	// Multiply this quaternion by another
-    CQuaternion& operator*=
+    constexpr CQuaternion& operator*=
 	(
 		const CQuaternion& quat
 	)
@@ -328,7 +326,7 @@ public:
 	// Other operations
 
 	// Dot product of this with another quaternion
-    TFloat32 Dot
+    constexpr TFloat32 Dot
 	(
 		const CQuaternion& quat
 	) const
@@ -349,7 +347,7 @@ public:
 	}
 
 	// Return squared norm of this quaternion
-	TFloat32 NormSquared() const
+	constexpr TFloat32 NormSquared() const
 	{
 		return w*w + x*x + y*y + z*z;
 	}
@@ -363,7 +361,7 @@ public:
 	-----------------------------------------------------------------------------------------*/
 
 	// Set this quaternion to its inverse
-	void SetInverse()
+	constexpr void SetInverse()
 	{
 		x = -x;
 		y = -y;
@@ -371,7 +369,7 @@ public:
 	}
 
 	// Return the inverse of this quaternion
-	CQuaternion Inverse() const
+	constexpr CQuaternion Inverse() const
 	{
 		return CQuaternion( w, -x, -y, -z );
 	}
@@ -382,7 +380,7 @@ public:
 	-----------------------------------------------------------------------------------------*/
 
 	// Rotate a CVector3 by this quaternion
-	CVector3 Rotate
+	constexpr CVector3 Rotate
 	(
 		const CVector3& vec
 	) const;
@@ -438,7 +436,7 @@ inline bool operator!=
 // Addition / subtraction
 
 // Quaternion addition
-inline CQuaternion operator+
+constexpr CQuaternion operator+
 (
 	const CQuaternion& quat1,
 	const CQuaternion& quat2
@@ -448,7 +446,7 @@ inline CQuaternion operator+
 }
 
 // Quaternion subtraction
-inline CQuaternion operator-
+constexpr CQuaternion operator-
 (
 	const CQuaternion& quat1,
 	const CQuaternion& quat2
@@ -458,7 +456,7 @@ inline CQuaternion operator-
 }
 
 // Unary positive (for completeness)
-inline CQuaternion operator+
+constexpr CQuaternion operator+
 (
 	const CQuaternion& quat
 )
@@ -467,7 +465,7 @@ inline CQuaternion operator+
 }
 
 // Unary negation
-inline CQuaternion operator-
+constexpr CQuaternion operator-
 (
 	const CQuaternion& quat
 )
@@ -480,7 +478,7 @@ inline CQuaternion operator-
 // Scalar multiplication & division
 
 // Quaternion multiplied by scalar
-inline CQuaternion operator*
+constexpr CQuaternion operator*
 (
 	const CQuaternion& quat,
 	const TFloat32     scalar
@@ -490,7 +488,7 @@ inline CQuaternion operator*
 }
 
 // Scalar multiplied by quaternion
-inline CQuaternion operator*
+constexpr CQuaternion operator*
 (
 	const TFloat32     scalar,
 	const CQuaternion& quat
@@ -514,18 +512,78 @@ inline CQuaternion operator/
 // Quaternion multiplication
 
 // Return the quaternion result of multiplying two quaternions
-CQuaternion operator*
+constexpr CQuaternion operator*
 (
 	const CQuaternion& quat1,
 	const CQuaternion& quat2
-);
+)
+{
+	// Vector parts are copied rather than accessed with Vector() so this can be constexpr
+	const CVector3 v1( quat1.x, quat1.y, quat1.z );
+	const CVector3 v2( quat2.x, quat2.y, quat2.z );
+
+	return CQuaternion( quat1.w*quat2.w - Dot( v1, v2 ), quat1.w*v2 + quat2.w*v1 + Cross( v2, v1 ) );
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Vector transformation
+-----------------------------------------------------------------------------------------*/
+
+// Rotate a CVector3 by this quaternion
+constexpr CVector3 CQuaternion::Rotate
+(
+	const CVector3& p
+) const
+{
+	const CVector3 v( x, y, z );
+
+	const TFloat32 tmp = 2.0f*w;
+	return (tmp*w-1.0f)*p + (2.0f*gen::Dot( v, p ))*v + tmp*Cross( v, p );
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Matrix construction
+-----------------------------------------------------------------------------------------*/
+
+// Construct affine transformation from quaternion and optional position & scaling, with 
+// remaining elements taken from the identity matrix - declared in CMatrix4x4.h, defined here as
+// it needs the complete CQuaternion class. Upper 3x3 combines scaling with rotation values from
+// the quaternion
+// Matrix is effectively built in this order: M = Scale*Rotation*Translation
+constexpr CMatrix4x4::CMatrix4x4
+(
+	const CQuaternion& quat,
+	const CVector3&    position /*= CVector3::kOrigin*/,
+	const CVector3&    scale /*= CVector3::kOne*/
+) : CMatrix4x4
+	(
+		scale.x * (1 - 2*quat.y*quat.y - 2*quat.z*quat.z),
+		scale.x * (2*quat.x*quat.y + quat.w*(2*quat.z)),
+		scale.x * (2*quat.z*quat.x - quat.w*(2*quat.y)),
+		0.0f,
+
+		scale.y * (2*quat.x*quat.y - quat.w*(2*quat.z)),
+		scale.y * (1 - 2*quat.x*quat.x - 2*quat.z*quat.z),
+		scale.y * (2*quat.y*quat.z + quat.w*(2*quat.x)),
+		0.0f,
+
+		scale.z * (2*quat.z*quat.x + quat.w*(2*quat.y)),
+		scale.z * (2*quat.y*quat.z - quat.w*(2*quat.x)),
+		scale.z * (1 - 2*quat.x*quat.x - 2*quat.y*quat.y),
+		0.0f,
+
+		position.x, position.y, position.z, 1.0f
+	)
+{}
 
 
 ////////////////////////////////////
 // Other operations
 
 // Dot product of two given quaternions (order not important) - non-member version
-inline TFloat32 Dot
+constexpr TFloat32 Dot
 (
 	const CQuaternion& quat1,
 	const CQuaternion& quat2
@@ -549,7 +607,7 @@ inline TFloat32 Norm
 }
 
 // Return squared norm of a quaternion - non-member version
-inline TFloat32 NormSquared
+constexpr TFloat32 NormSquared
 (
 	const CQuaternion& quat
 )
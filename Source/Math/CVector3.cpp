@@ -140,5 +140,10 @@ const CVector3 CVector3::kXAxis(1.0f, 0.0f, 0.0f);
 const CVector3 CVector3::kYAxis(0.0f, 1.0f, 0.0f);
 const CVector3 CVector3::kZAxis(0.0f, 0.0f, 1.0f);
 
+// Check vector construction and arithmetic can be evaluated at compile time
+static_assert( Dot( Cross( CVector3( 1.0f, 0.0f, 0.0f ), CVector3( 0.0f, 1.0f, 0.0f ) ) * 2.0f -
+                    CVector3( 0.0f, 0.0f, 1.0f ), CVector3( 0.0f, 0.0f, 1.0f ) ) == 1.0f,
+               "CVector3 operations must be constexpr" );
+
 
 } // namespace gen
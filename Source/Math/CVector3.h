@@ -39,10 +39,12 @@ public:
 	-----------------------------------------------------------------------------------------*/
 
 	// Default constructor - leaves values uninitialised (for performance)
+	// The other constructors and most operations are constexpr, so vectors can be built and
+	// combined at compile time. Division is not, as it checks for a zero divisor
 	CVector3() {}
 
 	// Construct by value
-	CVector3
+	constexpr CVector3
 	(
 		const TFloat32 xIn,
 		const TFloat32 yIn,
@@ -68,7 +70,7 @@ public:
 
 
 	// Construct as vector between two points (p1 to p2)
-	CVector3
+	constexpr CVector3
 	(
 		const CVector3& p1,
 		const CVector3& p2
@@ -77,7 +79,7 @@ public:
 
 
 	// Construct from a CVector2 and a z value (defaults to 0)
-	explicit CVector3
+	explicit constexpr CVector3
 	(
 		const CVector2& v,
 		const TFloat32 zIn = 0.0f
@@ -91,11 +93,11 @@ public:
 
 
 	// Copy constructor, construct from CVector3
-    CVector3( const CVector3& v ) : x( v.x ), y( v.y ), z( v.z )
+    constexpr CVector3( const CVector3& v ) : x( v.x ), y( v.y ), z( v.z )
 	{}
 
 	// Assignment operator
-    CVector3& operator=( const CVector3& v )
+    constexpr CVector3& operator=( const CVector3& v )
 	{
 		if ( this != &v )
 		{
@@ -218,7 +220,7 @@ public:
 	// Addition / subtraction
 
 	// Add another vector to this vector
-    CVector3& operator+=( const CVector3& v )
+    constexpr CVector3& operator+=( const CVector3& v )
 	{
 		x += v.x;
 		y += v.y;
@@ -227,7 +229,7 @@ public:
 	}
 
 	// Subtract another vector from this vector
-    CVector3& operator-=( const CVector3& v )
+    constexpr CVector3& operator-=( const CVector3& v )
 	{
 		x -= v.x;
 		y -= v.y;
@@ -240,7 +242,7 @@ public:
 	// Scalar multiplication & division
 
 	// Multiply this vector by a scalar
-	CVector3& operator*=( const TFloat32 s )
+	constexpr CVector3& operator*=( const TFloat32 s )
 	{
 		x *= s;
 		y *= s;
@@ -267,14 +269,14 @@ public:
 	// Other operations
 
 	// Dot product of this with another vector
-    TFloat32 Dot( const CVector3& v ) const
+    constexpr TFloat32 Dot( const CVector3& v ) const
 	{
 	    return x*v.x + y*v.y + z*v.z;
 	}
 	
 	
 	// Cross product of this with another vector
-    CVector3 Cross( const CVector3& v ) const
+    constexpr CVector3 Cross( const CVector3& v ) const
 	{
 		return CVector3(y*v.z - z*v.y, z*v.x - x*v.z, x*v.y - y*v.x);
 	}
@@ -294,7 +296,7 @@ public:
 	// Return squared length of this vector
 	// More efficient than Length when exact value is not required (e.g. for comparisons)
 	// Use InvSqrt( LengthSquared(...) ) to calculate 1 / length more efficiently
-	TFloat32 LengthSquared() const
+	constexpr TFloat32 LengthSquared() const
 	{
 		return x*x + y*y + z*z;
 	}
@@ -326,7 +328,9 @@ public:
 	TFloat32 y;
 	TFloat32 z;
 
-	// Standard vectors
+	// Standard vectors. Constant initialised as the constructors are constexpr, so they are safe
+	// to use when initialising other globals. Not usable in constant expressions themselves -
+	// construct the vector directly for that, e.g. CVector3( 0.0f, 1.0f, 0.0f )
 	static const CVector3 kZero;
 	static const CVector3 kOne;
 	static const CVector3 kOrigin;
@@ -370,7 +374,7 @@ inline bool operator!=
 // Addition / subtraction
 
 // Vector addition
-inline CVector3 operator+
+constexpr CVector3 operator+
 (
 	const CVector3& v1,
 	const CVector3& v2
@@ -380,7 +384,7 @@ inline CVector3 operator+
 }
 
 // Vector subtraction
-inline CVector3 operator-
+constexpr CVector3 operator-
 (
 	const CVector3& v1,
 	const CVector3& v2
@@ -390,13 +394,13 @@ inline CVector3 operator-
 }
 
 // Unary positive (i.e. a = +v, included for completeness)
-inline CVector3 operator+( const CVector3& v )
+constexpr CVector3 operator+( const CVector3& v )
 {
 	return v;
 }
 
 // Unary negation (i.e. a = -v)
-inline CVector3 operator-( const CVector3& v )
+constexpr CVector3 operator-( const CVector3& v )
 {
 	return CVector3(-v.x, -v.y, -v.z);
 }
@@ -406,7 +410,7 @@ inline CVector3 operator-( const CVector3& v )
 // Scalar multiplication & division
 
 // Vector multiplied by scalar
-inline CVector3 operator*
+constexpr CVector3 operator*
 (
 	const CVector3& v,
 	const TFloat32  s
@@ -416,7 +420,7 @@ inline CVector3 operator*
 }
 
 // Scalar multiplied by vector
-inline CVector3 operator*
+constexpr CVector3 operator*
 (
 	const TFloat32  s,
 	const CVector3& v
@@ -445,7 +449,7 @@ inline CVector3 operator/
 // Other operations
 
 // Dot product of two given vectors (order not important) - non-member version
-inline TFloat32 Dot
+constexpr TFloat32 Dot
 (
 	const CVector3& v1,
 	const CVector3& v2
@@ -455,7 +459,7 @@ inline TFloat32 Dot
 }
 
 // Cross product of two given vectors (order is important) - non-member version
-inline CVector3 Cross
+constexpr CVector3 Cross
 (
 	const CVector3& v1,
 	const CVector3& v2
@@ -478,7 +482,7 @@ inline TFloat32 Length( const CVector3& v )
 // Return squared length of given vector
 // More efficient than Length when exact value is not required (e.g. for comparisons)
 // Use InvSqrt( LengthSquared(...) ) to calculate 1 / length more efficiently
-inline TFloat32 LengthSquared( const CVector3& v )
+constexpr TFloat32 LengthSquared( const CVector3& v )
 {
 	return v.x*v.x + v.y*v.y + v.z*v.z;
 }
@@ -507,6 +511,45 @@ TFloat32 DistanceSquared
 	const CVector3& p2
 );
 
+// Return squared distance from one point to another ignoring the y coordinates, i.e. the distance
+// measured on the ground (XZ) plane
+constexpr TFloat32 DistanceSquaredXZ
+(
+	const CVector3& p1,
+	const CVector3& p2
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distZ = p1.z - p2.z;
+	return distX*distX + distZ*distZ;
+}
+
+// Return true if two points are closer than the given distance. Compares squared distances so
+// no square root is needed
+constexpr bool IsWithinDistance
+(
+	const CVector3& p1,
+	const CVector3& p2,
+	const TFloat32  distance
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distY = p1.y - p2.y;
+	TFloat32 distZ = p1.z - p2.z;
+	return distX*distX + distY*distY + distZ*distZ < distance*distance;
+}
+
+// Return true if two points are closer than the given distance on the ground (XZ) plane
+constexpr bool IsWithinDistanceXZ
+(
+	const CVector3& p1,
+	const CVector3& p2,
+	const TFloat32  distance
+)
+{
+	return DistanceSquaredXZ( p1, p2 ) < distance*distance;
+}
+
 
 } // namespace gen
 
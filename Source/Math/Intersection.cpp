@@ -0,0 +1,217 @@
+/**************************************************************************************************
+	Module:       Intersection.cpp
+
+	Intersection tests between geometric primitives, including swept tests of a point moving
+	along a line segment against a shape
+**************************************************************************************************/
+
+#include "Intersection.h"
+#include "BaseMath.h"
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Static tests
+-----------------------------------------------------------------------------------------*/
+
+// Return the point inside the given axis-aligned bounding box nearest to the given point
+CVector3 ClosestPointAABB
+(
+	const CVector3& point,
+	const CVector3& minBounds,
+	const CVector3& maxBounds
+)
+{
+	// Clamp each coordinate to the box
+	CVector3 closest;
+	for (TUInt32 iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		TFloat32 fCoord = point[iAxis];
+		if (fCoord < minBounds[iAxis]) fCoord = minBounds[iAxis];
+		if (fCoord > maxBounds[iAxis]) fCoord = maxBounds[iAxis];
+		closest[iAxis] = fCoord;
+	}
+	return closest;
+}
+
+// Test if a sphere intersects the given axis-aligned bounding box
+bool SphereAABB
+(
+	const CVector3& centre,
+	const TFloat32  fRadius,
+	const CVector3& minBounds,
+	const CVector3& maxBounds
+)
+{
+	// Intersects if the nearest point in the box is within the sphere
+	CVector3 closest = ClosestPointAABB( centre, minBounds, maxBounds );
+	return DistanceSquared( centre, closest ) <= fRadius * fRadius;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Swept tests
+-----------------------------------------------------------------------------------------*/
+
+// Test if the line segment from start to end intersects the given sphere, setting pfT to the
+// fraction along the segment of the first point of contact
+bool SegmentSphere
+(
+	const CVector3& start,
+	const CVector3& end,
+	const CVector3& centre,
+	const TFloat32  fRadius,
+	TFloat32*       pfT /*= 0*/
+)
+{
+	// Points on the segment are start + t * dir, for t from 0 to 1. Such a point is on the
+	// sphere when |start + t * dir - centre|^2 = radius^2, which is a quadratic in t:
+	//     a t^2 + 2b t + c = 0,  where a = dir.dir, b = offset.dir, c = offset.offset - radius^2
+	// and offset = start - centre
+	CVector3 dir = end - start;
+	CVector3 offset = start - centre;
+	TFloat32 fC = Dot( offset, offset ) - fRadius * fRadius;
+	if (fC <= 0.0f)
+	{
+		// Segment starts inside the sphere
+		if (pfT) *pfT = 0.0f;
+		return true;
+	}
+
+	// Start is outside the sphere, so no contact if the point is not moving or is moving away
+	TFloat32 fB = Dot( offset, dir );
+	TFloat32 fA = Dot( dir, dir );
+	if (fB >= 0.0f || fA == 0.0f)
+	{
+		return false;
+	}
+
+	// No real roots means the line misses the sphere
+	TFloat32 fDiscriminant = fB * fB - fA * fC;
+	if (fDiscriminant < 0.0f)
+	{
+		return false;
+	}
+
+	// The smaller root is the first contact, which must be before the end of the segment. It
+	// can't be before the start as the start is outside the sphere and moving towards it
+	TFloat32 fT = (-fB - Sqrt( fDiscriminant )) / fA;
+	if (fT > 1.0f)
+	{
+		return false;
+	}
+	if (pfT) *pfT = fT;
+	return true;
+}
+
+
+// Test if the line segment from start to end intersects the given axis-aligned bounding box,
+// setting pfT to the fraction along the segment of the first point of contact
+bool SegmentAABB
+(
+	const CVector3& start,
+	const CVector3& end,
+	const CVector3& minBounds,
+	const CVector3& maxBounds,
+	TFloat32*       pfT /*= 0*/
+)
+{
+	// The box is the space between three pairs of planes (slabs), one pair per axis. Find the
+	// range of t for which the segment is between each pair of planes - the segment is inside
+	// the box for the overlap of these ranges. The segment hits the box if the overlap is not
+	// empty, and the first contact is at the start of the overlap
+	TFloat32 fTMin = 0.0f;
+	TFloat32 fTMax = 1.0f;
+	for (TUInt32 iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		TFloat32 fStart = start[iAxis];
+		TFloat32 fDir = end[iAxis] - fStart;
+		if (fDir == 0.0f)
+		{
+			// Segment is parallel to this pair of planes, no contact unless it is between them
+			if (fStart < minBounds[iAxis] || fStart > maxBounds[iAxis])
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// Range of t between the planes - swap if moving in the negative direction
+			TFloat32 fInvDir = 1.0f / fDir;
+			TFloat32 fTNear = (minBounds[iAxis] - fStart) * fInvDir;
+			TFloat32 fTFar = (maxBounds[iAxis] - fStart) * fInvDir;
+			if (fTNear > fTFar)
+			{
+				TFloat32 fTemp = fTNear;
+				fTNear = fTFar;
+				fTFar = fTemp;
+			}
+
+			if (fTNear > fTMin) fTMin = fTNear;
+			if (fTFar < fTMax) fTMax = fTFar;
+			if (fTMin > fTMax)
+			{
+				return false;
+			}
+		}
+	}
+
+	if (pfT) *pfT = fTMin;
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Batched swept tests
+-----------------------------------------------------------------------------------------*/
+
+// Perform a batch of segment / sphere tests, test i is between segment aiSegments[i] and the
+// sphere aCentres[i], afRadii[i]. Contact fractions are written to afT, kfNoIntersection for a miss
+void SegmentSphereBatch
+(
+	const CVector3* aStarts,
+	const CVector3* aEnds,
+	const TUInt32*  aiSegments,
+	const CVector3* aCentres,
+	const TFloat32* afRadii,
+	const TUInt32   iNumTests,
+	TFloat32*       afT
+)
+{
+	for (TUInt32 iTest = 0; iTest < iNumTests; ++iTest)
+	{
+		TUInt32 iSegment = aiSegments[iTest];
+		if (!SegmentSphere( aStarts[iSegment], aEnds[iSegment], aCentres[iTest], afRadii[iTest],
+		                    &afT[iTest] ))
+		{
+			afT[iTest] = kfNoIntersection;
+		}
+	}
+}
+
+// Perform a batch of segment / box tests, test i is between segment aiSegments[i] and the box.
+// Contact fractions are written to afT, kfNoIntersection for a miss
+void SegmentAABBBatch
+(
+	const CVector3* aStarts,
+	const CVector3* aEnds,
+	const TUInt32*  aiSegments,
+	const TUInt32   iNumTests,
+	const CVector3& minBounds,
+	const CVector3& maxBounds,
+	TFloat32*       afT
+)
+{
+	for (TUInt32 iTest = 0; iTest < iNumTests; ++iTest)
+	{
+		TUInt32 iSegment = aiSegments[iTest];
+		if (!SegmentAABB( aStarts[iSegment], aEnds[iSegment], minBounds, maxBounds, &afT[iTest] ))
+		{
+			afT[iTest] = kfNoIntersection;
+		}
+	}
+}
+
+
+} // namespace gen
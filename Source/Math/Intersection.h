@@ -0,0 +1,130 @@
+/**************************************************************************************************
+	Module:       Intersection.h
+
+	Intersection tests between geometric primitives. Includes swept tests, where a point moving
+	along a line segment (e.g. a projectile's movement over one frame) is tested against a shape,
+	giving the first point of contact. These tests don't miss fast moving points that pass right
+	through a shape between frames, as testing only the end positions would
+
+	Batched versions of the swept tests take arrays of segments, so many moving points can be
+	tested in a single call
+**************************************************************************************************/
+
+#ifndef GEN_INTERSECTION_H_INCLUDED
+#define GEN_INTERSECTION_H_INCLUDED
+
+#include "Defines.h"
+#include "CVector3.h"
+
+namespace gen
+{
+
+// Contact fraction given by the batched tests below for segments that do not hit their shape.
+// Larger than any real contact fraction (which are 0 to 1), so the nearest hit is the smallest
+const TFloat32 kfNoIntersection = 3.402823466e+38f;
+
+
+/*-----------------------------------------------------------------------------------------
+	Static tests
+-----------------------------------------------------------------------------------------*/
+
+// Test if a point is inside the given axis-aligned bounding box (inclusive of the faces)
+inline bool PointAABB
+(
+	const CVector3& point,
+	const CVector3& minBounds,
+	const CVector3& maxBounds
+)
+{
+	return point.x >= minBounds.x && point.x <= maxBounds.x &&
+	       point.y >= minBounds.y && point.y <= maxBounds.y &&
+	       point.z >= minBounds.z && point.z <= maxBounds.z;
+}
+
+// Return the point inside the given axis-aligned bounding box nearest to the given point. Returns
+// the point itself if it is inside the box
+CVector3 ClosestPointAABB
+(
+	const CVector3& point,
+	const CVector3& minBounds,
+	const CVector3& maxBounds
+);
+
+// Test if a sphere intersects the given axis-aligned bounding box
+bool SphereAABB
+(
+	const CVector3& centre,
+	const TFloat32  fRadius,
+	const CVector3& minBounds,
+	const CVector3& maxBounds
+);
+
+
+/*-----------------------------------------------------------------------------------------
+	Swept tests
+-----------------------------------------------------------------------------------------*/
+
+// Test if the line segment from start to end intersects the given sphere. If it does, returns
+// true and sets pfT (if given) to the fraction along the segment of the first point of contact,
+// from 0 (contact at start) to 1 (contact at end). A segment starting inside the sphere gives 0
+bool SegmentSphere
+(
+	const CVector3& start,
+	const CVector3& end,
+	const CVector3& centre,
+	const TFloat32  fRadius,
+	TFloat32*       pfT = 0
+);
+
+// Test if the line segment from start to end intersects the given axis-aligned bounding box. If
+// it does, returns true and sets pfT (if given) to the fraction along the segment of the first
+// point of contact, from 0 to 1. A segment starting inside the box gives 0
+bool SegmentAABB
+(
+	const CVector3& start,
+	const CVector3& end,
+	const CVector3& minBounds,
+	const CVector3& maxBounds,
+	TFloat32*       pfT = 0
+);
+
+
+/*-----------------------------------------------------------------------------------------
+	Batched swept tests
+-----------------------------------------------------------------------------------------*/
+
+// Perform a batch of segment / sphere tests. The segments are given as arrays of start and end
+// points. Each test is between the segment with index aiSegments[i] and the sphere with centre
+// aCentres[i] and radius afRadii[i], so a segment can be tested against any number of spheres
+// (e.g. those found near it by a broad-phase search). The contact fraction of each test is
+// written to afT[i], or kfNoIntersection if the segment misses the sphere
+void SegmentSphereBatch
+(
+	const CVector3* aStarts,
+	const CVector3* aEnds,
+	const TUInt32*  aiSegments,
+	const CVector3* aCentres,
+	const TFloat32* afRadii,
+	const TUInt32   iNumTests,
+	TFloat32*       afT
+);
+
+// Test a batch of segments against one axis-aligned bounding box. The segments are given as
+// arrays of start and end points, and test i is of the segment with index aiSegments[i], so any
+// subset of the segments can be tested (e.g. those that reached a node in a BVH). The contact
+// fraction of each test is written to afT[i], or kfNoIntersection if the segment misses the box
+void SegmentAABBBatch
+(
+	const CVector3* aStarts,
+	const CVector3* aEnds,
+	const TUInt32*  aiSegments,
+	const TUInt32   iNumTests,
+	const CVector3& minBounds,
+	const CVector3& maxBounds,
+	TFloat32*       afT
+);
+
+
+} // namespace gen
+
+#endif // GEN_INTERSECTION_H_INCLUDED
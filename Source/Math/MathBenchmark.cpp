@@ -0,0 +1,147 @@
+/**************************************************************************************************
+	Module:       MathBenchmark.cpp
+
+	Benchmark comparing the fast approximate math functions in BaseMath.h (FastInvSqrt, FastSin
+	etc.) against the exact versions, measuring both their speed and their error
+**************************************************************************************************/
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#include "MathBenchmark.h"
+#include "BaseMath.h"
+#include "CTimer.h"
+
+namespace gen
+{
+
+namespace
+{
+	// Function objects calling the exact and fast versions of each function, so the calls can be
+	// inlined into the timing loops. The ATan objects take a parameter t in [-4,4] giving a point
+	// (2-|t|, t) that moves around a diamond centred on the origin, covering all four quadrants
+	struct SInvSqrt     { TFloat32 operator()( TFloat32 x ) const { return InvSqrt( x ); } };
+	struct SFastInvSqrt { TFloat32 operator()( TFloat32 x ) const { return FastInvSqrt( x ); } };
+	struct SSin         { TFloat32 operator()( TFloat32 x ) const { return Sin( x ); } };
+	struct SFastSin     { TFloat32 operator()( TFloat32 x ) const { return FastSin( x ); } };
+	struct SCos         { TFloat32 operator()( TFloat32 x ) const { return Cos( x ); } };
+	struct SFastCos     { TFloat32 operator()( TFloat32 x ) const { return FastCos( x ); } };
+	struct SACos        { TFloat32 operator()( TFloat32 x ) const { return ACos( x ); } };
+	struct SFastACos    { TFloat32 operator()( TFloat32 x ) const { return FastACos( x ); } };
+	struct SATan        { TFloat32 operator()( TFloat32 t ) const { return ATan( t, 2.0f - Abs( t ) ); } };
+	struct SFastATan    { TFloat32 operator()( TFloat32 t ) const { return FastATan( t, 2.0f - Abs( t ) ); } };
+
+	// Sum of the results is written here so the compiler can't remove the timing loops
+	volatile TFloat32 vfResultSink;
+
+
+	// Time the given function over the input values, writing its results to the output array.
+	// Returns the time taken in seconds
+	template <class TFunction>
+	TFloat32 TimeFunction
+	(
+		TFunction               function,
+		const vector<TFloat32>& afInputs,
+		vector<TFloat32>&       afOutputs
+	)
+	{
+		CTimer timer;
+		timer.Start();
+		TFloat32 fSum = 0.0f;
+		for (TUInt32 i = 0; i < afInputs.size(); ++i)
+		{
+			afOutputs[i] = function( afInputs[i] );
+			fSum += afOutputs[i];
+		}
+		TFloat32 fTime = timer.GetLapTime();
+		vfResultSink = fSum;
+		return fTime;
+	}
+
+	// Measure an exact and a fast function over values evenly spaced from fMin to fMax. Errors
+	// are relative to the exact results if bRelative is set, otherwise absolute. Angles that
+	// differ by almost 2pi (i.e. either side of the -pi/pi join) are treated as equal
+	template <class TExact, class TFast>
+	void RunFastMathBenchmark
+	(
+		const char*               sFunction,
+		TExact                    exact,
+		TFast                     fast,
+		const TUInt32             iNumValues,
+		const TFloat32            fMin,
+		const TFloat32            fMax,
+		const bool                bRelative,
+		SFastMathBenchmarkResult* pResult
+	)
+	{
+		vector<TFloat32> afInputs( iNumValues ), afExact( iNumValues ), afFast( iNumValues );
+		for (TUInt32 i = 0; i < iNumValues; ++i)
+		{
+			afInputs[i] = fMin + (fMax - fMin) * (i + 1) / iNumValues;
+		}
+
+		pResult->sFunction = sFunction;
+		pResult->fExactTime = TimeFunction( exact, afInputs, afExact );
+		pResult->fFastTime = TimeFunction( fast, afInputs, afFast );
+
+		pResult->fMaxError = 0.0f;
+		for (TUInt32 i = 0; i < iNumValues; ++i)
+		{
+			TFloat32 fError = Abs( afFast[i] - afExact[i] );
+			if (bRelative)
+			{
+				fError /= Abs( afExact[i] );
+			}
+			else if (fError > kfPi)
+			{
+				fError = Abs( fError - 2.0f * kfPi );
+			}
+			pResult->fMaxError = Max( pResult->fMaxError, fError );
+		}
+	}
+}
+
+
+// Run each exact and fast function over the given number of values covering its typical input
+// range. Results are written to the given array, one per function
+void BenchmarkFastMath
+(
+	const TUInt32            iNumValues,
+	SFastMathBenchmarkResult aResults[kiNumFastMathBenchmarks]
+)
+{
+	GEN_GUARD;
+
+	GEN_ASSERT( iNumValues > 0, "Invalid number of values for benchmark" );
+
+	RunFastMathBenchmark( "InvSqrt / FastInvSqrt", SInvSqrt(), SFastInvSqrt(), iNumValues,
+	                      0.0f, 1000.0f, true, &aResults[0] );
+	RunFastMathBenchmark( "Sin / FastSin", SSin(), SFastSin(), iNumValues,
+	                      -100.0f, 100.0f, false, &aResults[1] );
+	RunFastMathBenchmark( "Cos / FastCos", SCos(), SFastCos(), iNumValues,
+	                      -100.0f, 100.0f, false, &aResults[2] );
+	RunFastMathBenchmark( "ACos / FastACos", SACos(), SFastACos(), iNumValues,
+	                      -1.0f, 1.0f, false, &aResults[3] );
+	RunFastMathBenchmark( "ATan / FastATan", SATan(), SFastATan(), iNumValues,
+	                      -4.0f, 4.0f, false, &aResults[4] );
+
+	GEN_ENDGUARD;
+}
+
+
+// Output the given fast math benchmark results to the console
+void OutputFastMathBenchmark( const SFastMathBenchmarkResult aResults[kiNumFastMathBenchmarks] )
+{
+	cout << "Fast Math Benchmark:" << endl << endl;
+	for (TUInt32 i = 0; i < kiNumFastMathBenchmarks; ++i)
+	{
+		cout << aResults[i].sFunction << ": exact " << aResults[i].fExactTime
+		     << "s, fast " << aResults[i].fFastTime << "s, max error "
+		     << aResults[i].fMaxError << endl;
+	}
+	cout << endl;
+}
+
+
+} // namespace gen
@@ -0,0 +1,44 @@
+/**************************************************************************************************
+	Module:       MathBenchmark.h
+
+	Benchmark comparing the fast approximate math functions in BaseMath.h (FastInvSqrt, FastSin
+	etc.) against the exact versions, measuring both their speed and their error
+**************************************************************************************************/
+
+#ifndef GEN_MATH_BENCHMARK_H_INCLUDED
+#define GEN_MATH_BENCHMARK_H_INCLUDED
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// Result for one function from the fast math benchmark
+struct SFastMathBenchmarkResult
+{
+	const char* sFunction;  // Names of the exact and fast functions compared
+	TFloat32    fExactTime; // Time for the exact function over all the values (seconds)
+	TFloat32    fFastTime;  // Time for the fast function over all the values (seconds)
+	TFloat32    fMaxError;  // Largest error of the fast function - relative for InvSqrt,
+	                        // absolute (radians or unitless) for the others
+};
+
+// Number of functions measured by the benchmark - InvSqrt, Sin, Cos, ACos and ATan
+const TUInt32 kiNumFastMathBenchmarks = 5;
+
+// Run each exact and fast function over the given number of values covering its typical input
+// range: (0,1000] for InvSqrt, [-100,100] for Sin and Cos, [-1,1] for ACos and points in all four
+// quadrants for ATan. Results are written to the given array, one per function
+void BenchmarkFastMath
+(
+	const TUInt32            iNumValues,
+	SFastMathBenchmarkResult aResults[kiNumFastMathBenchmarks]
+);
+
+// Output the given fast math benchmark results to the console
+void OutputFastMathBenchmark( const SFastMathBenchmarkResult aResults[kiNumFastMathBenchmarks] );
+
+
+} // namespace gen
+
+#endif // GEN_MATH_BENCHMARK_H_INCLUDED
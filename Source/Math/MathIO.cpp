@@ -3,7 +3,8 @@
 	Author:       Laurent Noel
 	Date created: 11/07/07
 
-	Support for stream input and output for math classes
+	Support for stream input and output for math classes, and for allocation-free text and binary
+	encoding of math classes into caller-supplied buffers
 
 	Copyright 2007, University of Central Lancashire and Laurent Noel
 
@@ -12,9 +13,14 @@
 **************************************************************************************************/
 
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
 using namespace std;
 
 #include "Defines.h"
+#include "BaseMath.h"
 #include "CVector2.h"
 #include "CVector3.h"
 #include "CVector4.h"
@@ -22,6 +28,8 @@ using namespace std;
 #include "CMatrix3x3.h"
 #include "CMatrix4x4.h"
 #include "CQuaternion.h"
+#include "CQuatTransform.h"
+#include "MathIO.h"
 
 namespace gen
 {
@@ -278,5 +286,1143 @@ istream& operator>>( istream& s, CQuaternion& v )
 	return s;
 }
 
+/*---------------------------------------------------------------------------------------------
+	Float text encoding
+---------------------------------------------------------------------------------------------*/
+
+namespace
+{
+	// Powers of ten as doubles, covering the scaling needed for the whole float range. The
+	// literals are correctly rounded by the compiler, and exact up to 1e22
+	const TInt32 kiMaxPow10 = 70;
+	const TFloat64 kafPow10[kiMaxPow10 + 1] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,
+		1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+		1e20, 1e21, 1e22, 1e23, 1e24, 1e25, 1e26, 1e27, 1e28, 1e29,
+		1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37, 1e38, 1e39,
+		1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47, 1e48, 1e49,
+		1e50, 1e51, 1e52, 1e53, 1e54, 1e55, 1e56, 1e57, 1e58, 1e59,
+		1e60, 1e61, 1e62, 1e63, 1e64, 1e65, 1e66, 1e67, 1e68, 1e69,
+		1e70
+	};
+
+	// Largest number of significant digits needed to uniquely identify any float
+	const TUInt32 kiMaxFloatDigits = 9;
+
+	// Most significant digits kept when reading decimal text. Any midpoint between two floats has
+	// at most 113 significant digits, so with this many the decimal can be compared exactly with
+	// the midpoints that decide its rounding. Further digits are only noted as being nonzero
+	const TUInt32 kiMaxDecimalDigits = 120;
+
+	// Largest float as a double, and the midpoint between it and 2^128 (where the next float would
+	// be if the exponent range were larger). Numbers above the midpoint round to infinity, as does
+	// the midpoint itself (ties round to even)
+	const TFloat64 kfFloatMax = 3.4028234663852886e38;
+	const TFloat64 kfFloatOverflow = 3.4028235677973366e38;
+
+	// Multiply a double by a power of ten in the range +/-kiMaxPow10
+	inline TFloat64 ScalePow10( const TFloat64 f, const TInt32 iExp )
+	{
+		return (iExp >= 0) ? f * kafPow10[iExp] : f / kafPow10[-iExp];
+	}
+
+	// Access the bits of a float and vice versa
+	inline TUInt32 FloatBits( const TFloat32 f )
+	{
+		TUInt32 i;
+		memcpy( &i, &f, sizeof(i) );
+		return i;
+	}
+	inline TFloat32 BitsFloat( const TUInt32 i )
+	{
+		TFloat32 f;
+		memcpy( &f, &i, sizeof(f) );
+		return f;
+	}
+
+	// Return the midpoint between the positive float with the given bits and the next float up,
+	// as a double (which holds it exactly)
+	inline TFloat64 MidpointAbove( const TUInt32 iBits )
+	{
+		if (iBits == 0x7f7fffffu)
+		{
+			return kfFloatOverflow;
+		}
+		return 0.5 * (static_cast<TFloat64>(BitsFloat( iBits )) +
+		              static_cast<TFloat64>(BitsFloat( iBits + 1 )));
+	}
+
+
+	// Unsigned integer of up to kiMaxBigLimbs 32-bit limbs, least significant first, with no
+	// leading zero limbs. Only as large as the exact comparisons in DecimalToFloatBits need
+	const TUInt32 kiMaxBigLimbs = 24;
+	struct SBigInt
+	{
+		TUInt32 aiLimbs[kiMaxBigLimbs];
+		TUInt32 iNumLimbs;
+	};
+
+	// Multiply a big integer by a small integer and add another
+	void BigMulAdd( SBigInt& n, const TUInt32 iMul, const TUInt32 iAdd )
+	{
+		TUInt64 iCarry = iAdd;
+		for (TUInt32 i = 0; i < n.iNumLimbs; ++i)
+		{
+			iCarry += static_cast<TUInt64>(n.aiLimbs[i]) * iMul;
+			n.aiLimbs[i] = static_cast<TUInt32>(iCarry);
+			iCarry >>= 32;
+		}
+		if (iCarry != 0)
+		{
+			n.aiLimbs[n.iNumLimbs++] = static_cast<TUInt32>(iCarry);
+		}
+	}
+
+	// Multiply a big integer by 10^iExp
+	void BigMulPow10( SBigInt& n, TInt32 iExp )
+	{
+		for (; iExp >= 9; iExp -= 9)
+		{
+			BigMulAdd( n, 1000000000u, 0 );
+		}
+		if (iExp > 0)
+		{
+			BigMulAdd( n, static_cast<TUInt32>(kafPow10[iExp]), 0 );
+		}
+	}
+
+	// Multiply a big integer by 2^iShift
+	void BigShiftLeft( SBigInt& n, const TUInt32 iShift )
+	{
+		if (n.iNumLimbs == 0)
+		{
+			return;
+		}
+
+		// Move the limbs up, from the top down so none are overwritten before they are used
+		const TUInt32 iLimbShift = iShift / 32;
+		const TUInt32 iBitShift = iShift % 32;
+		const TUInt32 iNumLimbs = n.iNumLimbs;
+		n.aiLimbs[iNumLimbs + iLimbShift] =
+			iBitShift ? n.aiLimbs[iNumLimbs - 1] >> (32 - iBitShift) : 0;
+		for (TUInt32 i = iNumLimbs - 1; i > 0; --i)
+		{
+			n.aiLimbs[i + iLimbShift] = (n.aiLimbs[i] << iBitShift) |
+			                            (iBitShift ? n.aiLimbs[i - 1] >> (32 - iBitShift) : 0);
+		}
+		n.aiLimbs[iLimbShift] = n.aiLimbs[0] << iBitShift;
+		for (TUInt32 i = 0; i < iLimbShift; ++i)
+		{
+			n.aiLimbs[i] = 0;
+		}
+		n.iNumLimbs = iNumLimbs + iLimbShift + (n.aiLimbs[iNumLimbs + iLimbShift] != 0 ? 1 : 0);
+	}
+
+	// Compare two big integers, returning -1, 0 or 1 if a is less than, equal to or greater than b
+	TInt32 BigCompare( const SBigInt& a, const SBigInt& b )
+	{
+		if (a.iNumLimbs != b.iNumLimbs)
+		{
+			return (a.iNumLimbs < b.iNumLimbs) ? -1 : 1;
+		}
+		for (TUInt32 i = a.iNumLimbs; i > 0; --i)
+		{
+			if (a.aiLimbs[i - 1] != b.aiLimbs[i - 1])
+			{
+				return (a.aiLimbs[i - 1] < b.aiLimbs[i - 1]) ? -1 : 1;
+			}
+		}
+		return 0;
+	}
+
+	// Compare a decimal number exactly with the midpoint between the positive float with the
+	// given bits and the next float up. The decimal is the integer formed by the given digits
+	// times 10^iExp, and a little more if bSticky is set. Returns -1, 0 or 1 if the decimal is
+	// below, at or above the midpoint
+	TInt32 CompareWithMidpoint( const TUInt8* aiDigits, const TUInt32 iNumDigits, const TInt32 iExp,
+	                            const bool bSticky, const TUInt32 iBits )
+	{
+		// The midpoint is (2 * mantissa + 1) * 2^(exponent - 1), where the float is
+		// mantissa * 2^exponent
+		TUInt32 iMantissa = iBits & 0x007fffffu;
+		TInt32 iExp2 = -150;
+		if (iBits >> 23)
+		{
+			iMantissa |= 0x00800000u;
+			iExp2 = static_cast<TInt32>(iBits >> 23) - 151;
+		}
+
+		// Make both sides integers by scaling both by the negative powers of 10 and 2
+		SBigInt decimal, midpoint;
+		decimal.iNumLimbs = 0;
+		for (TUInt32 i = 0; i < iNumDigits; ++i)
+		{
+			BigMulAdd( decimal, 10, aiDigits[i] );
+		}
+		midpoint.iNumLimbs = 0;
+		BigMulAdd( midpoint, 1, 2 * iMantissa + 1 );
+		if (iExp >= 0)
+		{
+			BigMulPow10( decimal, iExp );
+		}
+		else
+		{
+			BigMulPow10( midpoint, -iExp );
+		}
+		if (iExp2 >= 0)
+		{
+			BigShiftLeft( midpoint, iExp2 );
+		}
+		else
+		{
+			BigShiftLeft( decimal, -iExp2 );
+		}
+
+		const TInt32 iCompare = BigCompare( decimal, midpoint );
+		return (iCompare == 0 && bSticky) ? 1 : iCompare;
+	}
+
+
+	// Convert a decimal number to the nearest float, returning its bits. The decimal is the
+	// integer formed by the given digits (most significant first, at most kiMaxDecimalDigits)
+	// times 10^iExp. If bSticky is set, nonzero digits were discarded after the given ones, so
+	// the decimal is a little larger. The result is correctly rounded, with ties to even, as
+	// strtof. Used both for decoding and to check that encoded text reads back as the same float
+	TUInt32 DecimalToFloatBits( const TUInt8* aiDigits, TUInt32 iNumDigits, TInt32 iExp,
+	                            const bool bSticky, const bool bNegative )
+	{
+		const TUInt32 iSign = bNegative ? 0x80000000u : 0u;
+		while (iNumDigits > 0 && aiDigits[iNumDigits - 1] == 0)
+		{
+			--iNumDigits;
+			++iExp;
+		}
+		if (iNumDigits == 0)
+		{
+			return iSign;
+		}
+
+		// Decimals below 1e-46 are under half the smallest float (about 7e-46), and those of 1e39
+		// and above are over the largest
+		const TInt32 iFirstDigitExp = iExp + static_cast<TInt32>(iNumDigits) - 1;
+		if (iFirstDigitExp < -46)
+		{
+			return iSign;
+		}
+		if (iFirstDigitExp > 38)
+		{
+			return iSign | 0x7f800000u;
+		}
+
+		// Estimate the decimal in double from its first 19 digits (as many as fit in 64 bits). The
+		// estimate is within a few double ulps, far less than a float ulp, so the float nearest to
+		// the estimate is the correct one or next to it
+		const TUInt32 iEstimateDigits = Min( iNumDigits, 19u );
+		TUInt64 iMantissa = 0;
+		for (TUInt32 i = 0; i < iEstimateDigits; ++i)
+		{
+			iMantissa = iMantissa * 10 + aiDigits[i];
+		}
+		const TFloat64 f = ScalePow10( static_cast<TFloat64>(iMantissa),
+		                               iExp + static_cast<TInt32>(iNumDigits - iEstimateDigits) );
+		TUInt32 iBits = (f >= kfFloatMax) ? 0x7f7fffffu : FloatBits( static_cast<TFloat32>(f) );
+
+		// If all the digits were used, the estimate is within a few double ulps of the decimal. So
+		// if it is well clear of the midpoints either side of its nearest float, that float is
+		// the correct one. This covers all but a tiny fraction of short decimals, such as those
+		// written by EncodeText
+		if (iNumDigits <= 15 && !bSticky)
+		{
+			const TFloat64 fMargin = f * 8.8817841970012523e-16; // 4 double ulps (2^-50)
+			const TFloat64 fLower = (iBits == 0) ? -1.0 : MidpointAbove( iBits - 1 );
+			if (f - fLower > fMargin && MidpointAbove( iBits ) - f > fMargin)
+			{
+				return iSign | iBits;
+			}
+		}
+
+		// Otherwise compare the decimal exactly with the midpoints either side of the float. If it
+		// is on a midpoint, choose the float with an even mantissa
+		if (CompareWithMidpoint( aiDigits, iNumDigits, iExp, bSticky, iBits ) +
+		    static_cast<TInt32>(iBits & 1) > 0)
+		{
+			++iBits; // May become infinity
+		}
+		else if (iBits > 0 && CompareWithMidpoint( aiDigits, iNumDigits, iExp, bSticky, iBits - 1 ) -
+		         static_cast<TInt32>(iBits & 1) < 0)
+		{
+			--iBits;
+		}
+		return iSign | iBits;
+	}
+
+	// As above, for a decimal given as an integer mantissa times 10^iExp
+	TUInt32 DecimalToFloatBits( TUInt64 iMantissa, const TInt32 iExp, const bool bNegative )
+	{
+		TUInt8 aiDigits[20];
+		TUInt32 iNumDigits = 0;
+		for (; iMantissa > 0; iMantissa /= 10)
+		{
+			aiDigits[iNumDigits++] = static_cast<TUInt8>(iMantissa % 10);
+		}
+		for (TUInt32 i = 0; i < iNumDigits / 2; ++i)
+		{
+			const TUInt8 iDigit = aiDigits[i];
+			aiDigits[i] = aiDigits[iNumDigits - 1 - i];
+			aiDigits[iNumDigits - 1 - i] = iDigit;
+		}
+		return DecimalToFloatBits( aiDigits, iNumDigits, iExp, false, bNegative );
+	}
+
+	// Find the decimal digits of a finite, positive float to the given number of significant
+	// digits. Returns the digits as an integer, and the decimal exponent of the first digit
+	TUInt64 FloatDigits( const TFloat64 f, const TUInt32 iNumDigits, TInt32& iExp10 )
+	{
+		const TUInt64 iMin = static_cast<TUInt64>(kafPow10[iNumDigits - 1]);
+		const TUInt64 iMax = static_cast<TUInt64>(kafPow10[iNumDigits]);
+		TUInt64 iDigits = 0;
+		for (TUInt32 iAttempt = 0; iAttempt < 3; ++iAttempt)
+		{
+			// Scale so the given number of digits are before the decimal point and round
+			iDigits = static_cast<TUInt64>(ScalePow10( f, iNumDigits - 1 - iExp10 ) + 0.5);
+
+			// Adjust exponent if the estimate was out (or rounding carried into a new digit)
+			if (iDigits >= iMax)
+			{
+				++iExp10;
+			}
+			else if (iDigits < iMin)
+			{
+				--iExp10;
+			}
+			else
+			{
+				break;
+			}
+		}
+		return iDigits;
+	}
+
+	// Write a float as text to the given buffer, which must hold at least kiMaxFloatTextSize
+	// characters. Precision of 0 selects the shortest text that reads back as the same float.
+	// Returns the number of characters written
+	TUInt32 WriteFloatText( const TFloat32 fValue, char* sOut, TUInt32 iPrecision )
+	{
+		char* sStart = sOut;
+		const TUInt32 iBits = FloatBits( fValue );
+		const bool bNegative = (iBits & 0x80000000u) != 0;
+		if ((iBits & 0x7f800000u) == 0x7f800000u)
+		{
+			if (iBits & 0x007fffffu)
+			{
+				memcpy( sOut, "nan", 3 );
+				return 3;
+			}
+			if (bNegative) *sOut++ = '-';
+			memcpy( sOut, "inf", 3 );
+			return static_cast<TUInt32>(sOut + 3 - sStart);
+		}
+		if (bNegative) *sOut++ = '-';
+		if ((iBits & 0x7fffffffu) == 0)
+		{
+			*sOut++ = '0';
+			return static_cast<TUInt32>(sOut - sStart);
+		}
+
+		// Find digits, either to the given precision or the fewest that round trip
+		const TFloat64 f = Abs( static_cast<TFloat64>(fValue) );
+		// Rounding up to fewer digits can change the exponent (e.g. 9.96 -> 10), so each attempt
+		// at the shortest text starts again from the same exponent estimate
+		const TInt32 iExp10Estimate = static_cast<TInt32>(Floor( log10( f ) ));
+		TInt32 iExp10 = iExp10Estimate;
+		TUInt32 iNumDigits = Min( iPrecision, kiMaxFloatDigits );
+		TUInt64 iDigits;
+		if (iNumDigits > 0)
+		{
+			iDigits = FloatDigits( f, iNumDigits, iExp10 );
+		}
+		else
+		{
+			do
+			{
+				++iNumDigits;
+				iExp10 = iExp10Estimate;
+				iDigits = FloatDigits( f, iNumDigits, iExp10 );
+			} while (iNumDigits < kiMaxFloatDigits &&
+			         DecimalToFloatBits( iDigits, iExp10 + 1 - iNumDigits, false ) !=
+			         (iBits & 0x7fffffffu));
+		}
+
+		// Convert digits to characters, removing trailing zeros
+		char acDigits[kiMaxFloatDigits];
+		for (TInt32 i = iNumDigits - 1; i >= 0; --i)
+		{
+			acDigits[i] = static_cast<char>('0' + iDigits % 10);
+			iDigits /= 10;
+		}
+		while (iNumDigits > 1 && acDigits[iNumDigits - 1] == '0')
+		{
+			--iNumDigits;
+		}
+
+		// Use plain notation for moderate exponents, otherwise scientific notation
+		if (iExp10 >= 0 && iExp10 < static_cast<TInt32>(kiMaxFloatDigits))
+		{
+			for (TInt32 i = 0; i <= iExp10; ++i)
+			{
+				*sOut++ = (i < static_cast<TInt32>(iNumDigits)) ? acDigits[i] : '0';
+			}
+			if (static_cast<TInt32>(iNumDigits) > iExp10 + 1)
+			{
+				*sOut++ = '.';
+				for (TUInt32 i = iExp10 + 1; i < iNumDigits; ++i)
+				{
+					*sOut++ = acDigits[i];
+				}
+			}
+		}
+		else if (iExp10 < 0 && iExp10 >= -4)
+		{
+			*sOut++ = '0';
+			*sOut++ = '.';
+			for (TInt32 i = -1; i > iExp10; --i)
+			{
+				*sOut++ = '0';
+			}
+			memcpy( sOut, acDigits, iNumDigits );
+			sOut += iNumDigits;
+		}
+		else
+		{
+			*sOut++ = acDigits[0];
+			if (iNumDigits > 1)
+			{
+				*sOut++ = '.';
+				memcpy( sOut, acDigits + 1, iNumDigits - 1 );
+				sOut += iNumDigits - 1;
+			}
+			*sOut++ = 'e';
+			if (iExp10 < 0)
+			{
+				*sOut++ = '-';
+				iExp10 = -iExp10;
+			}
+			if (iExp10 >= 10)
+			{
+				*sOut++ = static_cast<char>('0' + iExp10 / 10);
+			}
+			*sOut++ = static_cast<char>('0' + iExp10 % 10);
+		}
+		return static_cast<TUInt32>(sOut - sStart);
+	}
+
+	// Read a float from text between the given pointers. Returns a pointer to the character
+	// after the float, or 0 if there was no valid float. Leading whitespace is not skipped
+	const char* ReadFloatText( const char* sText, const char* sEnd, TFloat32& f )
+	{
+		const char* s = sText;
+		bool bNegative = false;
+		if (s != sEnd && (*s == '-' || *s == '+'))
+		{
+			bNegative = (*s++ == '-');
+		}
+
+		// Infinities and NaNs
+		if (sEnd - s >= 3 && (memcmp( s, "inf", 3 ) == 0 || memcmp( s, "nan", 3 ) == 0))
+		{
+			const TUInt32 iSign = bNegative ? 0x80000000u : 0u;
+			f = BitsFloat( iSign | (*s == 'i' ? 0x7f800000u : 0x7fc00000u) );
+			return s + 3;
+		}
+
+		// Mantissa - the first kiMaxDecimalDigits significant digits are kept, further digits are
+		// only noted as being nonzero (further integer digits also increase the exponent)
+		TUInt8 aiDigits[kiMaxDecimalDigits];
+		TUInt32 iNumDigits = 0;
+		bool bSticky = false;
+		TInt32 iExp = 0;
+		bool bAnyDigits = false;
+		for (; s != sEnd && *s >= '0' && *s <= '9'; ++s)
+		{
+			bAnyDigits = true;
+			const TUInt8 iDigit = static_cast<TUInt8>(*s - '0');
+			if (iNumDigits < kiMaxDecimalDigits)
+			{
+				if (iNumDigits > 0 || iDigit != 0) aiDigits[iNumDigits++] = iDigit;
+			}
+			else
+			{
+				bSticky = bSticky || (iDigit != 0);
+				++iExp;
+			}
+		}
+		if (s != sEnd && *s == '.')
+		{
+			for (++s; s != sEnd && *s >= '0' && *s <= '9'; ++s)
+			{
+				bAnyDigits = true;
+				const TUInt8 iDigit = static_cast<TUInt8>(*s - '0');
+				if (iNumDigits < kiMaxDecimalDigits)
+				{
+					if (iNumDigits > 0 || iDigit != 0) aiDigits[iNumDigits++] = iDigit;
+					--iExp;
+				}
+				else
+				{
+					bSticky = bSticky || (iDigit != 0);
+				}
+			}
+		}
+		if (!bAnyDigits)
+		{
+			return 0;
+		}
+
+		// Optional exponent, limited to avoid overflow (any such exponent is out of float range)
+		if (s != sEnd && (*s == 'e' || *s == 'E'))
+		{
+			const char* sExp = s + 1;
+			bool bNegativeExp = false;
+			if (sExp != sEnd && (*sExp == '-' || *sExp == '+'))
+			{
+				bNegativeExp = (*sExp++ == '-');
+			}
+			if (sExp != sEnd && *sExp >= '0' && *sExp <= '9')
+			{
+				TInt32 iExpValue = 0;
+				for (; sExp != sEnd && *sExp >= '0' && *sExp <= '9'; ++sExp)
+				{
+					iExpValue = Min( iExpValue * 10 + (*sExp - '0'), 100000 );
+				}
+				iExp += bNegativeExp ? -iExpValue : iExpValue;
+				s = sExp;
+			}
+		}
+
+		f = BitsFloat( DecimalToFloatBits( aiDigits, iNumDigits, iExp, bSticky, bNegative ) );
+		return s;
+	}
+
+
+	// Helper to write text into a fixed size buffer, recording if it runs out of space. Space is
+	// always kept for a null terminator
+	class CTextWriter
+	{
+	public:
+		CTextWriter( char* sBuffer, const TUInt32 iBufferSize, const TUInt32 iPrecision )
+			: m_sStart( sBuffer ), m_sOut( sBuffer ), m_sEnd( sBuffer + iBufferSize ),
+			  m_iPrecision( iPrecision ), m_bOK( iBufferSize > 0 ) {}
+
+		void Write( const char* s, const TUInt32 iLength )
+		{
+			if (m_bOK && static_cast<TUInt32>(m_sEnd - m_sOut) > iLength)
+			{
+				memcpy( m_sOut, s, iLength );
+				m_sOut += iLength;
+			}
+			else
+			{
+				m_bOK = false;
+			}
+		}
+
+		void Write( const TFloat32 f )
+		{
+			// Write directly to the buffer if there is room, otherwise via a local buffer
+			if (m_bOK && static_cast<TUInt32>(m_sEnd - m_sOut) > kiMaxFloatTextSize)
+			{
+				m_sOut += WriteFloatText( f, m_sOut, m_iPrecision );
+			}
+			else
+			{
+				char acFloat[kiMaxFloatTextSize];
+				Write( acFloat, WriteFloatText( f, acFloat, m_iPrecision ) );
+			}
+		}
+
+		// Write a bracketed list of floats, as written by the stream operators. Matrix rows are
+		// separated by an extra two spaces
+		void WriteList( const TFloat32* af, const TUInt32 iCount, const char* sSeparator,
+		                const TUInt32 iRowLength = 0 )
+		{
+			const TUInt32 iSeparatorLength = static_cast<TUInt32>(strlen( sSeparator ));
+			Write( "(", 1 );
+			for (TUInt32 i = 0; i < iCount; ++i)
+			{
+				if (i > 0)
+				{
+					Write( sSeparator, iSeparatorLength );
+					if (iRowLength > 0 && i % iRowLength == 0) Write( "  ", 2 );
+				}
+				Write( af[i] );
+			}
+			Write( ")", 1 );
+		}
+
+		// Add the null terminator and return the number of characters written, or 0 on failure
+		TUInt32 Finish()
+		{
+			if (!m_bOK) return 0;
+			*m_sOut = 0;
+			return static_cast<TUInt32>(m_sOut - m_sStart);
+		}
+
+	private:
+		char*   m_sStart;
+		char*   m_sOut;
+		char*   m_sEnd;
+		TUInt32 m_iPrecision;
+		bool    m_bOK;
+	};
+
+	// Helper to read text from a buffer, recording if any of it is invalid
+	class CTextReader
+	{
+	public:
+		CTextReader( const char* sText, const TUInt32 iTextSize )
+			: m_sStart( sText ), m_sIn( sText ), m_sEnd( sText + iTextSize ), m_bOK( true ) {}
+
+		// Read the given character, skipping whitespace first
+		void Read( const char c )
+		{
+			SkipWhitespace();
+			if (m_bOK && m_sIn != m_sEnd && *m_sIn == c)
+			{
+				++m_sIn;
+			}
+			else
+			{
+				m_bOK = false;
+			}
+		}
+
+		// Read a float, skipping whitespace first
+		void Read( TFloat32& f )
+		{
+			SkipWhitespace();
+			if (m_bOK)
+			{
+				const char* sNext = ReadFloatText( m_sIn, m_sEnd, f );
+				m_bOK = (sNext != 0);
+				if (m_bOK) m_sIn = sNext;
+			}
+		}
+
+		// Read a bracketed, comma separated list of floats
+		void ReadList( TFloat32* af, const TUInt32 iCount )
+		{
+			Read( '(' );
+			for (TUInt32 i = 0; i < iCount; ++i)
+			{
+				if (i > 0) Read( ',' );
+				Read( af[i] );
+			}
+			Read( ')' );
+		}
+
+		// Return the number of characters read, or 0 on failure
+		TUInt32 Finish() const
+		{
+			return m_bOK ? static_cast<TUInt32>(m_sIn - m_sStart) : 0;
+		}
+
+	private:
+		void SkipWhitespace()
+		{
+			while (m_sIn != m_sEnd && (*m_sIn == ' ' || (*m_sIn >= '\t' && *m_sIn <= '\r')))
+			{
+				++m_sIn;
+			}
+		}
+
+		const char* m_sStart;
+		const char* m_sIn;
+		const char* m_sEnd;
+		bool        m_bOK;
+	};
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Text encoding
+---------------------------------------------------------------------------------------------*/
+
+TUInt32 EncodeText( const TFloat32 f, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.Write( f );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CVector2& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	const TFloat32 af[2] = { v.x, v.y };
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( af, 2, ", " );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CVector3& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	const TFloat32 af[3] = { v.x, v.y, v.z };
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( af, 3, ", " );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CVector4& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	const TFloat32 af[4] = { v.x, v.y, v.z, v.w };
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( af, 4, ", " );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CMatrix2x2& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( &m.e00, 4, ",", 2 );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CMatrix3x3& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( &m.e00, 9, ",", 3 );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CMatrix4x4& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( &m.e00, 16, ",", 4 );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CQuaternion& q, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	const TFloat32 af[4] = { q.w, q.x, q.y, q.z };
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.WriteList( af, 4, "," );
+	return writer.Finish();
+}
+
+TUInt32 EncodeText( const CQuatTransform& t, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision )
+{
+	const TFloat32 afQuat[4] = { t.quat.w, t.quat.x, t.quat.y, t.quat.z };
+	const TFloat32 afPos[3] = { t.pos.x, t.pos.y, t.pos.z };
+	const TFloat32 afScale[3] = { t.scale.x, t.scale.y, t.scale.z };
+	CTextWriter writer( sBuffer, iBufferSize, iPrecision );
+	writer.Write( "(", 1 );
+	writer.WriteList( afQuat, 4, "," );
+	writer.Write( ", ", 2 );
+	writer.WriteList( afPos, 3, ", " );
+	writer.Write( ", ", 2 );
+	writer.WriteList( afScale, 3, ", " );
+	writer.Write( ")", 1 );
+	return writer.Finish();
+}
+
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, TFloat32& f )
+{
+	TFloat32 fValue;
+	CTextReader reader( sText, iTextSize );
+	reader.Read( fValue );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead) // Only set output if all input was successful
+	{
+		f = fValue;
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector2& v )
+{
+	TFloat32 af[2];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 2 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		v.Set( af[0], af[1] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector3& v )
+{
+	TFloat32 af[3];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 3 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		v.Set( af[0], af[1], af[2] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector4& v )
+{
+	TFloat32 af[4];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 4 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		v.Set( af[0], af[1], af[2], af[3] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix2x2& m )
+{
+	TFloat32 af[4];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 4 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix3x3& m )
+{
+	TFloat32 af[9];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 9 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix4x4& m )
+{
+	TFloat32 af[16];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 16 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CQuaternion& q )
+{
+	TFloat32 af[4];
+	CTextReader reader( sText, iTextSize );
+	reader.ReadList( af, 4 );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		q.Set( af[0], af[1], af[2], af[3] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CQuatTransform& t )
+{
+	TFloat32 afQuat[4], afPos[3], afScale[3];
+	CTextReader reader( sText, iTextSize );
+	reader.Read( '(' );
+	reader.ReadList( afQuat, 4 );
+	reader.Read( ',' );
+	reader.ReadList( afPos, 3 );
+	reader.Read( ',' );
+	reader.ReadList( afScale, 3 );
+	reader.Read( ')' );
+	const TUInt32 iRead = reader.Finish();
+	if (iRead)
+	{
+		t.quat.Set( afQuat[0], afQuat[1], afQuat[2], afQuat[3] );
+		t.pos.Set( afPos[0], afPos[1], afPos[2] );
+		t.scale.Set( afScale[0], afScale[1], afScale[2] );
+	}
+	return iRead;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Binary encoding
+---------------------------------------------------------------------------------------------*/
+
+namespace
+{
+	// Write floats to a buffer as little-endian 32-bit values. Returns the number of bytes
+	// written, or 0 if the buffer is too small
+	TUInt32 WriteFloatsBinary( const TFloat32* af, const TUInt32 iCount, TUInt8* pBuffer,
+	                           const TUInt32 iBufferSize )
+	{
+		const TUInt32 iSize = iCount * sizeof(TFloat32);
+		if (iBufferSize < iSize)
+		{
+			return 0;
+		}
+		for (TUInt32 i = 0; i < iCount; ++i)
+		{
+			const TUInt32 iBits = FloatBits( af[i] );
+			*pBuffer++ = static_cast<TUInt8>(iBits);
+			*pBuffer++ = static_cast<TUInt8>(iBits >> 8);
+			*pBuffer++ = static_cast<TUInt8>(iBits >> 16);
+			*pBuffer++ = static_cast<TUInt8>(iBits >> 24);
+		}
+		return iSize;
+	}
+
+	// Read little-endian 32-bit floats from a buffer. Returns the number of bytes read, or 0 if
+	// there is too little data
+	TUInt32 ReadFloatsBinary( const TUInt8* pData, const TUInt32 iDataSize, TFloat32* af,
+	                          const TUInt32 iCount )
+	{
+		const TUInt32 iSize = iCount * sizeof(TFloat32);
+		if (iDataSize < iSize)
+		{
+			return 0;
+		}
+		for (TUInt32 i = 0; i < iCount; ++i, pData += 4)
+		{
+			af[i] = BitsFloat( pData[0] | (pData[1] << 8) | (pData[2] << 16) |
+			                   (static_cast<TUInt32>(pData[3]) << 24) );
+		}
+		return iSize;
+	}
+}
+
+
+TUInt32 EncodeBinary( const CVector2& v, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[2] = { v.x, v.y };
+	return WriteFloatsBinary( af, 2, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CVector3& v, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[3] = { v.x, v.y, v.z };
+	return WriteFloatsBinary( af, 3, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CVector4& v, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[4] = { v.x, v.y, v.z, v.w };
+	return WriteFloatsBinary( af, 4, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CMatrix2x2& m, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	return WriteFloatsBinary( &m.e00, 4, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CMatrix3x3& m, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	return WriteFloatsBinary( &m.e00, 9, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CMatrix4x4& m, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	return WriteFloatsBinary( &m.e00, 16, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CQuaternion& q, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[4] = { q.w, q.x, q.y, q.z };
+	return WriteFloatsBinary( af, 4, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinary( const CQuatTransform& t, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[10] = { t.quat.w, t.quat.x, t.quat.y, t.quat.z,
+	                          t.pos.x, t.pos.y, t.pos.z, t.scale.x, t.scale.y, t.scale.z };
+	return WriteFloatsBinary( af, 10, pBuffer, iBufferSize );
+}
+
+TUInt32 EncodeBinaryAffine( const CMatrix4x4& m, TUInt8* pBuffer, const TUInt32 iBufferSize )
+{
+	const TFloat32 af[12] = { m.e00, m.e01, m.e02, m.e10, m.e11, m.e12,
+	                          m.e20, m.e21, m.e22, m.e30, m.e31, m.e32 };
+	return WriteFloatsBinary( af, 12, pBuffer, iBufferSize );
+}
+
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector2& v )
+{
+	TFloat32 af[2];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 2 );
+	if (iRead) // Only set output if all input was successful
+	{
+		v.Set( af[0], af[1] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector3& v )
+{
+	TFloat32 af[3];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 3 );
+	if (iRead)
+	{
+		v.Set( af[0], af[1], af[2] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector4& v )
+{
+	TFloat32 af[4];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 4 );
+	if (iRead)
+	{
+		v.Set( af[0], af[1], af[2], af[3] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix2x2& m )
+{
+	TFloat32 af[4];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 4 );
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix3x3& m )
+{
+	TFloat32 af[9];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 9 );
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix4x4& m )
+{
+	TFloat32 af[16];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 16 );
+	if (iRead)
+	{
+		m.Set( af );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CQuaternion& q )
+{
+	TFloat32 af[4];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 4 );
+	if (iRead)
+	{
+		q.Set( af[0], af[1], af[2], af[3] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CQuatTransform& t )
+{
+	TFloat32 af[10];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 10 );
+	if (iRead)
+	{
+		t.quat.Set( af[0], af[1], af[2], af[3] );
+		t.pos.Set( af[4], af[5], af[6] );
+		t.scale.Set( af[7], af[8], af[9] );
+	}
+	return iRead;
+}
+
+TUInt32 DecodeBinaryAffine( const TUInt8* pData, const TUInt32 iDataSize, CMatrix4x4& m )
+{
+	TFloat32 af[12];
+	const TUInt32 iRead = ReadFloatsBinary( pData, iDataSize, af, 12 );
+	if (iRead)
+	{
+		m.Set( af[0], af[1],  af[2],  0.0f,
+		       af[3], af[4],  af[5],  0.0f,
+		       af[6], af[7],  af[8],  0.0f,
+		       af[9], af[10], af[11], 1.0f );
+	}
+	return iRead;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Validation
+---------------------------------------------------------------------------------------------*/
+
+// Return a random integer from 0 to n - 1. Uses rand directly as only the lowest 15 bits are
+// needed, and Random( a, b ) overflows when RAND_MAX is large
+static inline TUInt32 RandomBelow( const TUInt32 n )
+{
+	return static_cast<TUInt32>(rand() & 0x7fff) % n;
+}
+
+// Compare float decoding against strtof on random text that is hard to round correctly
+TUInt32 ValidateFloatText( const TUInt32 iNumTests )
+{
+	TUInt32 iNumDifferent = 0;
+	char acText[64];
+	for (TUInt32 iTest = 0; iTest < iNumTests; ++iTest)
+	{
+		TUInt32 iLength;
+		if (iTest % 2 == 0)
+		{
+			// The midpoint between a random positive float and the next float up, to a random
+			// number of significant digits - exactly the midpoint if there are enough digits
+			TUInt32 iBits;
+			do
+			{
+				iBits = (RandomBelow( 0x8000 ) << 16) | (RandomBelow( 0x100 ) << 8) |
+				        RandomBelow( 0x100 );
+			} while (iBits > 0x7f7fffffu);
+			iLength = snprintf( acText, sizeof(acText), "%.*e", 8 + RandomBelow( 33 ),
+			                    MidpointAbove( iBits ) );
+		}
+		else
+		{
+			// Random decimal with 10 to 40 significant digits and an exponent across the float range
+			char* s = acText;
+			*s++ = static_cast<char>('1' + RandomBelow( 9 ));
+			*s++ = '.';
+			const TUInt32 iNumDigits = 9 + RandomBelow( 31 );
+			for (TUInt32 i = 0; i < iNumDigits; ++i)
+			{
+				*s++ = static_cast<char>('0' + RandomBelow( 10 ));
+			}
+			iLength = static_cast<TUInt32>(s - acText);
+			iLength += snprintf( s, sizeof(acText) - iLength, "e%d",
+			                     static_cast<TInt32>(RandomBelow( 91 )) - 50 );
+		}
+
+		TFloat32 f = 0.0f;
+		if (DecodeText( acText, iLength, f ) != iLength ||
+		    FloatBits( f ) != FloatBits( strtof( acText, 0 ) ))
+		{
+			++iNumDifferent;
+		}
+	}
+	return iNumDifferent;
+}
+
 
 } // namespace gen
@@ -3,7 +3,8 @@
 	Author:       Laurent Noel
 	Date created: 11/07/07
 
-	Support for stream input and output for math classes
+	Support for stream input and output for math classes, and for allocation-free text and binary
+	encoding of math classes into caller-supplied buffers
 
 	Copyright 2007, University of Central Lancashire and Laurent Noel
 
@@ -30,6 +31,7 @@ class CMatrix2x2;
 class CMatrix3x3;
 class CMatrix4x4;
 class CQuaternion;
+class CQuatTransform;
 
 
 /*---------------------------------------------------------------------------------------------
@@ -67,6 +69,121 @@ ostream& operator<<( ostream& s, const CQuaternion& v );
 istream& operator>>( istream& s, CQuaternion& v );
 
 
+/*---------------------------------------------------------------------------------------------
+	Text encoding
+---------------------------------------------------------------------------------------------*/
+// Faster alternative to the stream operators above for bulk output, e.g. recording entity state
+// every frame. Nothing is allocated - text is written to and read from caller-supplied buffers.
+// The layout is the same as the stream operators, so either can read text from the other (but
+// the stream operators do not read infinities or NaNs). The layout for a CQuatTransform is
+// (quaternion, position, scale)
+//
+// Floats are written with the given number of significant digits (1-9), or if the precision is
+// 0, with the fewest digits that read back as exactly the same float (shortest round trip).
+// Infinities and NaNs are written as inf, -inf and nan. Floats are read as the nearest float to
+// the text, with any number of digits, as strtof does
+
+// Maximum length of the text for a single float, excluding the null terminator
+const TUInt32 kiMaxFloatTextSize = 15;
+
+// Buffer size sufficient for the text of any math class, including the null terminator
+const TUInt32 kiMaxMathTextSize = 16 * kiMaxFloatTextSize + 24;
+
+// Encode a value as text into the given buffer, followed by a null terminator. Returns the
+// number of characters written excluding the terminator, or 0 if the buffer is too small
+TUInt32 EncodeText( const TFloat32 f, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CVector2& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CVector3& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CVector4& v, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CMatrix2x2& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CMatrix3x3& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CMatrix4x4& m, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CQuaternion& q, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+TUInt32 EncodeText( const CQuatTransform& t, char* sBuffer, const TUInt32 iBufferSize,
+                    const TUInt32 iPrecision = 0 );
+
+// Decode a value from text of the given length (need not be null terminated). Whitespace is
+// skipped as with the stream operators. Returns the number of characters read, or 0 if the text
+// was invalid, in which case the output is left unchanged
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, TFloat32& f );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector2& v );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector3& v );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CVector4& v );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix2x2& m );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix3x3& m );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CMatrix4x4& m );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CQuaternion& q );
+TUInt32 DecodeText( const char* sText, const TUInt32 iTextSize, CQuatTransform& t );
+
+
+/*---------------------------------------------------------------------------------------------
+	Binary encoding
+---------------------------------------------------------------------------------------------*/
+// Compact binary layout: 32-bit IEEE floats in little-endian byte order, with no header or
+// padding. Elements are in member order - x,y,z(,w) for vectors, e00,e01... for matrices, w,x,y,z
+// for quaternions and quaternion, position, scale for a CQuatTransform. The affine layout for a
+// CMatrix4x4 omits the constant fourth column (0,0,0,1) of an affine matrix, saving 16 bytes
+
+// Size in bytes of the binary layout of each class
+const TUInt32 kiVector2BinarySize = 8;
+const TUInt32 kiVector3BinarySize = 12;
+const TUInt32 kiVector4BinarySize = 16;
+const TUInt32 kiMatrix2x2BinarySize = 16;
+const TUInt32 kiMatrix3x3BinarySize = 36;
+const TUInt32 kiMatrix4x4BinarySize = 64;
+const TUInt32 kiMatrix4x4AffineBinarySize = 48;
+const TUInt32 kiQuaternionBinarySize = 16;
+const TUInt32 kiQuatTransformBinarySize = 40;
+
+// Encode a value into the given buffer. Returns the number of bytes written, or 0 if the buffer
+// is too small
+TUInt32 EncodeBinary( const CVector2& v, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CVector3& v, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CVector4& v, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CMatrix2x2& m, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CMatrix3x3& m, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CMatrix4x4& m, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CQuaternion& q, TUInt8* pBuffer, const TUInt32 iBufferSize );
+TUInt32 EncodeBinary( const CQuatTransform& t, TUInt8* pBuffer, const TUInt32 iBufferSize );
+
+// Encode an affine matrix using the affine layout. The fourth column is not stored, so is
+// assumed to be (0,0,0,1)
+TUInt32 EncodeBinaryAffine( const CMatrix4x4& m, TUInt8* pBuffer, const TUInt32 iBufferSize );
+
+// Decode a value from binary data of the given size. Returns the number of bytes read, or 0 if
+// there is too little data, in which case the output is left unchanged
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector2& v );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector3& v );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CVector4& v );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix2x2& m );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix3x3& m );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CMatrix4x4& m );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CQuaternion& q );
+TUInt32 DecodeBinary( const TUInt8* pData, const TUInt32 iDataSize, CQuatTransform& t );
+
+// Decode a matrix from the affine layout, setting the fourth column to (0,0,0,1)
+TUInt32 DecodeBinaryAffine( const TUInt8* pData, const TUInt32 iDataSize, CMatrix4x4& m );
+
+
+/*---------------------------------------------------------------------------------------------
+	Validation
+---------------------------------------------------------------------------------------------*/
+
+// Compare DecodeText for floats against the C library's strtof on the given number of random
+// inputs. Half are near or exactly on the midpoints between floats, half have 10 to 40
+// significant digits - the inputs that are hardest to round correctly. Returns the number of
+// inputs decoded differently, which should be 0
+TUInt32 ValidateFloatText( const TUInt32 iNumTests );
+
+
 } // namespace gen
 
 #endif // GEN_C_MATHIO_H_INCLUDED
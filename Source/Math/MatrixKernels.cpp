@@ -0,0 +1,297 @@
+/**************************************************************************************************
+	Module:       MatrixKernels.cpp
+
+	Scalar reference versions of the core 4x4 matrix kernels used by CMatrix4x4, and validation
+	of the selected kernels against them. The SSE kernels are inline in the header
+**************************************************************************************************/
+
+#include "MatrixKernels.h"
+#include "BaseMath.h"
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Reference kernels
+-----------------------------------------------------------------------------------------*/
+
+// Matrix-matrix multiplication: afOut = afM1 * afM2
+void Matrix4x4MultiplyRef( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut )
+{
+	// Calculate each row in temporaries in case the output is the first input
+	for (TUInt32 iRow = 0; iRow < 16; iRow += 4)
+	{
+		const TFloat32* v = afM1 + iRow;
+		TFloat32 t0 = v[0]*afM2[0] + v[1]*afM2[4] + v[2]*afM2[8]  + v[3]*afM2[12];
+		TFloat32 t1 = v[0]*afM2[1] + v[1]*afM2[5] + v[2]*afM2[9]  + v[3]*afM2[13];
+		TFloat32 t2 = v[0]*afM2[2] + v[1]*afM2[6] + v[2]*afM2[10] + v[3]*afM2[14];
+		TFloat32 t3 = v[0]*afM2[3] + v[1]*afM2[7] + v[2]*afM2[11] + v[3]*afM2[15];
+		afOut[iRow]     = t0;
+		afOut[iRow + 1] = t1;
+		afOut[iRow + 2] = t2;
+		afOut[iRow + 3] = t3;
+	}
+}
+
+// Matrix-matrix multiplication assuming both matrices are affine: afOut = afM1 * afM2
+void Matrix4x4MultiplyAffineRef( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut )
+{
+	for (TUInt32 iRow = 0; iRow < 16; iRow += 4)
+	{
+		const TFloat32* v = afM1 + iRow;
+		TFloat32 t0 = v[0]*afM2[0] + v[1]*afM2[4] + v[2]*afM2[8];
+		TFloat32 t1 = v[0]*afM2[1] + v[1]*afM2[5] + v[2]*afM2[9];
+		TFloat32 t2 = v[0]*afM2[2] + v[1]*afM2[6] + v[2]*afM2[10];
+		if (iRow == 12)
+		{
+			// Add translation
+			t0 += afM2[12];
+			t1 += afM2[13];
+			t2 += afM2[14];
+		}
+		afOut[iRow]     = t0;
+		afOut[iRow + 1] = t1;
+		afOut[iRow + 2] = t2;
+		afOut[iRow + 3] = (iRow == 12) ? 1.0f : 0.0f;
+	}
+}
+
+// Transpose of a matrix
+void Matrix4x4TransposeRef( const TFloat32* afM, TFloat32* afOut )
+{
+	TFloat32 afTemp[16];
+	for (TUInt32 iRow = 0; iRow < 4; ++iRow)
+	{
+		for (TUInt32 iCol = 0; iCol < 4; ++iCol)
+		{
+			afTemp[iCol * 4 + iRow] = afM[iRow * 4 + iCol];
+		}
+	}
+	for (TUInt32 i = 0; i < 16; ++i)
+	{
+		afOut[i] = afTemp[i];
+	}
+}
+
+// Inverse of an affine matrix. Returns the determinant of the upper-left 3x3 matrix
+TFloat32 Matrix4x4InverseAffineRef( const TFloat32* afM, TFloat32* afOut )
+{
+	// Calculate determinant of upper left 3x3
+	TFloat32 det0 = afM[5]*afM[10] - afM[6]*afM[9];
+	TFloat32 det1 = afM[6]*afM[8]  - afM[4]*afM[10];
+	TFloat32 det2 = afM[4]*afM[9]  - afM[5]*afM[8];
+	TFloat32 det = afM[0]*det0 + afM[1]*det1 + afM[2]*det2;
+
+	// Calculate inverse of upper left 3x3
+	TFloat32 invDet = 1.0f / det;
+	TFloat32 afTemp[16];
+	afTemp[0] = invDet * det0;
+	afTemp[4] = invDet * det1;
+	afTemp[8] = invDet * det2;
+
+	afTemp[1] = invDet * (afM[9]*afM[2] - afM[10]*afM[1]);
+	afTemp[5] = invDet * (afM[10]*afM[0] - afM[8]*afM[2]);
+	afTemp[9] = invDet * (afM[8]*afM[1] - afM[9]*afM[0]);
+
+	afTemp[2]  = invDet * (afM[1]*afM[6] - afM[2]*afM[5]);
+	afTemp[6]  = invDet * (afM[2]*afM[4] - afM[0]*afM[6]);
+	afTemp[10] = invDet * (afM[0]*afM[5] - afM[1]*afM[4]);
+
+	// Transform negative translation by inverted 3x3 to get inverse
+	afTemp[12] = -afM[12]*afTemp[0] - afM[13]*afTemp[4] - afM[14]*afTemp[8];
+	afTemp[13] = -afM[12]*afTemp[1] - afM[13]*afTemp[5] - afM[14]*afTemp[9];
+	afTemp[14] = -afM[12]*afTemp[2] - afM[13]*afTemp[6] - afM[14]*afTemp[10];
+
+	// Fill in right column for affine matrix
+	afTemp[3]  = 0.0f;
+	afTemp[7]  = 0.0f;
+	afTemp[11] = 0.0f;
+	afTemp[15] = 1.0f;
+
+	for (TUInt32 i = 0; i < 16; ++i)
+	{
+		afOut[i] = afTemp[i];
+	}
+	return det;
+}
+
+// Return the cofactor of entry i,j of the given matrix. This is (-1)^(i+j) * determinant of
+// the matrix after removing the ith and jth row/column
+static TFloat32 CofactorRef( const TFloat32* afM, const TUInt32 i, const TUInt32 j )
+{
+	// Get rows and columns involved
+	TUInt32 rows[3];
+	TUInt32 cols[3];
+	TUInt32 row = 0, col = 0;
+	for (TUInt32 rowCol = 0; rowCol < 4; ++rowCol)
+	{
+		if (rowCol != i) rows[row++] = rowCol * 4;
+		if (rowCol != j) cols[col++] = rowCol;
+	}
+
+	// Calculate 3x3 determinant
+	TFloat32 det0 = afM[rows[1] + cols[1]]*afM[rows[2] + cols[2]] -
+	                afM[rows[1] + cols[2]]*afM[rows[2] + cols[1]];
+	TFloat32 det1 = afM[rows[1] + cols[2]]*afM[rows[2] + cols[0]] -
+	                afM[rows[1] + cols[0]]*afM[rows[2] + cols[2]];
+	TFloat32 det2 = afM[rows[1] + cols[0]]*afM[rows[2] + cols[1]] -
+	                afM[rows[1] + cols[1]]*afM[rows[2] + cols[0]];
+	TFloat32 det = afM[rows[0] + cols[0]]*det0 +
+	               afM[rows[0] + cols[1]]*det1 +
+	               afM[rows[0] + cols[2]]*det2;
+
+	// Determine if i+j is even/odd to calculate (-1) term
+	return ((((i+j) & 1) == 0) ? det : -det);
+}
+
+// Inverse of a general matrix. Returns the determinant
+TFloat32 Matrix4x4InverseRef( const TFloat32* afM, TFloat32* afOut )
+{
+	// Calculate determinant
+	TFloat32 det = afM[0] * CofactorRef( afM, 0, 0 ) + afM[1] * CofactorRef( afM, 0, 1 ) +
+	               afM[2] * CofactorRef( afM, 0, 2 ) + afM[3] * CofactorRef( afM, 0, 3 );
+
+	// Inverse is (1/determinant)*adjoint matrix. Adjoint matrix is transposed matrix of cofactors
+	TFloat32 invDet = 1.0f / det;
+	TFloat32 afTemp[16];
+	for (TUInt32 i = 0; i < 4; ++i)
+	{
+		for (TUInt32 j = 0; j < 4; ++j)
+		{
+			afTemp[i * 4 + j] = invDet * CofactorRef( afM, j, i );
+		}
+	}
+	for (TUInt32 i = 0; i < 16; ++i)
+	{
+		afOut[i] = afTemp[i];
+	}
+	return det;
+}
+
+// Vector-matrix multiplication of a 4 element vector: afOut = afV * afM
+void Matrix4x4TransformRef( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut )
+{
+	TFloat32 x = afV[0]*afM[0] + afV[1]*afM[4] + afV[2]*afM[8]  + afV[3]*afM[12];
+	TFloat32 y = afV[0]*afM[1] + afV[1]*afM[5] + afV[2]*afM[9]  + afV[3]*afM[13];
+	TFloat32 z = afV[0]*afM[2] + afV[1]*afM[6] + afV[2]*afM[10] + afV[3]*afM[14];
+	TFloat32 w = afV[0]*afM[3] + afV[1]*afM[7] + afV[2]*afM[11] + afV[3]*afM[15];
+	afOut[0] = x;
+	afOut[1] = y;
+	afOut[2] = z;
+	afOut[3] = w;
+}
+
+// Vector-matrix multiplication of a 3 element point (4th element taken as 1)
+void Matrix4x4TransformPointRef( const TFloat32* afM, const TFloat32* afP, TFloat32* afOut )
+{
+	TFloat32 x = afP[0]*afM[0] + afP[1]*afM[4] + afP[2]*afM[8]  + afM[12];
+	TFloat32 y = afP[0]*afM[1] + afP[1]*afM[5] + afP[2]*afM[9]  + afM[13];
+	TFloat32 z = afP[0]*afM[2] + afP[1]*afM[6] + afP[2]*afM[10] + afM[14];
+	afOut[0] = x;
+	afOut[1] = y;
+	afOut[2] = z;
+}
+
+// Vector-matrix multiplication of a 3 element vector (4th element taken as 0)
+void Matrix4x4TransformVectorRef( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut )
+{
+	TFloat32 x = afV[0]*afM[0] + afV[1]*afM[4] + afV[2]*afM[8];
+	TFloat32 y = afV[0]*afM[1] + afV[1]*afM[5] + afV[2]*afM[9];
+	TFloat32 z = afV[0]*afM[2] + afV[1]*afM[6] + afV[2]*afM[10];
+	afOut[0] = x;
+	afOut[1] = y;
+	afOut[2] = z;
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Validation
+-----------------------------------------------------------------------------------------*/
+
+// Return the largest difference between two arrays of results, relative to the size of the
+// reference results (or absolute for results smaller than 1)
+static TFloat32 MaxRelativeError( const TFloat32* afResult, const TFloat32* afRef,
+                                  const TUInt32 iCount )
+{
+	TFloat32 fScale = 1.0f;
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		fScale = Max( fScale, Abs( afRef[i] ) );
+	}
+	TFloat32 fError = 0.0f;
+	for (TUInt32 i = 0; i < iCount; ++i)
+	{
+		fError = Max( fError, Abs( afResult[i] - afRef[i] ) / fScale );
+	}
+	return fError;
+}
+
+// Compare the selected kernels against the reference kernels on random matrices and vectors
+TFloat32 ValidateMatrixKernels( const TUInt32 iNumTests )
+{
+#ifdef GEN_MATH_SSE
+	TFloat32 fMaxError = 0.0f;
+	for (TUInt32 iTest = 0; iTest < iNumTests; ++iTest)
+	{
+		// Random general and affine matrices, and a random vector
+		TFloat32 afM1[16], afM2[16], afAffine1[16], afAffine2[16], afV[4];
+		for (TUInt32 i = 0; i < 16; ++i)
+		{
+			afM1[i] = Random( -10.0f, 10.0f );
+			afM2[i] = Random( -10.0f, 10.0f );
+			afAffine1[i] = Random( -10.0f, 10.0f );
+			afAffine2[i] = Random( -10.0f, 10.0f );
+		}
+		afAffine1[3] = afAffine1[7] = afAffine1[11] = afAffine2[3] = afAffine2[7] = afAffine2[11] = 0.0f;
+		afAffine1[15] = afAffine2[15] = 1.0f;
+		for (TUInt32 i = 0; i < 4; ++i)
+		{
+			afV[i] = Random( -10.0f, 10.0f );
+		}
+
+		TFloat32 afOut[16], afRef[16];
+		Matrix4x4MultiplySSE( afM1, afM2, afOut );
+		Matrix4x4MultiplyRef( afM1, afM2, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 16 ) );
+
+		Matrix4x4MultiplyAffineSSE( afAffine1, afAffine2, afOut );
+		Matrix4x4MultiplyAffineRef( afAffine1, afAffine2, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 16 ) );
+
+		Matrix4x4TransposeSSE( afM1, afOut );
+		Matrix4x4TransposeRef( afM1, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 16 ) );
+
+		// Skip inverses of nearly singular matrices, where both versions lose all precision
+		if (Abs( Matrix4x4InverseAffineRef( afAffine1, afRef ) ) > 1.0f)
+		{
+			Matrix4x4InverseAffineSSE( afAffine1, afOut );
+			fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 16 ) );
+		}
+		if (Abs( Matrix4x4InverseRef( afM1, afRef ) ) > 1.0f)
+		{
+			Matrix4x4InverseSSE( afM1, afOut );
+			fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 16 ) );
+		}
+
+		Matrix4x4TransformSSE( afM1, afV, afOut );
+		Matrix4x4TransformRef( afM1, afV, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 4 ) );
+
+		Matrix4x4TransformPointSSE( afM1, afV, afOut );
+		Matrix4x4TransformPointRef( afM1, afV, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 3 ) );
+
+		Matrix4x4TransformVectorSSE( afM1, afV, afOut );
+		Matrix4x4TransformVectorRef( afM1, afV, afRef );
+		fMaxError = Max( fMaxError, MaxRelativeError( afOut, afRef, 3 ) );
+	}
+	return fMaxError;
+#else
+	GEN_UNREFERENCED_PARAMETER( iNumTests );
+	return 0.0f;
+#endif
+}
+
+
+} // namespace gen
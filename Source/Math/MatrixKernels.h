@@ -0,0 +1,348 @@
+/**************************************************************************************************
+	Module:       MatrixKernels.h
+
+	Core 4x4 matrix kernels used by CMatrix4x4: multiplication, transpose, inverses and vector
+	transforms. The kernels work on arrays of 16 floats in the row order used by CMatrix4x4 (see
+	notes at top of CMatrix4x4.h), so can also be used on other data laid out the same way
+
+	Each kernel has a scalar reference version (suffix Ref) and an SSE version (suffix SSE). The
+	version used by the unsuffixed kernels, and so by CMatrix4x4, is chosen at compile time. SSE
+	is used when the compiler targets SSE2 (x64, or x86 with /arch:SSE2 or higher) unless the user
+	defines GEN_MATH_NO_SIMD before this point. The reference versions are always available, and
+	ValidateMatrixKernels compares the two
+**************************************************************************************************/
+
+#ifndef GEN_MATRIX_KERNELS_H_INCLUDED
+#define GEN_MATRIX_KERNELS_H_INCLUDED
+
+#include "Defines.h"
+
+// Select SSE kernels if the target supports SSE2 (used for the bit masks)
+#if !defined(GEN_MATH_NO_SIMD) && \
+    (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+	#define GEN_MATH_SSE
+#endif
+
+#ifdef GEN_MATH_SSE
+	#include <emmintrin.h>
+#endif
+
+namespace gen
+{
+
+/*-----------------------------------------------------------------------------------------
+	Reference kernels
+-----------------------------------------------------------------------------------------*/
+// Scalar versions of the kernels, used when SSE is not available and for validation. In all
+// kernels the output may be the same array as the first matrix input (but not the second)
+
+// Matrix-matrix multiplication: afOut = afM1 * afM2
+void Matrix4x4MultiplyRef( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut );
+
+// Matrix-matrix multiplication assuming both matrices are affine: afOut = afM1 * afM2. The right
+// hand columns of the inputs are ignored and the output's is set to (0,0,0,1)
+void Matrix4x4MultiplyAffineRef( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut );
+
+// Transpose of a matrix
+void Matrix4x4TransposeRef( const TFloat32* afM, TFloat32* afOut );
+
+// Inverse of an affine matrix. Returns the determinant of the upper-left 3x3 matrix - the
+// output is only valid if this is not zero
+TFloat32 Matrix4x4InverseAffineRef( const TFloat32* afM, TFloat32* afOut );
+
+// Inverse of a general matrix. Returns the determinant - the output is only valid if this is not
+// zero
+TFloat32 Matrix4x4InverseRef( const TFloat32* afM, TFloat32* afOut );
+
+// Vector-matrix multiplication of a 4 element vector: afOut = afV * afM
+void Matrix4x4TransformRef( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut );
+
+// Vector-matrix multiplication of a 3 element point (4th element taken as 1) or vector (4th
+// element taken as 0), giving 3 elements
+void Matrix4x4TransformPointRef( const TFloat32* afM, const TFloat32* afP, TFloat32* afOut );
+void Matrix4x4TransformVectorRef( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut );
+
+
+#ifdef GEN_MATH_SSE
+
+/*-----------------------------------------------------------------------------------------
+	SSE kernels
+-----------------------------------------------------------------------------------------*/
+// Inline so they can be optimised into their callers. Matrices need not be aligned. Same
+// aliasing rules as the reference versions
+
+// Return the sum of v0*r0 + v1*r1 + v2*r2 + v3*r3, where v0-3 are the elements of v. This is a row
+// vector multiplied by the matrix with rows r0-r3. The rows are passed by reference - 32-bit
+// Visual C++ can only pass the first three __m128 parameters by value (error C2719)
+inline __m128 Matrix4x4RowSSE( __m128 v, const __m128& r0, const __m128& r1, const __m128& r2,
+                               const __m128& r3 )
+{
+	__m128 sum = _mm_mul_ps( _mm_shuffle_ps( v, v, _MM_SHUFFLE(0,0,0,0) ), r0 );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_shuffle_ps( v, v, _MM_SHUFFLE(1,1,1,1) ), r1 ) );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,2,2,2) ), r2 ) );
+	return _mm_add_ps( sum, _mm_mul_ps( _mm_shuffle_ps( v, v, _MM_SHUFFLE(3,3,3,3) ), r3 ) );
+}
+
+// Matrix-matrix multiplication: afOut = afM1 * afM2. Each row of the output is the matching row
+// of afM1 multiplied by afM2
+inline void Matrix4x4MultiplySSE( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut )
+{
+	__m128 r0 = _mm_loadu_ps( afM2 );
+	__m128 r1 = _mm_loadu_ps( afM2 + 4 );
+	__m128 r2 = _mm_loadu_ps( afM2 + 8 );
+	__m128 r3 = _mm_loadu_ps( afM2 + 12 );
+	for (TUInt32 iRow = 0; iRow < 16; iRow += 4)
+	{
+		_mm_storeu_ps( afOut + iRow, Matrix4x4RowSSE( _mm_loadu_ps( afM1 + iRow ), r0, r1, r2, r3 ) );
+	}
+}
+
+// Matrix-matrix multiplication assuming both matrices are affine: afOut = afM1 * afM2
+inline void Matrix4x4MultiplyAffineSSE( const TFloat32* afM1, const TFloat32* afM2,
+                                        TFloat32* afOut )
+{
+	// Clear the right hand column of afM2, and of afM1 in the first three rows. The last row of
+	// afM1 is given a 1 to add the translation, and the last row of afM2 a 1 so the output is
+	// affine
+	const __m128 xyzMask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	const __m128 wOne = _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f );
+	__m128 r0 = _mm_and_ps( _mm_loadu_ps( afM2 ), xyzMask );
+	__m128 r1 = _mm_and_ps( _mm_loadu_ps( afM2 + 4 ), xyzMask );
+	__m128 r2 = _mm_and_ps( _mm_loadu_ps( afM2 + 8 ), xyzMask );
+	__m128 r3 = _mm_or_ps( _mm_and_ps( _mm_loadu_ps( afM2 + 12 ), xyzMask ), wOne );
+	for (TUInt32 iRow = 0; iRow < 12; iRow += 4)
+	{
+		__m128 v = _mm_and_ps( _mm_loadu_ps( afM1 + iRow ), xyzMask );
+		_mm_storeu_ps( afOut + iRow, Matrix4x4RowSSE( v, r0, r1, r2, r3 ) );
+	}
+	__m128 v = _mm_or_ps( _mm_and_ps( _mm_loadu_ps( afM1 + 12 ), xyzMask ), wOne );
+	_mm_storeu_ps( afOut + 12, Matrix4x4RowSSE( v, r0, r1, r2, r3 ) );
+}
+
+// Transpose of a matrix
+inline void Matrix4x4TransposeSSE( const TFloat32* afM, TFloat32* afOut )
+{
+	__m128 r0 = _mm_loadu_ps( afM );
+	__m128 r1 = _mm_loadu_ps( afM + 4 );
+	__m128 r2 = _mm_loadu_ps( afM + 8 );
+	__m128 r3 = _mm_loadu_ps( afM + 12 );
+	_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+	_mm_storeu_ps( afOut, r0 );
+	_mm_storeu_ps( afOut + 4, r1 );
+	_mm_storeu_ps( afOut + 8, r2 );
+	_mm_storeu_ps( afOut + 12, r3 );
+}
+
+// Return the cross product of the xyz elements of a and b, w element is 0 if both w's are 0
+inline __m128 Cross3SSE( __m128 a, __m128 b )
+{
+	__m128 aYZX = _mm_shuffle_ps( a, a, _MM_SHUFFLE(3,0,2,1) );
+	__m128 bYZX = _mm_shuffle_ps( b, b, _MM_SHUFFLE(3,0,2,1) );
+	__m128 c = _mm_sub_ps( _mm_mul_ps( a, bYZX ), _mm_mul_ps( aYZX, b ) );
+	return _mm_shuffle_ps( c, c, _MM_SHUFFLE(3,0,2,1) );
+}
+
+// Return the sum of the four elements of v in every element
+inline __m128 HorizontalSumSSE( __m128 v )
+{
+	v = _mm_add_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2,3,0,1) ) );
+	return _mm_add_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1,0,3,2) ) );
+}
+
+// Inverse of an affine matrix. Returns the determinant of the upper-left 3x3 matrix
+inline TFloat32 Matrix4x4InverseAffineSSE( const TFloat32* afM, TFloat32* afOut )
+{
+	const __m128 xyzMask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+	__m128 a = _mm_and_ps( _mm_loadu_ps( afM ), xyzMask );
+	__m128 b = _mm_and_ps( _mm_loadu_ps( afM + 4 ), xyzMask );
+	__m128 c = _mm_and_ps( _mm_loadu_ps( afM + 8 ), xyzMask );
+	__m128 p = _mm_loadu_ps( afM + 12 );
+
+	// The columns of the inverse 3x3 are the cross products of pairs of rows, over the
+	// determinant
+	__m128 col0 = Cross3SSE( b, c );
+	__m128 col1 = Cross3SSE( c, a );
+	__m128 col2 = Cross3SSE( a, b );
+	__m128 det = HorizontalSumSSE( _mm_mul_ps( a, col0 ) );
+	__m128 invDet = _mm_div_ps( _mm_set1_ps( 1.0f ), det );
+
+	// Transpose to rows, the fourth row is used for the translation
+	__m128 row3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS( col0, col1, col2, row3 );
+	col0 = _mm_mul_ps( col0, invDet );
+	col1 = _mm_mul_ps( col1, invDet );
+	col2 = _mm_mul_ps( col2, invDet );
+
+	// Transform negative translation by inverted 3x3 to get inverse
+	__m128 negP = _mm_sub_ps( _mm_setzero_ps(), p );
+	row3 = _mm_mul_ps( _mm_shuffle_ps( negP, negP, _MM_SHUFFLE(0,0,0,0) ), col0 );
+	row3 = _mm_add_ps( row3, _mm_mul_ps( _mm_shuffle_ps( negP, negP, _MM_SHUFFLE(1,1,1,1) ), col1 ) );
+	row3 = _mm_add_ps( row3, _mm_mul_ps( _mm_shuffle_ps( negP, negP, _MM_SHUFFLE(2,2,2,2) ), col2 ) );
+	row3 = _mm_or_ps( _mm_and_ps( row3, xyzMask ), _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f ) );
+
+	_mm_storeu_ps( afOut, col0 );
+	_mm_storeu_ps( afOut + 4, col1 );
+	_mm_storeu_ps( afOut + 8, col2 );
+	_mm_storeu_ps( afOut + 12, row3 );
+	return _mm_cvtss_f32( det );
+}
+
+// Inverse of a general matrix. Returns the determinant
+inline TFloat32 Matrix4x4InverseSSE( const TFloat32* afM, TFloat32* afOut )
+{
+	// Rows a, b, c, d
+	__m128 a = _mm_loadu_ps( afM );
+	__m128 b = _mm_loadu_ps( afM + 4 );
+	__m128 c = _mm_loadu_ps( afM + 8 );
+	__m128 d = _mm_loadu_ps( afM + 12 );
+
+	// 2x2 determinants from the top two rows (sN) and the bottom two rows (tN), where e.g.
+	// s5 = a2*b3 - b2*a3. Each vector holds the determinants needed together below:
+	//     S1 = (s5,s5,s4,s3)  S2 = (s4,s2,s2,s1)  S3 = (s3,s1,s0,s0), and the same for T
+	#define GEN_SWIZZLE( v, x, y, z, w ) _mm_shuffle_ps( v, v, _MM_SHUFFLE(w,z,y,x) )
+	__m128 a2211 = GEN_SWIZZLE( a, 2,2,1,1 ), b2211 = GEN_SWIZZLE( b, 2,2,1,1 );
+	__m128 a3332 = GEN_SWIZZLE( a, 3,3,3,2 ), b3332 = GEN_SWIZZLE( b, 3,3,3,2 );
+	__m128 a1000 = GEN_SWIZZLE( a, 1,0,0,0 ), b1000 = GEN_SWIZZLE( b, 1,0,0,0 );
+	__m128 S1 = _mm_sub_ps( _mm_mul_ps( a2211, b3332 ), _mm_mul_ps( b2211, a3332 ) );
+	__m128 S2 = _mm_sub_ps( _mm_mul_ps( a1000, b3332 ), _mm_mul_ps( b1000, a3332 ) );
+	__m128 S3 = _mm_sub_ps( _mm_mul_ps( a1000, b2211 ), _mm_mul_ps( b1000, a2211 ) );
+
+	__m128 c2211 = GEN_SWIZZLE( c, 2,2,1,1 ), d2211 = GEN_SWIZZLE( d, 2,2,1,1 );
+	__m128 c3332 = GEN_SWIZZLE( c, 3,3,3,2 ), d3332 = GEN_SWIZZLE( d, 3,3,3,2 );
+	__m128 c1000 = GEN_SWIZZLE( c, 1,0,0,0 ), d1000 = GEN_SWIZZLE( d, 1,0,0,0 );
+	__m128 T1 = _mm_sub_ps( _mm_mul_ps( c2211, d3332 ), _mm_mul_ps( d2211, c3332 ) );
+	__m128 T2 = _mm_sub_ps( _mm_mul_ps( c1000, d3332 ), _mm_mul_ps( d1000, c3332 ) );
+	__m128 T3 = _mm_sub_ps( _mm_mul_ps( c1000, d2211 ), _mm_mul_ps( d1000, c2211 ) );
+
+	// Columns of the adjoint matrix. Column 0 holds the cofactors of row a, e.g. the first is
+	// b1*t5 - b2*t4 + b3*t3. The signs alternate down each column and across each row
+	__m128 col0 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( b1000, T1 ), _mm_mul_ps( b2211, T2 ) ),
+	                          _mm_mul_ps( GEN_SWIZZLE( b, 3,3,3,2 ), T3 ) );
+	__m128 col1 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( a1000, T1 ), _mm_mul_ps( a2211, T2 ) ),
+	                          _mm_mul_ps( a3332, T3 ) );
+	__m128 col2 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( d1000, S1 ), _mm_mul_ps( d2211, S2 ) ),
+	                          _mm_mul_ps( d3332, S3 ) );
+	__m128 col3 = _mm_add_ps( _mm_sub_ps( _mm_mul_ps( c1000, S1 ), _mm_mul_ps( c2211, S2 ) ),
+	                          _mm_mul_ps( c3332, S3 ) );
+	#undef GEN_SWIZZLE
+
+	const __m128 signsPMPM = _mm_set_ps( -1.0f, 1.0f, -1.0f, 1.0f );
+	const __m128 signsMPMP = _mm_set_ps( 1.0f, -1.0f, 1.0f, -1.0f );
+	col0 = _mm_mul_ps( col0, signsPMPM );
+	col1 = _mm_mul_ps( col1, signsMPMP );
+	col2 = _mm_mul_ps( col2, signsPMPM );
+	col3 = _mm_mul_ps( col3, signsMPMP );
+
+	// Determinant is row a dotted with its cofactors. Inverse is the adjoint over the determinant
+	__m128 det = HorizontalSumSSE( _mm_mul_ps( a, col0 ) );
+	__m128 invDet = _mm_div_ps( _mm_set1_ps( 1.0f ), det );
+	_MM_TRANSPOSE4_PS( col0, col1, col2, col3 );
+	_mm_storeu_ps( afOut, _mm_mul_ps( col0, invDet ) );
+	_mm_storeu_ps( afOut + 4, _mm_mul_ps( col1, invDet ) );
+	_mm_storeu_ps( afOut + 8, _mm_mul_ps( col2, invDet ) );
+	_mm_storeu_ps( afOut + 12, _mm_mul_ps( col3, invDet ) );
+	return _mm_cvtss_f32( det );
+}
+
+// Vector-matrix multiplication of a 4 element vector: afOut = afV * afM
+inline void Matrix4x4TransformSSE( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut )
+{
+	__m128 v = _mm_loadu_ps( afV );
+	_mm_storeu_ps( afOut, Matrix4x4RowSSE( v, _mm_loadu_ps( afM ), _mm_loadu_ps( afM + 4 ),
+	                                       _mm_loadu_ps( afM + 8 ), _mm_loadu_ps( afM + 12 ) ) );
+}
+
+// Vector-matrix multiplication of a 3 element point (4th element taken as 1)
+inline void Matrix4x4TransformPointSSE( const TFloat32* afM, const TFloat32* afP, TFloat32* afOut )
+{
+	__m128 sum = _mm_mul_ps( _mm_set1_ps( afP[0] ), _mm_loadu_ps( afM ) );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( afP[1] ), _mm_loadu_ps( afM + 4 ) ) );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( afP[2] ), _mm_loadu_ps( afM + 8 ) ) );
+	sum = _mm_add_ps( sum, _mm_loadu_ps( afM + 12 ) );
+
+	// Only three elements are written
+	GEN_ALIGN(16) TFloat32 afResult[4];
+	_mm_store_ps( afResult, sum );
+	afOut[0] = afResult[0];
+	afOut[1] = afResult[1];
+	afOut[2] = afResult[2];
+}
+
+// Vector-matrix multiplication of a 3 element vector (4th element taken as 0)
+inline void Matrix4x4TransformVectorSSE( const TFloat32* afM, const TFloat32* afV,
+                                         TFloat32* afOut )
+{
+	__m128 sum = _mm_mul_ps( _mm_set1_ps( afV[0] ), _mm_loadu_ps( afM ) );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( afV[1] ), _mm_loadu_ps( afM + 4 ) ) );
+	sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( afV[2] ), _mm_loadu_ps( afM + 8 ) ) );
+
+	GEN_ALIGN(16) TFloat32 afResult[4];
+	_mm_store_ps( afResult, sum );
+	afOut[0] = afResult[0];
+	afOut[1] = afResult[1];
+	afOut[2] = afResult[2];
+}
+
+#endif // GEN_MATH_SSE
+
+
+/*-----------------------------------------------------------------------------------------
+	Selected kernels
+-----------------------------------------------------------------------------------------*/
+// The kernels used by CMatrix4x4 - SSE versions if available, otherwise reference versions
+
+#ifdef GEN_MATH_SSE
+	#define GEN_MATRIX_KERNEL( name ) name##SSE
+#else
+	#define GEN_MATRIX_KERNEL( name ) name##Ref
+#endif
+
+inline void Matrix4x4Multiply( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4Multiply )( afM1, afM2, afOut );
+}
+inline void Matrix4x4MultiplyAffine( const TFloat32* afM1, const TFloat32* afM2, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4MultiplyAffine )( afM1, afM2, afOut );
+}
+inline void Matrix4x4Transpose( const TFloat32* afM, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4Transpose )( afM, afOut );
+}
+inline TFloat32 Matrix4x4InverseAffine( const TFloat32* afM, TFloat32* afOut )
+{
+	return GEN_MATRIX_KERNEL( Matrix4x4InverseAffine )( afM, afOut );
+}
+inline TFloat32 Matrix4x4Inverse( const TFloat32* afM, TFloat32* afOut )
+{
+	return GEN_MATRIX_KERNEL( Matrix4x4Inverse )( afM, afOut );
+}
+inline void Matrix4x4Transform( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4Transform )( afM, afV, afOut );
+}
+inline void Matrix4x4TransformPoint( const TFloat32* afM, const TFloat32* afP, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4TransformPoint )( afM, afP, afOut );
+}
+inline void Matrix4x4TransformVector( const TFloat32* afM, const TFloat32* afV, TFloat32* afOut )
+{
+	GEN_MATRIX_KERNEL( Matrix4x4TransformVector )( afM, afV, afOut );
+}
+
+#undef GEN_MATRIX_KERNEL
+
+
+/*-----------------------------------------------------------------------------------------
+	Validation
+-----------------------------------------------------------------------------------------*/
+
+// Compare the selected kernels against the reference kernels on the given number of random
+// matrices and vectors. Returns the largest difference found in any output element, relative to
+// the size of the reference result. Returns 0 if the reference kernels are selected
+TFloat32 ValidateMatrixKernels( const TUInt32 iNumTests );
+
+
+} // namespace gen
+
+#endif // GEN_MATRIX_KERNELS_H_INCLUDED
@@ -23,6 +23,7 @@ using namespace std;
 
 #include "Error.h"
 #include "CImportXFile.h"
+#include "BatchKernels.h"
 
 namespace gen
 {
@@ -2102,14 +2103,21 @@ bool CImportXFile::CalculateTangents
 		(*pTangents)[i3] += tangent;
 	}
 
-	// Orthogonalise normals and tangents
-	for (TUInt32 iVert = 0; iVert < m_Meshes[iMesh].vertices.size(); ++iVert)
+	// Orthogonalise normals and tangents (Gram-Schmidt), using batch kernels for the dot
+	// products and normalisation
+	TUInt32 iNumVerts = static_cast<TUInt32>(m_Meshes[iMesh].vertices.size());
+	if (iNumVerts == 0)
 	{
-		// Gram-Schmidt orthogonalize
-		TFloat32 dot = Dot( m_Meshes[iMesh].normals[iVert], (*pTangents)[iVert] );
-		(*pTangents)[iVert] -= dot * m_Meshes[iMesh].normals[iVert];
-		(*pTangents)[iVert].Normalise();
+		return true;
 	}
+	vector<TFloat32> dots( iNumVerts );
+	Vector3Dot( &m_Meshes[iMesh].normals[0], sizeof(CVector3), &(*pTangents)[0], sizeof(CVector3),
+	            &dots[0], iNumVerts );
+	for (TUInt32 iVert = 0; iVert < iNumVerts; ++iVert)
+	{
+		(*pTangents)[iVert] -= dots[iVert] * m_Meshes[iMesh].normals[iVert];
+	}
+	Vector3Normalise( &(*pTangents)[0], sizeof(CVector3), iNumVerts );
 
 	return true;
 }
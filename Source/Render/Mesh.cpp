@@ -9,6 +9,7 @@
 #include "Mesh.h"
 #include "CImportXFile.h"
 #include "RenderMethod.h"
+#include "BatchKernels.h"
 
 namespace gen
 {
@@ -516,16 +517,9 @@ bool CMesh::PreProcess()
 		return false;
 	}
 
-	// Set initial bounds from first vertex
-	// Assuming first three floats are the vertex coord x,y & z. Would be better to support
-	// a flexible data type system like DirectX vertex declarations (D3DVERTEXELEMENT9)
-	TFloat32* pVertexCoord = reinterpret_cast<TFloat32*>(m_SubMeshes[0].vertices);
-	m_MinBounds.x = m_MaxBounds.x = *pVertexCoord++;
-	m_MinBounds.y = m_MaxBounds.y = *pVertexCoord++;
-	m_MinBounds.z = m_MaxBounds.z = *pVertexCoord;
-	m_BoundingRadius = m_MinBounds.Length();
-
 	// Go through all submeshes ...
+	// Assuming first three floats of each vertex are the vertex coord x,y & z. Would be better to
+	// support a flexible data type system like DirectX vertex declarations (D3DVERTEXELEMENT9)
 	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
 	{
 		// Reject mesh if it contains empty sub-meshes
@@ -534,55 +528,27 @@ bool CMesh::PreProcess()
 			return false;
 		}
 
-		// Go through all vertices
-		TUInt8* pVertex = m_SubMeshes[subMesh].vertices;
-		for (TUInt32 vert = 0; vert < m_SubMeshes[subMesh].numVertices; ++vert)
+		// Get bounds and bounding radius of all vertices in the sub-mesh in one batch (flexible
+		// vertex size used as stride)
+		CVector3 minBounds, maxBounds;
+		TFloat32 boundingRadius;
+		Vector3Bounds( m_SubMeshes[subMesh].vertices, m_SubMeshes[subMesh].vertexSize,
+		               m_SubMeshes[subMesh].numVertices, &minBounds.x, &maxBounds.x, &boundingRadius );
+
+		// Combine with bounds of previous sub-meshes
+		if (subMesh == 0)
+		{
+			m_MinBounds = minBounds;
+			m_MaxBounds = maxBounds;
+			m_BoundingRadius = boundingRadius;
+		}
+		else
 		{
-			// Get vertex coord as vector
-			pVertexCoord = reinterpret_cast<TFloat32*>(pVertex); // Assume float x,y,z coord again
-			CVector3 vertex;
-			vertex.x = *pVertexCoord++;
-			vertex.y = *pVertexCoord++;
-			vertex.z = *pVertexCoord;
-			
-			// Compare vertex against current bounds, updating bounds where necessary
-			if (vertex.x < m_MinBounds.x)
-			{
-				m_MinBounds.x = vertex.x;
-			}
-			if (vertex.x > m_MaxBounds.x)
-			{
-				m_MaxBounds.x = vertex.x;
-			}
-			++pVertexCoord;
-
-			if (vertex.y < m_MinBounds.y)
-			{
-				m_MinBounds.y = vertex.y;
-			}
-			if (vertex.y > m_MaxBounds.y)
-			{
-				m_MaxBounds.y = vertex.y;
-			}
-			++pVertexCoord;
-
-			if (vertex.z < m_MinBounds.z)
-			{
-				m_MinBounds.z = vertex.z;
-			}
-			if (vertex.z > m_MaxBounds.z)
-			{
-				m_MaxBounds.z = vertex.z;
-			}
-
-			TFloat32 length = vertex.Length();
-			if (length > m_BoundingRadius)
-			{
-				m_BoundingRadius = length;
-			}
-
-			// Step to next vertex (flexible vertex size)
-			pVertex += m_SubMeshes[subMesh].vertexSize;
+			m_MinBounds = CVector3( Min( m_MinBounds.x, minBounds.x ), Min( m_MinBounds.y, minBounds.y ),
+			                        Min( m_MinBounds.z, minBounds.z ) );
+			m_MaxBounds = CVector3( Max( m_MaxBounds.x, maxBounds.x ), Max( m_MaxBounds.y, maxBounds.y ),
+			                        Max( m_MaxBounds.z, maxBounds.z ) );
+			m_BoundingRadius = Max( m_BoundingRadius, boundingRadius );
 		}
 	}
 
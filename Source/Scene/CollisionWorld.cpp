@@ -0,0 +1,494 @@
+/*******************************************
+	CollisionWorld.cpp
+
+	Static collision world of scenery
+	bounding volumes in a BVH
+********************************************/
+
+#include <algorithm>
+using namespace std;
+
+#include "CollisionWorld.h"
+#include "Intersection.h"
+#include "BatchKernels.h"
+#include "BaseMath.h"
+#include "Error.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor creates an empty world
+CCollisionWorld::CCollisionWorld()
+{
+}
+
+
+/////////////////////////////////////
+// Construction
+
+// Add a collider for an entity, given its mesh bounds in model space and its world matrix
+void CCollisionWorld::Add( TEntityUID UID, const CVector3& minBounds, const CVector3& maxBounds,
+                           TFloat32 boundingRadius, const CMatrix4x4& matrix )
+{
+	SCollider collider;
+	collider.UID = UID;
+
+	// Transform the eight corners of the model space box and take the box around them
+	CVector3 corners[8];
+	for (TUInt32 corner = 0; corner < 8; ++corner)
+	{
+		corners[corner] = CVector3( (corner & 1) ? maxBounds.x : minBounds.x,
+		                            (corner & 2) ? maxBounds.y : minBounds.y,
+		                            (corner & 4) ? maxBounds.z : minBounds.z );
+	}
+	Vector3TransformPoints( &matrix.e00, corners, sizeof(CVector3), corners, sizeof(CVector3), 8 );
+	Vector3Bounds( corners, sizeof(CVector3), 8, &collider.minBounds.x, &collider.maxBounds.x );
+
+	// The bounding radius is measured from the model origin, scale it by the largest axis scale
+	TFloat32 scale = Max( Max( Length( matrix.XAxis() ), Length( matrix.YAxis() ) ),
+	                      Length( matrix.ZAxis() ) );
+	collider.centre = matrix.Position();
+	collider.radius = boundingRadius * scale;
+
+	m_Colliders.push_back( collider );
+}
+
+// Build the BVH from the colliders added so far
+void CCollisionWorld::Build()
+{
+	GEN_GUARD;
+
+	m_Nodes.clear();
+	if (!m_Colliders.empty())
+	{
+		// A binary tree with small leaves has fewer than one node per collider
+		m_Nodes.reserve( m_Colliders.size() );
+		BuildNode( 0, static_cast<TUInt32>(m_Colliders.size()) );
+	}
+
+	GEN_ENDGUARD;
+}
+
+// Remove all colliders
+void CCollisionWorld::Clear()
+{
+	m_Colliders.clear();
+	m_Nodes.clear();
+}
+
+
+// Compares colliders by the centre of their box on one axis, used to split nodes in Build
+class CColliderAxisLess
+{
+public:
+	CColliderAxisLess( TUInt32 axis ) : m_Axis( axis ) {}
+
+	template <class TCollider>
+	bool operator()( const TCollider& a, const TCollider& b ) const
+	{
+		return a.minBounds[m_Axis] + a.maxBounds[m_Axis] < b.minBounds[m_Axis] + b.maxBounds[m_Axis];
+	}
+
+private:
+	TUInt32 m_Axis;
+};
+
+// Build the node for the colliders from first to first + count - 1, and the nodes below it.
+// Returns the index of the node
+TUInt32 CCollisionWorld::BuildNode( TUInt32 first, TUInt32 count )
+{
+	// Node box contains all its colliders
+	SNode node;
+	node.minBounds = m_Colliders[first].minBounds;
+	node.maxBounds = m_Colliders[first].maxBounds;
+	for (TUInt32 collider = first + 1; collider < first + count; ++collider)
+	{
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			node.minBounds[axis] = Min( node.minBounds[axis], m_Colliders[collider].minBounds[axis] );
+			node.maxBounds[axis] = Max( node.maxBounds[axis], m_Colliders[collider].maxBounds[axis] );
+		}
+	}
+
+	TUInt32 nodeIndex = static_cast<TUInt32>(m_Nodes.size());
+	if (count <= MaxLeafColliders)
+	{
+		node.first = first;
+		node.count = count;
+		m_Nodes.push_back( node );
+		return nodeIndex;
+	}
+
+	// Split the colliders in half at the median along the longest axis of the node box. The
+	// first child follows this node in the array, so only the second child's index is stored
+	node.count = 0;
+	m_Nodes.push_back( node );
+
+	CVector3 extents = node.maxBounds - node.minBounds;
+	TUInt32 axis = 0;
+	if (extents.y > extents[axis]) axis = 1;
+	if (extents.z > extents[axis]) axis = 2;
+
+	TUInt32 half = count / 2;
+	nth_element( m_Colliders.begin() + first, m_Colliders.begin() + first + half,
+	             m_Colliders.begin() + first + count, CColliderAxisLess( axis ) );
+
+	BuildNode( first, half );
+	TUInt32 secondChild = BuildNode( first + half, count - half );
+	m_Nodes[nodeIndex].first = secondChild; // Node array may have moved, don't keep a reference
+	return nodeIndex;
+}
+
+
+/////////////////////////////////////
+// Queries
+
+// Test if a point is inside any collider
+bool CCollisionWorld::PointQuery( const CVector3& point, TEntityUID* hitUID /*= 0*/ )
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	TUInt32 stack[MaxQueryStack];
+	TUInt32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		TUInt32 nodeIndex = stack[--stackSize];
+		const SNode& node = m_Nodes[nodeIndex];
+		if (!PointAABB( point, node.minBounds, node.maxBounds ))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (TUInt32 collider = node.first; collider < node.first + node.count; ++collider)
+			{
+				if (PointAABB( point, m_Colliders[collider].minBounds, m_Colliders[collider].maxBounds ))
+				{
+					if (hitUID) *hitUID = m_Colliders[collider].UID;
+					return true;
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+	return false;
+}
+
+
+// Test if the line segment from start to end intersects any collider, giving the first contact
+bool CCollisionWorld::SegmentQuery( const CVector3& start, const CVector3& end,
+                                    TFloat32* pfT /*= 0*/, TEntityUID* hitUID /*= 0*/ )
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	// Nearest contact so far - nodes whose box is first touched beyond it can be skipped
+	TFloat32   nearestT = kfNoIntersection;
+	TEntityUID nearestUID = NullUID;
+
+	TUInt32 stack[MaxQueryStack];
+	TUInt32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		TUInt32 nodeIndex = stack[--stackSize];
+		const SNode& node = m_Nodes[nodeIndex];
+		TFloat32 nodeT;
+		if (!SegmentAABB( start, end, node.minBounds, node.maxBounds, &nodeT ) || nodeT >= nearestT)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (TUInt32 collider = node.first; collider < node.first + node.count; ++collider)
+			{
+				// The bounding sphere is a quick rejection before the box test
+				const SCollider& test = m_Colliders[collider];
+				TFloat32 colliderT;
+				if (SegmentSphere( start, end, test.centre, test.radius ) &&
+				    SegmentAABB( start, end, test.minBounds, test.maxBounds, &colliderT ) &&
+				    colliderT < nearestT)
+				{
+					nearestT = colliderT;
+					nearestUID = test.UID;
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+
+	if (nearestUID == NullUID)
+	{
+		return false;
+	}
+	if (pfT) *pfT = nearestT;
+	if (hitUID) *hitUID = nearestUID;
+	return true;
+}
+
+
+// Find the colliders intersecting a sphere, returns the number found
+TUInt32 CCollisionWorld::SphereQuery( const CVector3& centre, TFloat32 radius,
+                                      TEntityUID* results, TUInt32 maxResults )
+{
+	if (m_Nodes.empty())
+	{
+		return 0;
+	}
+
+	TUInt32 numFound = 0;
+	TUInt32 stack[MaxQueryStack];
+	TUInt32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		TUInt32 nodeIndex = stack[--stackSize];
+		const SNode& node = m_Nodes[nodeIndex];
+		if (!SphereAABB( centre, radius, node.minBounds, node.maxBounds ))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (TUInt32 collider = node.first; collider < node.first + node.count; ++collider)
+			{
+				if (SphereAABB( centre, radius, m_Colliders[collider].minBounds,
+				                m_Colliders[collider].maxBounds ))
+				{
+					if (numFound < maxResults)
+					{
+						results[numFound] = m_Colliders[collider].UID;
+					}
+					++numFound;
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+	return numFound;
+}
+
+
+// Find the first contact of each of a batch of segments with the colliders, in one traversal of
+// the BVH
+void CCollisionWorld::SegmentQueryBatch( const CVector3* starts, const CVector3* ends,
+                                         TUInt32 numSegments, TFloat32* nearestT )
+{
+	m_BatchT.assign( numSegments, kfNoIntersection );
+	SegmentBatch( starts, ends, numSegments );
+	for (TUInt32 segment = 0; segment < numSegments; ++segment)
+	{
+		nearestT[segment] = m_BatchT[segment];
+	}
+}
+
+
+// Test a batch of lines of sight against the colliders in one traversal of the BVH
+void CCollisionWorld::LineOfSightBatch( SLineOfSight* lines, TUInt32 numLines )
+{
+	// Obstructions must be before the target, so only contacts before the end of each line count
+	m_BatchStarts.resize( numLines );
+	m_BatchEnds.resize( numLines );
+	for (TUInt32 line = 0; line < numLines; ++line)
+	{
+		m_BatchStarts[line] = lines[line].from;
+		m_BatchEnds[line] = lines[line].to;
+	}
+	m_BatchT.assign( numLines, 1.0f );
+	if (numLines > 0)
+	{
+		SegmentBatch( &m_BatchStarts[0], &m_BatchEnds[0], numLines );
+	}
+
+	// A line is visible if nothing was found before its end
+	for (TUInt32 line = 0; line < numLines; ++line)
+	{
+		lines[line].visible = (m_BatchT[line] >= 1.0f);
+		lines[line].distance = m_BatchT[line] * Distance( lines[line].from, lines[line].to );
+	}
+}
+
+
+// Move a sphere horizontally out of any colliders it intersects, returns true if it was moved
+bool CCollisionWorld::PushOutSphere( CVector3& centre, TFloat32 radius )
+{
+	if (m_Nodes.empty())
+	{
+		return false;
+	}
+
+	bool moved = false;
+	TUInt32 stack[MaxQueryStack];
+	TUInt32 stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		TUInt32 nodeIndex = stack[--stackSize];
+		const SNode& node = m_Nodes[nodeIndex];
+		if (!SphereAABB( centre, radius, node.minBounds, node.maxBounds ))
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (TUInt32 collider = node.first; collider < node.first + node.count; ++collider)
+			{
+				const CVector3& minBounds = m_Colliders[collider].minBounds;
+				const CVector3& maxBounds = m_Colliders[collider].maxBounds;
+				if (!SphereAABB( centre, radius, minBounds, maxBounds ))
+				{
+					continue;
+				}
+
+				// Push away from the nearest point on the box in the XZ plane
+				CVector3 offset = centre - ClosestPointAABB( centre, minBounds, maxBounds );
+				offset.y = 0.0f;
+				TFloat32 distance = Length( offset );
+				if (distance > kfEpsilon)
+				{
+					if (distance < radius)
+					{
+						centre += offset * ((radius - distance) / distance);
+						moved = true;
+					}
+				}
+				else
+				{
+					// Centre is inside the box (in XZ), push out through the nearest side
+					TFloat32 pushes[4] = { centre.x - minBounds.x + radius, maxBounds.x - centre.x + radius,
+					                       centre.z - minBounds.z + radius, maxBounds.z - centre.z + radius };
+					TUInt32 side = 0;
+					for (TUInt32 i = 1; i < 4; ++i)
+					{
+						if (pushes[i] < pushes[side]) side = i;
+					}
+					if (side == 0)      centre.x -= pushes[0];
+					else if (side == 1) centre.x += pushes[1];
+					else if (side == 2) centre.z -= pushes[2];
+					else                centre.z += pushes[3];
+					moved = true;
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+	return moved;
+}
+
+
+// Find the nearest contact of each segment with the colliders, in one traversal of the BVH
+void CCollisionWorld::SegmentBatch( const CVector3* starts, const CVector3* ends,
+                                    TUInt32 numSegments )
+{
+	if (m_Nodes.empty() || numSegments == 0)
+	{
+		return;
+	}
+
+	// Each node visited has a list of the segments that touch its parent's box. The lists are
+	// ranges in m_BatchLines. A node's list is filtered into a new range at the end of the array
+	// for its children. Ranges are released as the stack unwinds, nodes still waiting on the
+	// stack only use ranges earlier in the array
+	struct SVisit
+	{
+		TUInt32 node;
+		TUInt32 firstLine;
+		TUInt32 numLines;
+	};
+	SVisit stack[MaxQueryStack];
+	TUInt32 stackSize = 0;
+
+	m_BatchLines.resize( numSegments );
+	for (TUInt32 segment = 0; segment < numSegments; ++segment)
+	{
+		m_BatchLines[segment] = segment;
+	}
+	m_BatchTestT.resize( numSegments );
+	SVisit root = { 0, 0, numSegments };
+	stack[stackSize++] = root;
+
+	while (stackSize > 0)
+	{
+		SVisit visit = stack[--stackSize];
+		m_BatchLines.resize( visit.firstLine + visit.numLines );
+		const SNode& node = m_Nodes[visit.node];
+
+		// Find the segments that touch this node's box before their nearest contact so far
+		SegmentAABBBatch( starts, ends, &m_BatchLines[visit.firstLine], visit.numLines,
+		                  node.minBounds, node.maxBounds, &m_BatchTestT[0] );
+		TUInt32 firstHit = static_cast<TUInt32>(m_BatchLines.size());
+		for (TUInt32 i = 0; i < visit.numLines; ++i)
+		{
+			TUInt32 segment = m_BatchLines[visit.firstLine + i];
+			if (m_BatchTestT[i] < m_BatchT[segment])
+			{
+				m_BatchLines.push_back( segment );
+			}
+		}
+		TUInt32 numHits = static_cast<TUInt32>(m_BatchLines.size()) - firstHit;
+		if (numHits == 0)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			// Test the segments against each of the leaf's colliders in a batch. As in
+			// SegmentQuery, a contact must also touch the collider's bounding sphere
+			for (TUInt32 collider = node.first; collider < node.first + node.count; ++collider)
+			{
+				const SCollider& test = m_Colliders[collider];
+				SegmentAABBBatch( starts, ends, &m_BatchLines[firstHit], numHits,
+				                  test.minBounds, test.maxBounds, &m_BatchTestT[0] );
+				for (TUInt32 i = 0; i < numHits; ++i)
+				{
+					TUInt32 segment = m_BatchLines[firstHit + i];
+					if (m_BatchTestT[i] < m_BatchT[segment] &&
+					    SegmentSphere( starts[segment], ends[segment], test.centre, test.radius ))
+					{
+						m_BatchT[segment] = m_BatchTestT[i];
+					}
+				}
+			}
+		}
+		else
+		{
+			SVisit second = { node.first, firstHit, numHits };
+			SVisit first = { visit.node + 1, firstHit, numHits };
+			stack[stackSize++] = second;
+			stack[stackSize++] = first;
+		}
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,191 @@
+/*******************************************
+	CollisionWorld.h
+
+	Static collision world of scenery
+	bounding volumes in a BVH
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CMatrix4x4.h"
+#include "EntityHandle.h"
+
+namespace gen
+{
+
+// A line of sight query for CCollisionWorld::LineOfSightBatch. Set the from and to points, e.g.
+// a shooter's turret and its target, the results are written to visible and distance
+struct SLineOfSight
+{
+	CVector3 from;
+	CVector3 to;
+	bool     visible;  // True if no scenery is between the points
+	TFloat32 distance; // Distance to the first obstruction, or to the target if visible
+};
+
+
+// The collision world holds the bounding volumes of static scenery (buildings, trees etc.) for
+// point, segment and sphere queries. Each collider is the world-space axis-aligned box around an
+// entity's mesh bounds, transformed by the entity's matrix, along with a bounding sphere from the
+// mesh's bounding radius
+//
+// Colliders are added once at scene setup, then Build arranges them in a bounding volume
+// hierarchy (BVH), a binary tree of boxes where each node's box contains all the colliders below
+// it. Queries descend only into the nodes whose box they touch, so the cost depends on the
+// scenery near the query rather than the total amount. The world is static - colliders don't
+// move, and adding colliders after Build requires another call to Build
+class CCollisionWorld
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor creates an empty world
+	CCollisionWorld();
+
+	// No destructor needed
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CCollisionWorld( const CCollisionWorld& );
+	CCollisionWorld& operator=( const CCollisionWorld& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Construction
+
+	// Add a collider for an entity, given its mesh bounds in model space and its world matrix.
+	// The collider is not used by queries until the next call to Build
+	void Add( TEntityUID UID, const CVector3& minBounds, const CVector3& maxBounds,
+	          TFloat32 boundingRadius, const CMatrix4x4& matrix );
+
+	// Build the BVH from the colliders added so far
+	void Build();
+
+	// Remove all colliders
+	void Clear();
+
+
+	/////////////////////////////////////
+	// Queries
+
+	// Test if a point is inside any collider. If so returns true and sets hitUID (if given) to
+	// the entity of one of the colliders containing it
+	bool PointQuery( const CVector3& point, TEntityUID* hitUID = 0 );
+
+	// Test if the line segment from start to end intersects any collider. If so returns true and
+	// sets pfT (if given) to the fraction along the segment of the first contact, and hitUID (if
+	// given) to the entity of the collider hit first. The bounding sphere is tested before the
+	// box, so the segment must touch both - the mesh is inside both of them
+	bool SegmentQuery( const CVector3& start, const CVector3& end, TFloat32* pfT = 0,
+	                   TEntityUID* hitUID = 0 );
+
+	// Find the colliders intersecting a sphere. The entity UIDs are written to the given array,
+	// up to the given maximum. Returns the number of colliders found, which may be more than the
+	// maximum (only the first maximum are written)
+	TUInt32 SphereQuery( const CVector3& centre, TFloat32 radius, TEntityUID* results,
+	                     TUInt32 maxResults );
+
+	// Find the first contact of each of a batch of line segments with the colliders, given as
+	// arrays of start and end points. The fraction along each segment of its first contact is
+	// written to nearestT, or kfNoIntersection (see Intersection.h) if it hits nothing. Gives the
+	// same contacts as SegmentQuery, but traverses the BVH once for the whole batch, testing the
+	// segments that reach each box together
+	void SegmentQueryBatch( const CVector3* starts, const CVector3* ends, TUInt32 numSegments,
+	                        TFloat32* nearestT );
+
+	// Test a batch of lines of sight against the colliders, writing the visibility and distance
+	// of each. The BVH is traversed once for the whole batch, with each node tested against only
+	// the lines that reached its parent, so lines near each other share the work
+	void LineOfSightBatch( SLineOfSight* lines, TUInt32 numLines );
+
+	// Move a sphere out of any colliders it intersects, pushing it horizontally (in the XZ plane)
+	// away from the nearest point of each collider's box. Used to stop moving entities passing
+	// through scenery while letting them slide along it. Returns true if the sphere was moved
+	bool PushOutSphere( CVector3& centre, TFloat32 radius );
+
+
+	// Return the number of colliders in the world
+	TUInt32 NumColliders()
+	{
+		return static_cast<TUInt32>(m_Colliders.size());
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// A collider - world-space box and bounding sphere of one entity
+	struct SCollider
+	{
+		CVector3   minBounds;
+		CVector3   maxBounds;
+		CVector3   centre;  // Bounding sphere centre (entity position)
+		TFloat32   radius;
+		TEntityUID UID;
+	};
+
+	// A node in the BVH, stored in an array in depth-first order so a node's first child is the
+	// next node in the array. Leaf nodes refer to a range of colliders, other nodes give the
+	// index of their second child
+	struct SNode
+	{
+		CVector3 minBounds;
+		CVector3 maxBounds;
+		TUInt32  first;  // First collider in a leaf, or index of the second child
+		TUInt32  count;  // Number of colliders in a leaf, 0 for other nodes
+	};
+
+	// Most colliders in a leaf node
+	static const TUInt32 MaxLeafColliders = 4;
+
+	// Most nodes waiting to be visited in a query - enough for a tree of any practical depth
+	static const TUInt32 MaxQueryStack = 64;
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Build the node for the colliders from first to first + count - 1, and the nodes below it.
+	// Returns the index of the node
+	TUInt32 BuildNode( TUInt32 first, TUInt32 count );
+
+	// Find the nearest contact of each of a batch of segments with the colliders. Only contacts
+	// before the value in m_BatchT for each segment are found, and m_BatchT is updated with them
+	void SegmentBatch( const CVector3* starts, const CVector3* ends, TUInt32 numSegments );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Colliders, reordered by Build so each leaf's colliders are together
+	vector<SCollider> m_Colliders;
+
+	// BVH nodes, the root is the first. Empty until Build is called
+	vector<SNode> m_Nodes;
+
+	// Working space for the batched queries, kept to avoid allocation on each call. Segments of
+	// the lines of sight, nearest contact fraction of each segment, lists of the segments that
+	// reach each node being visited, and the results of each batch of box tests
+	vector<CVector3> m_BatchStarts;
+	vector<CVector3> m_BatchEnds;
+	vector<TFloat32> m_BatchT;
+	vector<TUInt32>  m_BatchLines;
+	vector<TFloat32> m_BatchTestT;
+};
+
+
+} // namespace gen
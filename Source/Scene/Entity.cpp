@@ -15,55 +15,104 @@ namespace gen
 -------------------------------------------------------------------------------------------
 -----------------------------------------------------------------------------------------*/
 
-// Base entity constructor, needs pointer to common template data and UID, may also pass 
-// name, initial position, rotation and scaling. Set up positional matrices for the entity
+// Base entity constructor, needs the entity storage, pointer to common template data and UID,
+// may also pass name (as a name table symbol), initial position, rotation and scaling, and a
+// reserved transform block. Set up positional matrices for the entity
 CEntity::CEntity
 (
+	CEntityStorage*  storage,
 	CEntityTemplate* entityTemplate,
 	TEntityUID       UID,
-	const string&    name /*=""*/,
+	TSymbol          name /*= NullSymbol*/,
 	const CVector3&  position /*= CVector3::kOrigin*/, 
 	const CVector3&  rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
-	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
+	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/,
+	TUInt32          transforms /*= CEntityStorage::NoTransforms*/
 )
 {
+	m_Storage = storage;
 	m_Template = entityTemplate;
 	m_UID = UID;
 	m_Name = name;
 
-	// Allocate space for matrices
+	// Allocate space for transforms in the entity storage, unless a reserved block was given
 	TUInt32 numNodes = m_Template->Mesh()->GetNumNodes();
-	m_RelMatrices = new CMatrix4x4[numNodes];
-	m_Matrices = new CMatrix4x4[numNodes];
+	m_OwnsTransforms = (transforms == CEntityStorage::NoTransforms);
+	m_Transforms = m_OwnsTransforms ? m_Storage->CreateTransforms( numNodes ) : transforms;
 
-	// Set initial matrices from mesh defaults
+	// Set initial transforms from mesh defaults
+	TNodeTransform* relTransforms = m_Storage->RelTransforms( m_Transforms );
 	for (TUInt32 node = 0; node < numNodes; ++node)
 	{
-		m_RelMatrices[node] = m_Template->Mesh()->GetNode( node ).positionMatrix;
+		relTransforms[node] = TNodeTransform( m_Template->Mesh()->GetNode( node ).positionMatrix );
 	}
 
-	// Override root matrix with constructor parameters
-	m_RelMatrices[0] = CMatrix4x4( position, rotation, kZXY, scale );
+	// Override root transform with constructor parameters
+	relTransforms[0] = TNodeTransform( CMatrix4x4( position, rotation, kZXY, scale ) );
 }
 
+
+// Move a node along its local Z axis, ignoring scaling
+void CEntity::MoveLocalZ( TFloat32 distance, TUInt32 node /*= 0*/ )
+{
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
+	m_Storage->RelTransforms( m_Transforms )[node].MoveLocalZ( distance );
+#else
+	CQuatTransform& transform = m_Storage->RelTransforms( m_Transforms )[node];
+	transform.pos += transform.quat.Rotate( CVector3( 0.0f, 0.0f, distance ) );
+#endif
+}
+
+// Rotate a node around its local Y axis
+void CEntity::RotateLocalY( TFloat32 angle, TUInt32 node /*= 0*/ )
+{
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
+	m_Storage->RelTransforms( m_Transforms )[node].RotateLocalY( angle );
+#else
+	// Local rotation is applied before the existing rotation. Renormalise so repeated rotations
+	// don't accumulate error in the quaternion's length
+	CQuatTransform& transform = m_Storage->RelTransforms( m_Transforms )[node];
+	TFloat32 s, c;
+	SinCos( angle * 0.5f, &s, &c );
+	transform.quat = CQuaternion( c, 0.0f, s, 0.0f ) * transform.quat;
+	transform.quat.Normalise();
+#endif
+}
+
+
 // Render the model
 void CEntity::Render()
 {
-	// Get pointer to mesh to simplify code
+	// Get pointers to mesh and transforms to simplify code
 	CMesh* Mesh = m_Template->Mesh();
+	TNodeTransform* relTransforms = m_Storage->RelTransforms( m_Transforms );
+	CMatrix4x4* matrices = m_Storage->Matrices( m_Transforms );
+	TUInt32 numNodes = Mesh->GetNumNodes();
 
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
 	// Calculate absolute matrices from relative node matrices & node heirarchy
-	m_Matrices[0] = m_RelMatrices[0];
-	TUInt32 numNodes = Mesh->GetNumNodes();
+	matrices[0] = relTransforms[0];
+	for (TUInt32 node = 1; node < numNodes; ++node)
+	{
+		matrices[node] = relTransforms[node] * matrices[Mesh->GetNode( node ).parent];
+	}
+#else
+	// Calculate absolute transforms from relative node transforms & node heirarchy, then convert
+	// each to a matrix once for rendering
+	TNodeTransform* transforms = m_Storage->WorldTransformScratch( numNodes );
+	transforms[0] = relTransforms[0];
+	relTransforms[0].GetMatrix( matrices[0] );
 	for (TUInt32 node = 1; node < numNodes; ++node)
 	{
-		m_Matrices[node] = m_RelMatrices[node] * m_Matrices[Mesh->GetNode( node ).parent];
+		transforms[node] = relTransforms[node] * transforms[Mesh->GetNode( node ).parent];
+		transforms[node].GetMatrix( matrices[node] );
 	}
+#endif
 	// Incorporate any bone<->mesh offsets (only relevant for skinning)
 	// Don't need this step for this exercise
 
 	// Render with absolute matrices
-	Mesh->Render( m_Matrices );
+	Mesh->Render( matrices );
 }
 
 
@@ -10,22 +10,17 @@
 using namespace std;
 
 #include "Defines.h"
+#include "StringTable.h"
 #include "CVector3.h"
 #include "CMatrix4x4.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "EntityHandle.h"
+#include "EntityStorage.h"
 
 namespace gen
 {
 
-/////////////////////////////////////
-//	Public types
-
-// An entity UID is just a 32 bit value
-typedef TUInt32 TEntityUID;
-const TEntityUID SystemUID = 0xffffffff;
-
-
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
 	Entity Template Base Class
@@ -44,8 +39,8 @@ public:
 	// and the associated mesh (e.g. "panda.x")
 	CEntityTemplate( const string& type, const string& name, const string& meshFilename )
 	{
-		m_Type = type;
-		m_Name = name;
+		m_Type = InternName( type );
+		m_Name = InternName( name );
 
 		// Load mesh
 		m_Mesh = new CMesh();
@@ -78,10 +73,21 @@ public:
 
 	const string& GetType()
 	{
-		return m_Type;
+		return NameString( m_Type );
 	}
 
 	const string& GetName()
+	{
+		return NameString( m_Name );
+	}
+
+	// Type and name as symbols in the name table (see StringTable.h), for fast comparison
+	TSymbol GetTypeSymbol()
+	{
+		return m_Type;
+	}
+
+	TSymbol GetNameSymbol()
 	{
 		return m_Name;
 	}
@@ -96,9 +102,9 @@ public:
 //	Private interface
 private:
 
-	// Type and name of the template
-	string m_Type;
-	string m_Name;
+	// Type and name of the template, as symbols in the name table
+	TSymbol m_Type;
+	TSymbol m_Name;
 
 	// The mesh representing this entity
 	CMesh* m_Mesh;
@@ -113,30 +119,38 @@ private:
 -----------------------------------------------------------------------------------------*/
 
 // Base entity holds a pointer to its template data and the current position as a set of
-// matrices. The entity can be rendered but its update function does nothing - base class
+// node transforms. The entity can be rendered but its update function does nothing - base class
 // entities are assumed to be static scene elements
+// The transforms are not held in the entity itself, but in the entity storage, see EntityStorage.h
 class CEntity
 {
 /////////////////////////////////////
 //	Constructors/Destructors
 public:
-	// Base entity constructor, needs pointer to common template data and UID, may also pass 
-	// name, initial position, rotation and scaling. Set up positional matrices for the entity
+	// Base entity constructor, needs the entity storage, pointer to common template data and UID,
+	// may also pass name (as a name table symbol), initial position, rotation and scaling. Set up
+	// positional matrices for the entity. A transform block reserved by the entity's creator may
+	// be passed (see CEntityStorage::ReserveTransforms), the entity then uses that block and does
+	// not free it. Otherwise a block is allocated from the storage
 	CEntity
 	(
+		CEntityStorage*  storage,
 		CEntityTemplate* entityTemplate,
 		TEntityUID       UID,
-		const string&    name = "",
+		TSymbol          name = NullSymbol,
 		const CVector3&  position = CVector3::kOrigin, 
 		const CVector3&  rotation = CVector3( 0.0f, 0.0f, 0.0f ),
-		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f )
+		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f ),
+		TUInt32          transforms = CEntityStorage::NoTransforms
 	);
 
 	// Destructor - base class destructors should always be virtual
 	virtual ~CEntity()
 	{
-		delete[] m_Matrices;
-		delete[] m_RelMatrices;
+		if (m_OwnsTransforms)
+		{
+			m_Storage->DestroyTransforms( m_Transforms, m_Template->Mesh()->GetNumNodes() );
+		}
 	}
 
 private:
@@ -163,23 +177,60 @@ public:
 	}
 
 	const string& GetName()
+	{
+		return NameString( m_Name );
+	}
+
+	// Name as a symbol in the name table (see StringTable.h), for fast comparison
+	TSymbol GetNameSymbol()
 	{
 		return m_Name;
 	}
 
 	/////////////////////////////////////
-	// Matrix access
+	// Transform access
 
-	// Direct access to position and matrix
+	// Direct access to the position of a node relative to its parent (the world position for
+	// the root). The reference is into the entity storage and should not be kept beyond the
+	// creation of another entity
 	CVector3& Position( TUInt32 node = 0 )
 	{
-		return m_RelMatrices[node].Position();
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
+		return m_Storage->RelTransforms( m_Transforms )[node].Position();
+#else
+		return m_Storage->RelTransforms( m_Transforms )[node].pos;
+#endif
 	}
+
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
+	// Direct access to the matrix of a node relative to its parent. Same lifetime as Position
 	CMatrix4x4& Matrix( TUInt32 node = 0 )
 	{
-		return m_RelMatrices[node];
+		return m_Storage->RelTransforms( m_Transforms )[node];
+	}
+#else
+	// Direct access to the quaternion transform of a node relative to its parent. Same lifetime
+	// as Position
+	CQuatTransform& Transform( TUInt32 node = 0 )
+	{
+		return m_Storage->RelTransforms( m_Transforms )[node];
 	}
 
+	// Return the matrix of a node relative to its parent. This is a copy, use Transform, Position
+	// or the movement functions below to change the node
+	CMatrix4x4 Matrix( TUInt32 node = 0 )
+	{
+		CMatrix4x4 matrix;
+		m_Storage->RelTransforms( m_Transforms )[node].GetMatrix( matrix );
+		return matrix;
+	}
+#endif
+
+	// Move a node along its local Z axis (ignoring scaling) or rotate it around its local Y axis
+	// (radians)
+	void MoveLocalZ( TFloat32 distance, TUInt32 node = 0 );
+	void RotateLocalY( TFloat32 angle, TUInt32 node = 0 );
+
 	/////////////////////////////////////
 	// Update / Render
 
@@ -192,20 +243,36 @@ public:
 	void Render();
 
 
+/////////////////////////////////////
+//	Protected interface
+protected:
+
+	// Access to the storage holding the entity data, for derived entity classes
+	CEntityStorage* Storage()
+	{
+		return m_Storage;
+	}
+
+
 /////////////////////////////////////
 //	Private interface
 private:
 
+	// The storage holding the data for this entity
+	CEntityStorage* m_Storage;
+
 	// The template used by this entity - the common data for all entities of this type
 	CEntityTemplate* m_Template;
 
-	// Unique identifier and name for the entity
+	// Unique identifier and name for the entity, the name is a symbol in the name table
 	TEntityUID  m_UID;
-	string      m_Name;
+	TSymbol     m_Name;
 
-	// Relative and absolute world matrices for each node in the template's mesh
-	CMatrix4x4* m_RelMatrices; // Dynamically allocated arrays
-	CMatrix4x4* m_Matrices;
+	// Index of the relative transforms and absolute world matrices for each node in the
+	// template's mesh. The transforms themselves are held in the entity storage. The block is
+	// freed with the entity unless it was reserved by the entity's creator
+	TUInt32 m_Transforms;
+	bool    m_OwnsTransforms;
 };
 
 
@@ -0,0 +1,149 @@
+/*******************************************
+	EntityCursor.cpp
+
+	Entity queries - cursors stepping through
+	the entities matching a query
+********************************************/
+
+#include "EntityCursor.h"
+#include "EntityManager.h"
+#include "Utility.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Default constructor creates a cursor with no query, Next will return 0
+CEntityCursor::CEntityCursor()
+{
+	m_Manager = 0;
+	m_Predicate = 0;
+	m_UserData = 0;
+	m_Position = 0;
+}
+
+// Constructor begins a query on the given entity manager, see Begin
+CEntityCursor::CEntityCursor
+(
+	CEntityManager*  manager,
+	const string&    name /*= ""*/,
+	const string&    templateName /*= ""*/,
+	const string&    templateType /*= ""*/,
+	TEntityPredicate predicate /*= 0*/,
+	void*            userData /*= 0*/
+)
+{
+	Begin( manager, name, templateName, templateType, predicate, userData );
+}
+
+
+/////////////////////////////////////
+// Public interface
+
+// Begin a new query on the given entity manager, replacing any previous query
+void CEntityCursor::Begin
+(
+	CEntityManager*  manager,
+	const string&    name /*= ""*/,
+	const string&    templateName /*= ""*/,
+	const string&    templateType /*= ""*/,
+	TEntityPredicate predicate /*= 0*/,
+	void*            userData /*= 0*/
+)
+{
+	m_Manager = manager;
+	SetField( m_Name, name );
+	SetField( m_TemplateName, templateName );
+	SetField( m_TemplateType, templateType );
+	m_Predicate = predicate;
+	m_UserData = userData;
+
+	m_Candidates.clear();
+	m_Position = 0;
+
+	// A field without wildcards that is not in the name table can't match any entity
+	if (m_Name.symbol == NoSymbol || m_TemplateName.symbol == NoSymbol ||
+	    m_TemplateType.symbol == NoSymbol)
+	{
+		return;
+	}
+
+	// Take the candidates from the smallest list known to contain all matches: the entities of
+	// one template or type if given without wildcards, otherwise all entities
+	if (!m_TemplateName.wildcard && m_TemplateName.symbol != NullSymbol)
+	{
+		const CEntityManager::TEntityList& entities =
+			m_Manager->GetEntitiesOfTemplate( m_TemplateName.symbol );
+		m_Candidates.reserve( entities.size() );
+		for (TUInt32 entity = 0; entity < entities.size(); ++entity)
+		{
+			m_Candidates.push_back( entities[entity]->GetUID() );
+		}
+	}
+	else if (!m_TemplateType.wildcard && m_TemplateType.symbol != NullSymbol)
+	{
+		const CEntityManager::TEntityList& entities =
+			m_Manager->GetEntitiesOfType( m_TemplateType.symbol );
+		m_Candidates.reserve( entities.size() );
+		for (TUInt32 entity = 0; entity < entities.size(); ++entity)
+		{
+			m_Candidates.push_back( entities[entity]->GetUID() );
+		}
+	}
+	else
+	{
+		m_Candidates.reserve( m_Manager->NumEntities() );
+		for (TUInt32 entity = 0; entity < m_Manager->NumEntities(); ++entity)
+		{
+			m_Candidates.push_back( m_Manager->GetEntityAtIndex( entity )->GetUID() );
+		}
+	}
+}
+
+
+// Return the next entity matching the query, or 0 if there are no more
+CEntity* CEntityCursor::Next()
+{
+	while (m_Position < m_Candidates.size())
+	{
+		// Skip entities that have been destroyed since the snapshot was taken
+		CEntity* entity = m_Manager->GetEntity( m_Candidates[m_Position] );
+		++m_Position;
+		if (entity &&
+		    MatchField( m_Name, entity->GetNameSymbol() ) &&
+		    MatchField( m_TemplateName, entity->Template()->GetNameSymbol() ) &&
+		    MatchField( m_TemplateType, entity->Template()->GetTypeSymbol() ) &&
+		    (!m_Predicate || m_Predicate( entity, m_UserData )))
+		{
+			return entity;
+		}
+	}
+	return 0;
+}
+
+
+/////////////////////////////////////
+// Private interface
+
+// Set up a query field from the given pattern
+void CEntityCursor::SetField( SQueryField& field, const string& pattern )
+{
+	field.pattern = pattern;
+	field.wildcard = HasWildcards( pattern );
+	field.symbol = field.wildcard ? NullSymbol : FindName( pattern );
+}
+
+// Return true if the given name symbol matches a query field
+bool CEntityCursor::MatchField( const SQueryField& field, TSymbol name )
+{
+	if (field.wildcard)
+	{
+		return MatchWildcard( field.pattern, NameString( name ) );
+	}
+	return field.symbol == NullSymbol || field.symbol == name;
+}
+
+
+} // namespace gen
@@ -0,0 +1,131 @@
+/*******************************************
+	EntityCursor.h
+
+	Entity queries - cursors stepping through
+	the entities matching a query
+********************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "StringTable.h"
+#include "EntityHandle.h"
+
+namespace gen
+{
+
+class CEntity;
+class CEntityManager;
+
+// Predicate function type for entity queries - return true if the entity should be included.
+// The user data pointer passed to the query is passed on to the predicate
+typedef bool (*TEntityPredicate)( CEntity* entity, void* userData );
+
+
+// An entity cursor steps through the entities matching a query. The query may give an entity
+// name, template name and template type - each may contain wildcards ('*' and '?', e.g. "Tank*")
+// or be empty to match anything. A predicate function can be given for any other test
+//
+// When a query begins, the cursor takes a snapshot of the UIDs of the candidate entities, so any
+// number of cursors can be used at once (e.g. nested queries) and entities can be created and
+// destroyed while stepping through. Entities destroyed after the query began are skipped,
+// entities created after it began are not included. Candidates are taken from the manager's
+// entity registries when the template name or type has no wildcards, so such queries don't
+// visit unrelated entities
+class CEntityCursor
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Default constructor creates a cursor with no query, Next will return 0
+	CEntityCursor();
+
+	// Constructor begins a query on the given entity manager, see Begin
+	CEntityCursor
+	(
+		CEntityManager*  manager,
+		const string&    name = "",
+		const string&    templateName = "",
+		const string&    templateType = "",
+		TEntityPredicate predicate = 0,
+		void*            userData = 0
+	);
+
+	// No destructor needed. Cursors can be copied, the copy continues from the same point
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Begin a new query on the given entity manager, replacing any previous query. Empty strings
+	// match anything, the predicate is optional
+	void Begin
+	(
+		CEntityManager*  manager,
+		const string&    name = "",
+		const string&    templateName = "",
+		const string&    templateType = "",
+		TEntityPredicate predicate = 0,
+		void*            userData = 0
+	);
+
+	// Return the next entity matching the query, or 0 if there are no more
+	CEntity* Next();
+
+	// Go back to the start of the query. The snapshot is not retaken
+	void Reset()
+	{
+		m_Position = 0;
+	}
+
+	// End the query, Next will return 0 until a new query is begun
+	void End()
+	{
+		m_Candidates.clear();
+		m_Position = 0;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// A field of the query (entity name, template name or type). Fields without wildcards are
+	// compared as name table symbols
+	struct SQueryField
+	{
+		string  pattern;  // Pattern as given
+		TSymbol symbol;   // Symbol for the pattern if it has no wildcards, NullSymbol if empty
+		bool    wildcard; // Whether the pattern contains wildcards
+	};
+
+	// Set up a query field from the given pattern
+	static void SetField( SQueryField& field, const string& pattern );
+
+	// Return true if the given name symbol matches a query field
+	static bool MatchField( const SQueryField& field, TSymbol name );
+
+
+	// Entity manager being queried
+	CEntityManager* m_Manager;
+
+	// Query
+	SQueryField      m_Name;
+	SQueryField      m_TemplateName;
+	SQueryField      m_TemplateType;
+	TEntityPredicate m_Predicate;
+	void*            m_UserData;
+
+	// Snapshot of the UIDs of candidate entities, and the position of the next one to check
+	vector<TEntityUID> m_Candidates;
+	TUInt32            m_Position;
+};
+
+
+} // namespace gen
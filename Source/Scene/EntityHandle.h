@@ -0,0 +1,86 @@
+/*******************************************
+	EntityHandle.h
+
+	Entity UIDs and generational entity
+	handles
+********************************************/
+
+#pragma once
+
+#include "Defines.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+//	Public types
+
+// Entities are identified by a handle into the entity manager's slot map. The handle contains
+// the index of the slot that refers to the entity and the generation of the slot when the
+// entity was created. A slot's generation is increased each time its entity is destroyed, so a
+// handle to a destroyed entity can be detected even if the slot has been reused. Generations
+// never wrap around - a slot is retired once its generation reaches EntityGenerationMask
+struct SEntityHandle
+{
+	TUInt32 index;      // Index of the slot in the entity manager's slot map
+	TUInt32 generation; // Generation of the slot when the entity was created
+};
+
+
+// An entity UID is just a 32 bit value - a packed entity handle. The low bits are the slot
+// index and the high bits are the generation
+typedef TUInt32 TEntityUID;
+
+// Number of bits used for the slot index and generation in an entity UID
+const TUInt32 EntityIndexBits = 20;
+const TUInt32 EntityGenerationBits = 32 - EntityIndexBits;
+const TUInt32 EntityIndexMask = (1 << EntityIndexBits) - 1;
+const TUInt32 EntityGenerationMask = (1 << EntityGenerationBits) - 1;
+
+// Maximum number of entities. The last slot index is never used so the special UIDs below can
+// never refer to an entity
+const TUInt32 MaxEntities = EntityIndexMask;
+
+// UID used as the sender of messages that don't come from an entity
+const TEntityUID SystemUID = 0xffffffff;
+
+// UID that never refers to an entity (slot generations start at 1), use to indicate no entity
+const TEntityUID NullUID = 0;
+
+
+/////////////////////////////////////
+//	Handle / UID conversion
+
+// Pack an entity handle into a UID
+inline TEntityUID MakeEntityUID( const SEntityHandle& handle )
+{
+	return (handle.generation << EntityIndexBits) | (handle.index & EntityIndexMask);
+}
+
+// Pack a slot index and generation into a UID
+inline TEntityUID MakeEntityUID( TUInt32 index, TUInt32 generation )
+{
+	return (generation << EntityIndexBits) | (index & EntityIndexMask);
+}
+
+// Unpack an entity UID into a handle
+inline SEntityHandle EntityHandle( TEntityUID UID )
+{
+	SEntityHandle handle;
+	handle.index = UID & EntityIndexMask;
+	handle.generation = UID >> EntityIndexBits;
+	return handle;
+}
+
+// Get the slot index / generation from a UID
+inline TUInt32 EntityUIDIndex( TEntityUID UID )
+{
+	return UID & EntityIndexMask;
+}
+inline TUInt32 EntityUIDGeneration( TEntityUID UID )
+{
+	return UID >> EntityIndexBits;
+}
+
+
+} // namespace gen
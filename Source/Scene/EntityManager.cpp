@@ -6,31 +6,48 @@
 ********************************************/
 
 #include "EntityManager.h"
+#include "Messenger.h"
+#include "Intersection.h"
+#include "Error.h"
 
 namespace gen
 {
 
+// Messenger class for sending messages to and between entities, each new entity's mailbox is
+// opened with its team and template so it receives the right group messages
+extern CMessenger Messenger;
+
 /////////////////////////////////////
 // Constructors/Destructors
 
-// Constructor reserves space for entities and UID hash map, also sets first UID
-CEntityManager::CEntityManager()
+// Constructor reserves space for entities and the UID slot map. The tank grid cells are a few
+// times the size of a tank, larger than the distances usually searched
+CEntityManager::CEntityManager() : m_TankGrid( 10.0f )
 {
-	// Initialise list of entities and UID hash map
+	// Initialise list of entities and UID slot map
 	m_Entities.reserve( 1024 );
-	m_EntityUIDMap = new CHashTable<TEntityUID, TUInt32>( 2048, JOneAtATimeHash ); 
+	m_Slots.reserve( 2048 );
+
+	// No free slots yet
+	m_FreeSlotHead = NoSlot;
+	m_FreeSlotTail = NoSlot;
 
-	// Set first entity UID that will be used
-	m_NextUID = 0;
+	m_IsUpdating = false;
 
 	m_IsEnumerating = false;
 }
 
-// Destructor removes all entities
+// Destructor removes all entities and shell pools
 CEntityManager::~CEntityManager()
 {
 	DestroyAllEntities();
-	delete m_EntityUIDMap;
+
+	TShellPoolIter shellPool = m_ShellPools.begin();
+	while (shellPool != m_ShellPools.end())
+	{
+		delete shellPool->second;
+		++shellPool;
+	}
 }
 
 
@@ -44,8 +61,8 @@ CEntityTemplate* CEntityManager::CreateTemplate( const string& type, const strin
 	// Create new entity template
 	CEntityTemplate* newTemplate = new CEntityTemplate( type, name, mesh );
 
-	// Add the template name / template pointer pair to the map
-    m_Templates[name] = newTemplate;
+	// Store the template in the template array at the index of its name symbol
+	AddTemplate( newTemplate );
 
 	return newTemplate;
 }
@@ -61,8 +78,8 @@ CTankTemplate* CEntityManager::CreateTankTemplate(const string& type, const stri
 	CTankTemplate* newTemplate = new CTankTemplate(type, name, mesh, maxSpeed, acceleration,
 		turnSpeed, turretTurnSpeed, maxHP, shellDamage);
 
-	// Add the template name / template pointer pair to the map
-	m_Templates[name] = newTemplate;
+	// Store the template in the template array at the index of its name symbol
+	AddTemplate( newTemplate );
 
 	return newTemplate;
 }
@@ -70,32 +87,106 @@ CTankTemplate* CEntityManager::CreateTankTemplate(const string& type, const stri
 // Destroy the given template (name) - returns true if the template existed and was destroyed
 bool CEntityManager::DestroyTemplate( const string& name )
 {
-	// Find the template name in the template map
-	TTemplateIter entityTemplate = m_Templates.find( name );
-	if (entityTemplate == m_Templates.end())
+	// Find the template from its name
+	CEntityTemplate* entityTemplate = GetTemplate( name );
+	if (!entityTemplate)
 	{
 		// Not found
 		return false;
 	}
 
-	// Delete the template and remove the map entry
-	delete entityTemplate->second;
-	m_Templates.erase( entityTemplate );
+	// Destroy the template's entities, they refer to the template and pooled shells live in the
+	// template's shell pool. Flush them now so none are left when the pool is deleted
+	GEN_ASSERT( !m_IsUpdating, "Can't destroy a template during an entity update" );
+	TEntityList entities = GetEntitiesOfTemplate( entityTemplate->GetNameSymbol() );
+	for (TUInt32 entity = 0; entity < entities.size(); ++entity)
+	{
+		DestroyEntity( entities[entity]->GetUID() );
+	}
+	FlushDestroyedEntities();
+
+	// Delete the template's shell pool if it has one, then delete the template and clear its
+	// entry in the template array
+	m_Templates[entityTemplate->GetNameSymbol()] = 0;
+	DestroyShellPool( entityTemplate );
+	delete entityTemplate;
 	return true;
 }
 
 // Destroy all templates held by the manager
 void CEntityManager::DestroyAllTemplates()
 {
-	while (m_Templates.size())
+	// Every entity refers to a template, and pooled shells live in their template's shell pool,
+	// so destroy all entities before any template or pool is deleted
+	DestroyAllEntities();
+
+	for (TUInt32 entityTemplate = 0; entityTemplate < m_Templates.size(); ++entityTemplate)
 	{
-		TTemplateIter entityTemplate = m_Templates.begin();
-		while (entityTemplate != m_Templates.end())
+		if (m_Templates[entityTemplate])
 		{
-			delete entityTemplate->second;
-			++entityTemplate;
-		};
-		m_Templates.clear();
+			DestroyShellPool( m_Templates[entityTemplate] );
+			delete m_Templates[entityTemplate];
+		}
+	}
+	m_Templates.clear();
+}
+
+// Store a new template in the template array at the index of its name symbol
+void CEntityManager::AddTemplate( CEntityTemplate* newTemplate )
+{
+	TSymbol name = newTemplate->GetNameSymbol();
+	if (name >= m_Templates.size())
+	{
+		m_Templates.resize( name + 1, 0 );
+	}
+	m_Templates[name] = newTemplate;
+}
+
+
+/////////////////////////////////////
+// Shell pools
+
+// Create a pool for shells of the given template, holding up to the given number of shells.
+// Returns the new pool, or 0 if the template does not exist or already has a pool
+CShellPool* CEntityManager::CreateShellPool( const string& templateName, TUInt32 capacity )
+{
+	CEntityTemplate* entityTemplate = GetTemplate( templateName );
+	if (!entityTemplate)
+	{
+		return 0;
+	}
+
+	// Refuse to replace an existing pool - shells already created in it would no longer be
+	// recognised as pooled and would be deleted rather than returned to the pool
+	if (m_ShellPools.find( entityTemplate ) != m_ShellPools.end())
+	{
+		return 0;
+	}
+	CShellPool* newPool = new CShellPool( &m_Storage, entityTemplate, capacity );
+	m_ShellPools[entityTemplate] = newPool;
+
+	return newPool;
+}
+
+// Return the shell pool for the given template name, or 0 if the template has no pool
+CShellPool* CEntityManager::GetShellPool( const string& templateName )
+{
+	TShellPoolIter shellPool = m_ShellPools.find( GetTemplate( templateName ) );
+	if (shellPool == m_ShellPools.end())
+	{
+		return 0;
+	}
+	return shellPool->second;
+}
+
+// Delete the shell pool for the given template if there is one
+void CEntityManager::DestroyShellPool( CEntityTemplate* entityTemplate )
+{
+	TShellPoolIter shellPool = m_ShellPools.find( entityTemplate );
+	if (shellPool != m_ShellPools.end())
+	{
+		delete shellPool->second;
+		m_ShellPools.erase( shellPool );
 	}
 }
 
@@ -117,20 +208,17 @@ TEntityUID CEntityManager::CreateEntity
 	// Get template associated with the template name
 	CEntityTemplate* entityTemplate = GetTemplate( templateName );
 
-	// Create new entity with next UID
-	CEntity* newEntity = new CEntity( entityTemplate, m_NextUID, name, position, rotation, scale );
+	// Get a UID for the new entity, its slot refers to the end of the entity vector
+	TEntityUID newUID = AllocateSlot();
 
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<TUInt32>(m_Entities.size());
+	// Create new entity with this UID and add it to vector
+	CEntity* newEntity = new CEntity( &m_Storage, entityTemplate, newUID, InternName( name ),
+	                                  position, rotation, scale );
 	m_Entities.push_back( newEntity );
+	RegisterEntity( newEntity, NoTeam );
 
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue( m_NextUID, entityIndex );
-	
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
-
-	// Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Return UID of new entity
+	return newUID;
 }
 
 
@@ -150,20 +238,17 @@ TEntityUID CEntityManager::CreateTank
 	// This will cause an error if the template is not a tank type
 	CTankTemplate* tankTemplate = static_cast<CTankTemplate*>(GetTemplate(templateName));
 
-	// Create new tank entity with next UID
-	CEntity* newEntity = new CTankEntity(tankTemplate, m_NextUID, team, name, position, rotation, scale);
+	// Get a UID for the new entity, its slot refers to the end of the entity vector
+	TEntityUID newUID = AllocateSlot();
 
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<int>(m_Entities.size());
+	// Create new tank entity with this UID and add it to vector
+	CEntity* newEntity = new CTankEntity(&m_Storage, tankTemplate, newUID, team, InternName(name),
+		position, rotation, scale);
 	m_Entities.push_back(newEntity);
+	RegisterEntity(newEntity, team);
 
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue(m_NextUID, entityIndex);
-
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
-
-							 // Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Return UID of new entity
+	return newUID;
 }
 
 
@@ -179,53 +264,73 @@ TEntityUID CEntityManager::CreateShell
 	const CVector3& rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
 	const CVector3& scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
 	)
+{
+	return CreateShell(FindName(templateName), InternName(name), parent, damage, position, rotation, scale);
+}
+
+
+// Create a shell, as above but the template name and entity name are given as name table
+// symbols. Returns the UID of the new entity
+TEntityUID CEntityManager::CreateShell
+(
+	TSymbol          templateName,
+	TSymbol          name,
+	const TEntityUID parent,
+	const TInt32	 damage,
+	const CVector3&  position /*= CVector3::kOrigin*/,
+	const CVector3&  rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
+	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
+	)
 {
 	// Get template associated with the template name
 	CEntityTemplate* entityTemplate = GetTemplate(templateName);
 
-	// Create new tank entity with next UID
-	CEntity* newEntity = new CShellEntity(entityTemplate, m_NextUID,
-		name, parent, damage, position, rotation, scale);
-
-	// Get vector index for new entity and add it to vector
-	TUInt32 entityIndex = static_cast<int>(m_Entities.size());
-	m_Entities.push_back(newEntity);
+	// Get a UID for the new entity, its slot refers to the end of the entity vector
+	TEntityUID newUID = AllocateSlot();
 
-	// Add mapping from UID to entity index into hash map
-	m_EntityUIDMap->SetKeyValue(m_NextUID, entityIndex);
+	// Create new shell entity with this UID in the template's shell pool if it has one, use new
+	// if there is no pool or the pool is full
+	CEntity* newEntity = 0;
+	TShellPoolIter shellPool = m_ShellPools.find(entityTemplate);
+	if (shellPool != m_ShellPools.end())
+	{
+		newEntity = shellPool->second->Create(newUID, name, parent, damage, position, rotation, scale);
+	}
+	if (!newEntity)
+	{
+		newEntity = new CShellEntity(&m_Storage, entityTemplate, newUID,
+			name, parent, damage, position, rotation, scale);
+	}
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+	// Add new entity to vector
+	m_Entities.push_back(newEntity);
+	RegisterEntity(newEntity, NoTeam);
 
-							 // Return UID of new entity then increase it ready for next entity
-	return m_NextUID++;
+	// Return UID of new entity
+	return newUID;
 }
 
 
-// Destroy the given entity - returns true if the entity existed and was destroyed
+// Destroy the given entity - returns true if the entity existed and was destroyed. The entity
+// is deleted when the destroy queue is flushed at the end of the next update
 bool CEntityManager::DestroyEntity( TEntityUID UID )
 {
-	// Find the vector index of the given UID
-	TUInt32 entityIndex;
-	if (!m_EntityUIDMap->LookUpKey( UID, &entityIndex ))
+	// Quit if the UID does not refer to an existing entity
+	if (!GetEntity( UID ))
 	{
-		// Quit if not found
 		return false;
 	}
 
-	// Delete the given entity and remove from UID map
-	delete m_Entities[entityIndex];
-	m_EntityUIDMap->RemoveKey( UID );
+	// Remove the entity from the registries straight away so queries don't return it
+	TUInt32 entityIndex = m_Slots[EntityUIDIndex( UID )].entityIndex;
+	UnregisterEntity( m_Entities[entityIndex] );
 
-	// If not removing last entity...
-	if (entityIndex != m_Entities.size() - 1)
-	{
-		// ...put the last entity into the empty entity slot and update UID map
-		m_Entities[entityIndex] = m_Entities.back();
-		m_EntityUIDMap->SetKeyValue( m_Entities.back()->GetUID(), entityIndex );
-	}
-	m_Entities.pop_back(); // Remove last entity
+	// Queue the entity's index in the entity vector for destruction. Indexes don't change until
+	// the queue is flushed
+	m_DestroyQueue.push_back( entityIndex );
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+	// Free its slot now, so any copies of the UID become stale immediately
+	FreeSlot( UID );
 	return true;
 }
 
@@ -233,45 +338,464 @@ bool CEntityManager::DestroyEntity( TEntityUID UID )
 // Destroy all entities held by the manager
 void CEntityManager::DestroyAllEntities()
 {
-	m_EntityUIDMap->RemoveAllKeys();
+	// Finish any queued destruction first so each entity is only deleted once
+	FlushDestroyedEntities();
+
 	while (m_Entities.size())
 	{
-		delete m_Entities.back();
+		FreeSlot( m_Entities.back()->GetUID() );
+		DeleteEntity( m_Entities.back() );
 		m_Entities.pop_back();
 	}
+	m_Storage.Compact();
+
+	m_TemplateRegistry.clear();
+	m_TypeRegistry.clear();
+	m_TeamRegistry.clear();
+	m_TankGrid.Clear();
+	m_CollisionWorld.Clear();
+}
+
+
+// Delete all entities queued for destruction, in the order they were destroyed, then remove
+// them from the entity vector in a single pass. The entity vector keeps its order
+void CEntityManager::FlushDestroyedEntities()
+{
+	if (m_DestroyQueue.empty())
+	{
+		return;
+	}
+
+	// Delete queued entities, leaving gaps in the entity vector
+	for (TUInt32 queued = 0; queued < m_DestroyQueue.size(); ++queued)
+	{
+		TUInt32 entityIndex = m_DestroyQueue[queued];
+		DeleteEntity( m_Entities[entityIndex] );
+		m_Entities[entityIndex] = 0;
+	}
+	m_DestroyQueue.clear();
+
+	// Close the gaps by moving each remaining entity down, updating the slot map for each one
+	// that moves
+	TUInt32 newIndex = 0;
+	for (TUInt32 entityIndex = 0; entityIndex < m_Entities.size(); ++entityIndex)
+	{
+		CEntity* entity = m_Entities[entityIndex];
+		if (entity)
+		{
+			if (newIndex != entityIndex)
+			{
+				m_Entities[newIndex] = entity;
+				m_Slots[EntityUIDIndex( entity->GetUID() )].entityIndex = newIndex;
+			}
+			++newIndex;
+		}
+	}
+	m_Entities.resize( newIndex );
+
+	// Close the gaps left in the entity storage in the same way
+	m_Storage.Compact();
+}
+
 
-	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
+// Delete an entity, returning it to its shell pool if it was created in one
+void CEntityManager::DeleteEntity( CEntity* entity )
+{
+	TShellPoolIter shellPool = m_ShellPools.find( entity->Template() );
+	if (shellPool != m_ShellPools.end() && shellPool->second->Owns( entity ))
+	{
+		shellPool->second->Destroy( entity );
+	}
+	else
+	{
+		delete entity;
+	}
+}
+
+
+/////////////////////////////////////
+// UID slot map
+
+// Get a free slot for a new entity that will be added at the end of the entity list. Returns
+// the UID for the new entity
+TEntityUID CEntityManager::AllocateSlot()
+{
+	TUInt32 slotIndex;
+	if (m_FreeSlotHead != NoSlot)
+	{
+		// Take the oldest free slot from the front of the free list
+		slotIndex = m_FreeSlotHead;
+		m_FreeSlotHead = m_Slots[slotIndex].entityIndex;
+		if (m_FreeSlotHead == NoSlot)
+		{
+			m_FreeSlotTail = NoSlot;
+		}
+	}
+	else
+	{
+		// No free slots, add a new one. Slot generations start at 1 so NullUID is never valid
+		GEN_ASSERT( m_Slots.size() < MaxEntities, "Too many entities" );
+		slotIndex = static_cast<TUInt32>(m_Slots.size());
+		SEntitySlot newSlot;
+		newSlot.generation = 1;
+		m_Slots.push_back( newSlot );
+	}
+
+	// Slot refers to the end of the entity list
+	SEntitySlot& slot = m_Slots[slotIndex];
+	slot.entityIndex = static_cast<TUInt32>(m_Entities.size());
+	slot.inUse = true;
+
+	return MakeEntityUID( slotIndex, slot.generation );
+}
+
+// Free the slot used by the given UID, the UID and any copies of it become stale
+void CEntityManager::FreeSlot( TEntityUID UID )
+{
+	TUInt32 slotIndex = EntityUIDIndex( UID );
+	SEntitySlot& slot = m_Slots[slotIndex];
+
+	slot.inUse = false;
+
+	// Retire the slot once its generation has reached the largest value a UID can hold. If the
+	// generation wrapped around instead, a stale UID would come to match a new entity again. A
+	// retired slot is never put on the free list so it can't be reused
+	if (slot.generation == EntityGenerationMask)
+	{
+		slot.entityIndex = NoSlot;
+		return;
+	}
+
+	// Increase the generation so existing UIDs for this slot no longer match
+	++slot.generation;
+
+	// Add slot to the back of the free list
+	slot.entityIndex = NoSlot;
+	if (m_FreeSlotTail != NoSlot)
+	{
+		m_Slots[m_FreeSlotTail].entityIndex = slotIndex;
+	}
+	else
+	{
+		m_FreeSlotHead = slotIndex;
+	}
+	m_FreeSlotTail = slotIndex;
+}
+
+
+/////////////////////////////////////
+// Entity registries
+
+// Return the entities created from the template with the given name symbol
+const CEntityManager::TEntityList& CEntityManager::GetEntitiesOfTemplate( TSymbol templateName )
+{
+	TTemplateRegistryIter entities = m_TemplateRegistry.find( GetTemplate( templateName ) );
+	if (entities == m_TemplateRegistry.end())
+	{
+		return m_NoEntities;
+	}
+	return entities->second;
+}
+
+// Return the entities whose template has the given type symbol
+const CEntityManager::TEntityList& CEntityManager::GetEntitiesOfType( TSymbol templateType )
+{
+	TTypeRegistryIter entities = m_TypeRegistry.find( templateType );
+	if (entities == m_TypeRegistry.end())
+	{
+		return m_NoEntities;
+	}
+	return entities->second;
+}
+
+// Return the tanks on the given team
+const CEntityManager::TEntityList& CEntityManager::GetTanksOnTeam( TUInt32 team )
+{
+	TTeamRegistryIter entities = m_TeamRegistry.find( team );
+	if (entities == m_TeamRegistry.end())
+	{
+		return m_NoEntities;
+	}
+	return entities->second;
+}
+
+
+// Add a new entity to the entity registries - pass the team for tanks, NoTeam otherwise. Each
+// registry list position is stored in the entity's slot so it can be removed without a search.
+// The entity's mailbox is also opened with its team and template
+void CEntityManager::RegisterEntity( CEntity* entity, TUInt32 team )
+{
+	SEntitySlot& slot = m_Slots[EntityUIDIndex( entity->GetUID() )];
+	Messenger.OpenMailbox( entity->GetUID(), team, entity->Template()->GetNameSymbol() );
+
+	TEntityList& templateEntities = m_TemplateRegistry[entity->Template()];
+	slot.templatePos = static_cast<TUInt32>(templateEntities.size());
+	templateEntities.push_back( entity );
+
+	TEntityList& typeEntities = m_TypeRegistry[entity->Template()->GetTypeSymbol()];
+	slot.typePos = static_cast<TUInt32>(typeEntities.size());
+	typeEntities.push_back( entity );
+
+	slot.team = team;
+	if (team != NoTeam)
+	{
+		TEntityList& teamEntities = m_TeamRegistry[team];
+		slot.teamPos = static_cast<TUInt32>(teamEntities.size());
+		teamEntities.push_back( entity );
+
+		slot.gridEntry = m_TankGrid.Insert( entity->GetUID(), entity->Position() );
+	}
+}
+
+// Remove an entity from the entity registries, updating the stored position of any entity that
+// moves in a registry list as a result
+void CEntityManager::UnregisterEntity( CEntity* entity )
+{
+	SEntitySlot& slot = m_Slots[EntityUIDIndex( entity->GetUID() )];
+
+	CEntity* moved = RemoveFromRegistry( m_TemplateRegistry[entity->Template()], slot.templatePos );
+	if (moved)
+	{
+		m_Slots[EntityUIDIndex( moved->GetUID() )].templatePos = slot.templatePos;
+	}
+
+	moved = RemoveFromRegistry( m_TypeRegistry[entity->Template()->GetTypeSymbol()], slot.typePos );
+	if (moved)
+	{
+		m_Slots[EntityUIDIndex( moved->GetUID() )].typePos = slot.typePos;
+	}
+
+	if (slot.team != NoTeam)
+	{
+		moved = RemoveFromRegistry( m_TeamRegistry[slot.team], slot.teamPos );
+		if (moved)
+		{
+			m_Slots[EntityUIDIndex( moved->GetUID() )].teamPos = slot.teamPos;
+		}
+
+		m_TankGrid.Remove( slot.gridEntry );
+	}
+}
+
+// Remove the entity at the given position in a registry list by moving the last entity in the
+// list into its place. Returns the entity that moved, or 0 if none did
+CEntity* CEntityManager::RemoveFromRegistry( TEntityList& entities, TUInt32 pos )
+{
+	CEntity* moved = 0;
+	if (pos != entities.size() - 1)
+	{
+		moved = entities.back();
+		entities[pos] = moved;
+	}
+	entities.pop_back();
+	return moved;
+}
+
+// Return the smallest entity list that holds all entities of the given template name and
+// type symbols, either of which may be NullSymbol
+const CEntityManager::TEntityList& CEntityManager::SelectEntityList( TSymbol templateName,
+                                                                     TSymbol templateType )
+{
+	if (templateName != NullSymbol)
+	{
+		return GetEntitiesOfTemplate( templateName );
+	}
+	if (templateType != NullSymbol)
+	{
+		return GetEntitiesOfType( templateType );
+	}
+	return m_Entities;
+}
+
+
+/////////////////////////////////////
+// Static collision
+
+// Add colliders for all the existing entities of the given template to the static collision world
+void CEntityManager::AddToCollisionWorld( const string& templateName )
+{
+	const TEntityList& entities = GetEntitiesOfTemplate( templateName );
+	for (TUInt32 entity = 0; entity < entities.size(); ++entity)
+	{
+		CMesh* mesh = entities[entity]->Template()->Mesh();
+		m_CollisionWorld.Add( entities[entity]->GetUID(), mesh->MinBounds(), mesh->MaxBounds(),
+		                      mesh->BoundingRadius(), entities[entity]->Matrix() );
+	}
 }
 
 
 /////////////////////////////////////
 // Update / Rendering
 
-// Call all entity update functions. Pass the time since last update
+// Call the update functions of all entities that have behaviour (tanks and shells). Pass the
+// time since last update
 void CEntityManager::UpdateAllEntities( float updateTime )
 {
-	TUInt32 entity = 0;
-	while (entity < m_Entities.size())
+	// Entities destroyed during the update are queued and deleted together at the end, so the
+	// entity vector and storage don't change order while entities are being updated. Entities
+	// destroyed since the last update are still queued, and are skipped below
+	m_IsUpdating = true;
+
+	// Step through the packed tank data in the entity storage rather than the list of all
+	// entities, static scenery is skipped and tank data is visited in memory order
+	for (TUInt32 tank = 0; tank < m_Storage.NumTanks(); ++tank)
 	{
-		// Update entity, if it returns false, then destroy it
-		if (!m_Entities[entity]->Update( updateTime ))
+		// Update tank (unless already destroyed this frame), if it returns false, then destroy it
+		CEntity* tankEntity = m_Storage.GetTankOwner( tank );
+		if (!IsDestroyed( tankEntity ) && !tankEntity->Update( updateTime ))
 		{
-			DestroyEntity(m_Entities[entity]->GetUID());
+			DestroyEntity( tankEntity->GetUID() );
 		}
-		else
+
+		// Keep the tank's position in the tank grid up to date, so shells find it where it is now
+		if (!IsDestroyed( tankEntity ))
 		{
-			++entity;
+			m_TankGrid.Move( m_Slots[EntityUIDIndex( tankEntity->GetUID() )].gridEntry,
+			                 tankEntity->Position() );
 		}
 	}
+
+	// Shells created by tanks this frame are added to the end of the shell data, so will be
+	// updated in the same frame they were fired
+	for (TUInt32 shell = 0; shell < m_Storage.NumShells(); ++shell)
+	{
+		CEntity* shellEntity = m_Storage.GetShellOwner( shell );
+		if (!IsDestroyed( shellEntity ) && !shellEntity->Update( updateTime ))
+		{
+			DestroyEntity( shellEntity->GetUID() );
+		}
+	}
+	CollideShells();
+
+	// Delete everything destroyed since the last flush, the only flush in the frame
+	m_IsUpdating = false;
+	FlushDestroyedEntities();
 }
 
-// Render all entities
+// Test the paths moved along this frame by all the shells against the scenery and the tanks.
+// Shells that hit something are destroyed, and the first tank hit by each shell is sent a hit
+// message. Collision with tanks is in the XZ plane, as with PointToSphere, so the paths are
+// flattened for those tests. The full paths are used for the scenery, so shells can pass over
+// low obstacles
+void CEntityManager::CollideShells()
+{
+	// Radius of a tank for shell hits, and the distance searched around each path for tanks - a
+	// little larger to allow for rounding in the tests
+	const TFloat32 TankHitRadius = 1.0f;
+	const TFloat32 TankSearchRadius = 1.5f;
+
+	m_ShellPaths.clear();
+	m_ShellPathFrom.clear();
+	m_ShellPathTo.clear();
+	m_ShellPathStarts.clear();
+	m_ShellPathEnds.clear();
+	m_ShellPathHits.clear();
+	m_ShellTestPaths.clear();
+	m_ShellTestCentres.clear();
+	m_ShellTestRadii.clear();
+	m_ShellTestTanks.clear();
+
+	// Gather the path of each shell still alive, and find the tanks near it from the tank grid.
+	// The shell's own tank is not tested
+	for (TUInt32 shell = 0; shell < m_Storage.NumShells(); ++shell)
+	{
+		CEntity* shellEntity = m_Storage.GetShellOwner( shell );
+		if (IsDestroyed( shellEntity ))
+		{
+			continue;
+		}
+
+		const CVector3& prevPosition = m_Storage.ShellPrevPosition( shell );
+		const CVector3& position = shellEntity->Position();
+		TUInt32 path = static_cast<TUInt32>(m_ShellPaths.size());
+		CVector3 pathStart( prevPosition.x, 0.0f, prevPosition.z );
+		CVector3 pathEnd( position.x, 0.0f, position.z );
+		m_ShellPaths.push_back( shell );
+		m_ShellPathFrom.push_back( prevPosition );
+		m_ShellPathTo.push_back( position );
+		m_ShellPathStarts.push_back( pathStart );
+		m_ShellPathEnds.push_back( pathEnd );
+		m_ShellPathHits.push_back( NullUID );
+
+		TEntityUID parentTank = m_Storage.ShellParent( shell );
+		m_TankGrid.QuerySegment( pathStart, pathEnd, TankSearchRadius, m_NearbyTanks );
+		for (TUInt32 i = 0; i < m_NearbyTanks.size(); ++i)
+		{
+			CEntity* tank = GetEntity( m_NearbyTanks[i] );
+			if (tank && m_NearbyTanks[i] != parentTank)
+			{
+				m_ShellTestPaths.push_back( path );
+				m_ShellTestCentres.push_back( CVector3( tank->Position().x, 0.0f,
+				                                        tank->Position().z ) );
+				m_ShellTestRadii.push_back( TankHitRadius );
+				m_ShellTestTanks.push_back( m_NearbyTanks[i] );
+			}
+		}
+	}
+	if (m_ShellPaths.empty())
+	{
+		return;
+	}
+
+	// Test all the paths against the scenery in one batch, then against their nearby tanks in
+	// another. The first tank hit along each path takes the damage, unless scenery was hit first
+	TUInt32 numPaths = static_cast<TUInt32>(m_ShellPaths.size());
+	m_ShellPathT.resize( numPaths );
+	m_CollisionWorld.SegmentQueryBatch( &m_ShellPathFrom[0], &m_ShellPathTo[0], numPaths,
+	                                    &m_ShellPathT[0] );
+
+	TUInt32 numTests = static_cast<TUInt32>(m_ShellTestPaths.size());
+	m_ShellTestT.resize( numTests );
+	if (numTests > 0)
+	{
+		SegmentSphereBatch( &m_ShellPathStarts[0], &m_ShellPathEnds[0], &m_ShellTestPaths[0],
+		                    &m_ShellTestCentres[0], &m_ShellTestRadii[0], numTests,
+		                    &m_ShellTestT[0] );
+	}
+	for (TUInt32 test = 0; test < numTests; ++test)
+	{
+		TUInt32 path = m_ShellTestPaths[test];
+		if (m_ShellTestT[test] < m_ShellPathT[path])
+		{
+			m_ShellPathT[path] = m_ShellTestT[test];
+			m_ShellPathHits[path] = m_ShellTestTanks[test];
+		}
+	}
+
+	// Destroy the shells that hit something, sending hit messages to the tanks hit
+	for (TUInt32 path = 0; path < m_ShellPaths.size(); ++path)
+	{
+		if (m_ShellPathT[path] == kfNoIntersection)
+		{
+			continue;
+		}
+
+		TUInt32 shell = m_ShellPaths[path];
+		CEntity* shellEntity = m_Storage.GetShellOwner( shell );
+		if (m_ShellPathHits[path] != NullUID)
+		{
+			const CVector3& from = m_ShellPathFrom[path];
+			CVector3 hitPosition = from + m_ShellPathT[path] * (m_ShellPathTo[path] - from);
+			SMessage msg;
+			msg.type = Msg_Hit;
+			msg.from = shellEntity->GetUID();
+			msg.SetHit( m_Storage.ShellDamage( shell ), hitPosition );
+			Messenger.SendMessageA( m_ShellPathHits[path], msg );
+		}
+		DestroyEntity( shellEntity->GetUID() );
+	}
+}
+
+// Render all entities, skipping those destroyed but not yet deleted
 void CEntityManager::RenderAllEntities()
 {
 	TEntityIter entity = m_Entities.begin();
 	while (entity != m_Entities.end())
 	{
-		(*entity)->Render();
+		if (!IsDestroyed( *entity ))
+		{
+			(*entity)->Render();
+		}
 		++entity;
 	}
 }
@@ -11,17 +11,24 @@
 using namespace std;
 
 #include "Defines.h"
-#include "CHashTable.h"
+#include "StringTable.h"
+#include "EntityHandle.h"
+#include "EntityStorage.h"
+#include "EntityCursor.h"
 #include "Entity.h"
 #include "TankEntity.h"
 #include "ShellEntity.h"
+#include "ShellPool.h"
+#include "SpatialGrid.h"
+#include "CollisionWorld.h"
 #include "Camera.h"
 
 namespace gen
 {
 
 // The entity manager is responsible for creation, update, rendering and deletion of
-// entities. It also manages UIDs for entities using a hash table
+// entities. It also manages UIDs for entities using a slot map (see EntityHandle.h), and owns
+// the entity storage that holds the entities' transform, tank and shell data in contiguous arrays
 class CEntityManager
 {
 /////////////////////////////////////
@@ -44,6 +51,16 @@ private:
 //	Public interface
 public:
 
+	/////////////////////////////////////
+	// Public types
+
+	// Lists of entities returned by the registry queries below
+	typedef vector<CEntity*> TEntityList;
+
+	// Team value for entities that are not tanks
+	static const TUInt32 NoTeam = 0xffffffff;
+
+
 	/////////////////////////////////////
 	// Template creation / destruction
 
@@ -59,13 +76,28 @@ public:
 	                                                   float turretTurnSpeed, int maxHP, int shellDamage );
 
 
-	// Destroy the given template (name) - returns true if the template existed and was destroyed
+	// Destroy the given template (name) - returns true if the template existed and was destroyed.
+	// All entities of the template are destroyed first. Don't call during UpdateAllEntities
 	bool DestroyTemplate( const string& name );
 
-	// Destroy all templates held by the manager
+	// Destroy all templates held by the manager, all entities are destroyed first
 	void DestroyAllTemplates();
 
 
+	/////////////////////////////////////
+	// Shell pools
+
+	// Create a pool for shells of the given template, holding up to the given number of shells.
+	// Shells of this template are then created in the pool rather than with new, shells beyond
+	// the capacity still use new. Returns the new pool, or 0 if the template does not exist or
+	// already has a pool (a pool can't be replaced while shells may be using it)
+	CShellPool* CreateShellPool( const string& templateName, TUInt32 capacity );
+
+	// Return the shell pool for the given template name, or 0 if the template has no pool. Use to
+	// read the pool statistics, e.g. the high-water mark
+	CShellPool* GetShellPool( const string& templateName );
+
+
 	/////////////////////////////////////
 	// Entity creation / destruction
 
@@ -105,8 +137,24 @@ public:
 		const CVector3& scale = CVector3(1.0f, 1.0f, 1.0f)
 	);
 
+	// Create a shell, as above but the template name and entity name are given as name table
+	// symbols (see StringTable.h). Use when firing often - no strings are looked up or copied
+	TEntityUID CreateShell
+	(
+		TSymbol          templateName,
+		TSymbol          name,
+		const TEntityUID parent,
+		const TInt32	 damage,
+		const CVector3&  position = CVector3::kOrigin,
+		const CVector3&  rotation = CVector3(0.0f, 0.0f, 0.0f),
+		const CVector3&  scale = CVector3(1.0f, 1.0f, 1.0f)
+	);
+
 
-	// Destroy the given entity - returns true if the entity existed and was destroyed
+	// Destroy the given entity - returns true if the entity existed and was destroyed. The UID
+	// becomes stale immediately, but the entity is not deleted until the end of the next
+	// UpdateAllEntities (so other entities' pointers to it remain safe for this frame). Destroyed
+	// entities are not updated or rendered
 	bool DestroyEntity( TEntityUID UID );
 
 	// Destroy all entities held by the manager
@@ -119,14 +167,19 @@ public:
 	// Return the template with the given name
 	CEntityTemplate* GetTemplate( const string& name )
 	{
-		// Find the template name in the template map
-		TTemplateIter entityTemplate = m_Templates.find( name );
-		if (entityTemplate == m_Templates.end())
+		return GetTemplate( FindName( name ) );
+	}
+
+	// Return the template with the given name symbol. Templates are held in an array indexed by
+	// name symbol, so this is a direct look-up
+	CEntityTemplate* GetTemplate( TSymbol name )
+	{
+		if (name >= m_Templates.size())
 		{
-			// Template name not found
+			// Template name not found (includes NoSymbol)
 			return 0;
 		}
-		return (*entityTemplate).second;
+		return m_Templates[name];
 	}
 
 
@@ -142,54 +195,184 @@ public:
 		return m_Entities[index];
 	}
 
-	// Return the entity with the given UID
+	// Return the entity with the given UID, or 0 if the UID does not refer to an existing entity
+	// (e.g. the entity has been destroyed)
 	CEntity* GetEntity( TEntityUID UID )
 	{
-		// Find the entity UID in the entity hash map
-		TUInt32 entityIndex;
-		if (!m_EntityUIDMap->LookUpKey( UID, &entityIndex ))
+		// Find the slot for the UID in the slot map, the slot's generation will have changed if the
+		// entity it referred to has been destroyed
+		TUInt32 slotIndex = EntityUIDIndex( UID );
+		if (slotIndex >= m_Slots.size())
 		{
 			return 0;
 		}
-		return m_Entities[entityIndex];
+		const SEntitySlot& slot = m_Slots[slotIndex];
+		if (!slot.inUse || slot.generation != EntityUIDGeneration( UID ))
+		{
+			return 0;
+		}
+		return m_Entities[slot.entityIndex];
+	}
+
+	// Return the entity with the given handle, or 0 if the handle is stale
+	CEntity* GetEntity( const SEntityHandle& handle )
+	{
+		return GetEntity( MakeEntityUID( handle ) );
+	}
+
+	// Return true if the given UID refers to an existing entity
+	bool IsValidUID( TEntityUID UID )
+	{
+		return GetEntity( UID ) != 0;
+	}
+
+	// Return the team of the tank with the given UID, or NoTeam if the UID does not refer to an
+	// existing tank
+	TUInt32 GetTeam( TEntityUID UID )
+	{
+		if (!GetEntity( UID ))
+		{
+			return NoTeam;
+		}
+		return m_Slots[EntityUIDIndex( UID )].team;
 	}
 
-	// Return the entity with the given name & optionally the given template name & type
+	// Return the entity with the given name & optionally the given template name & type. If a
+	// template name or type is given only the entities of that template / type are searched
 	CEntity* GetEntity( const string& name, const string& templateName = "",
 	                    const string& templateType = "" )
 	{
-		TEntityIter entity = m_Entities.begin();
-		while (entity != m_Entities.end())
+		// Names are compared as symbols, a name that is not in the name table can't match
+		TSymbol nameSymbol = FindName( name );
+		TSymbol templateSymbol = FindName( templateName );
+		TSymbol typeSymbol = FindName( templateType );
+		if (nameSymbol == NoSymbol || templateSymbol == NoSymbol || typeSymbol == NoSymbol)
+		{
+			return 0;
+		}
+
+		const TEntityList& entities = SelectEntityList( templateSymbol, typeSymbol );
+		for (TUInt32 entity = 0; entity < entities.size(); ++entity)
 		{
-			if ((*entity)->GetName() == name && 
-				(templateName.length() == 0 || (*entity)->Template()->GetName() == templateName) &&
-				(templateType.length() == 0 || (*entity)->Template()->GetType() == templateType))
+			if (!IsDestroyed( entities[entity] ) && entities[entity]->GetNameSymbol() == nameSymbol && 
+				(templateSymbol == NullSymbol ||
+				 entities[entity]->Template()->GetNameSymbol() == templateSymbol) &&
+				(typeSymbol == NullSymbol ||
+				 entities[entity]->Template()->GetTypeSymbol() == typeSymbol))
 			{
-				return (*entity);
+				return entities[entity];
 			}
-			++entity;
 		}
 		return 0;
 	}
 
 
+	/////////////////////////////////////
+	// Entity registries
+
+	// The entity manager keeps a list of the entities of each template, of each template type and
+	// of the tanks on each team. Use these queries rather than searching all entities - they
+	// return the list directly, so the cost only depends on the number of entities returned.
+	// Entities are listed in no particular order. The lists change when entities are created or
+	// destroyed, so don't keep a reference to a list while doing either
+
+	// Return the entities created from the template with the given name (string or symbol)
+	const TEntityList& GetEntitiesOfTemplate( const string& templateName )
+	{
+		return GetEntitiesOfTemplate( FindName( templateName ) );
+	}
+	const TEntityList& GetEntitiesOfTemplate( TSymbol templateName );
+
+	// Return the entities whose template has the given type (string or symbol), e.g. "Tank" or
+	// "Projectile"
+	const TEntityList& GetEntitiesOfType( const string& templateType )
+	{
+		return GetEntitiesOfType( FindName( templateType ) );
+	}
+	const TEntityList& GetEntitiesOfType( TSymbol templateType );
+
+	// Return the tanks on the given team
+	const TEntityList& GetTanksOnTeam( TUInt32 team );
+
+
+	/////////////////////////////////////
+	// Spatial queries
+
+	// Find the tanks within the given distance of a point in the XZ plane. Tanks are kept in a
+	// grid (see SpatialGrid.h) so only the tanks near the point are tested. Up to maxTanks UIDs
+	// are written to the given array, returns the number of tanks found, which may be more than
+	// maxTanks. Tank positions in the grid are updated after each tank's update
+	TUInt32 GetTanksNear( const CVector3& point, TFloat32 radius, TEntityUID* tanks,
+	                      TUInt32 maxTanks )
+	{
+		return m_TankGrid.Query( point, radius, tanks, maxTanks );
+	}
+
+	// Find the tanks within the given distance of the line segment from start to end in the XZ
+	// plane, e.g. the path a shell moved along in a frame. Only the grid cells along the segment
+	// are visited. Returns a list of all the tanks found, which is only valid until the next call
+	const vector<TEntityUID>& GetTanksNearSegment( const CVector3& start, const CVector3& end,
+	                                               TFloat32 radius )
+	{
+		m_TankGrid.QuerySegment( start, end, radius, m_NearbyTanks );
+		return m_NearbyTanks;
+	}
+
+
+	/////////////////////////////////////
+	// Static collision
+
+	// Add colliders for all the existing entities of the given template to the static collision
+	// world, using the bounds of the template's mesh transformed by each entity's matrix. Call
+	// BuildCollisionWorld once all the colliders have been added
+	void AddToCollisionWorld( const string& templateName );
+
+	// Build the static collision world from the colliders added. Call once at scene setup, after
+	// the scenery has been created - the colliders don't follow any later changes to the scenery
+	void BuildCollisionWorld()
+	{
+		m_CollisionWorld.Build();
+	}
+
+	// Return the static collision world for point, segment and sphere queries against the
+	// scenery (see CollisionWorld.h)
+	CCollisionWorld& CollisionWorld()
+	{
+		return m_CollisionWorld;
+	}
+
+
+	/////////////////////////////////////
+	// Entity queries
+
+	// Begin a query for entities matching the given name, template name and type, and an
+	// optional predicate function (passed the user data pointer). An empty string matches
+	// anything in that field, wildcards are supported, e.g. "Tank*". Step through the results
+	// with the returned cursor's Next function. Any number of queries can be used at once and
+	// they remain valid when entities are created or destroyed, see EntityCursor.h
+	CEntityCursor Query( const string& name = "", const string& templateName = "",
+	                     const string& templateType = "", TEntityPredicate predicate = 0,
+	                     void* userData = 0 )
+	{
+		return CEntityCursor( this, name, templateName, templateType, predicate, userData );
+	}
+
+
 	// Begin an enumeration of entities matching given name, template name and type
-	// An empty string indicates to match anything in this field (would be nice to support
-	// wildcards, e.g. match name of "Ship*")
+	// An empty string indicates to match anything in this field, wildcards are supported
+	// (e.g. match name of "Ship*"). Only one enumeration at a time, use Query above for more
 	void BeginEnumEntities( const string& name, const string& templateName,
 	                        const string& templateType = "" )
 	{
 		m_IsEnumerating = true;
-		m_EnumEntity = m_Entities.begin();
-		m_EnumName = name;
-		m_EnumTemplateName = templateName;
-		m_EnumTemplateType = templateType;
+		m_EnumCursor.Begin( this, name, templateName, templateType );
 	}
 
 	// Finish enumerating entities (see above)
 	void EndEnumEntities()
 	{
 		m_IsEnumerating = false;
+		m_EnumCursor.End();
 	}
 
 	// Return next entity matching parameters passed to a previous call to BeginEnumEntities
@@ -201,30 +384,20 @@ public:
 			return 0;
 		}
 
-		while (m_EnumEntity != m_Entities.end())
+		CEntity* foundEntity = m_EnumCursor.Next();
+		if (!foundEntity)
 		{
-			if ((m_EnumName.length() == 0 || (*m_EnumEntity)->GetName() == m_EnumName) && 
-				(m_EnumTemplateName.length() == 0 ||
-				 (*m_EnumEntity)->Template()->GetName() == m_EnumTemplateName) &&
-				(m_EnumTemplateType.length() == 0 ||
-				 (*m_EnumEntity)->Template()->GetType() == m_EnumTemplateType))
-			{
-				CEntity* foundEntity = *m_EnumEntity;
-				++m_EnumEntity;
-				return foundEntity;
-			}
-			++m_EnumEntity;
+			EndEnumEntities();
 		}
-		
-		m_IsEnumerating = false;
-		return 0;
+		return foundEntity;
 	}
 
 
 	/////////////////////////////////////
 	// Update / Rendering
 
-	// Call all entity update functions - not the ideal method, OK for this example
+	// Call the update functions of all entities that have behaviour (tanks and shells). Base
+	// class entities are static scene elements and are not updated
 	// Pass the time since last update
 	void UpdateAllEntities( float updateTime );
 
@@ -239,45 +412,170 @@ private:
 	/////////////////////////////////////
 	// Types
 
-	// Entity templates are held in a map, define some types for convenience
-	typedef map<string, CEntityTemplate*> TTemplates;
-	typedef TTemplates::iterator TTemplateIter;
+	// Entity templates are held in a vector indexed by template name symbol, unused entries are 0
+	typedef vector<CEntityTemplate*> TTemplates;
 
 	// Entity instances are held in a vector, define some types for convenience
 	typedef vector<CEntity*> TEntities;
 	typedef TEntities::iterator TEntityIter;
 
+	// Entity registries are held in maps from template / type / team to entity list
+	typedef map<CEntityTemplate*, TEntityList> TTemplateRegistry;
+	typedef TTemplateRegistry::iterator        TTemplateRegistryIter;
+	typedef map<TSymbol, TEntityList>          TTypeRegistry;
+	typedef TTypeRegistry::iterator            TTypeRegistryIter;
+	typedef map<TUInt32, TEntityList>          TTeamRegistry;
+	typedef TTeamRegistry::iterator            TTeamRegistryIter;
+
+	// Shell pools are held in a map from template to pool
+	typedef map<CEntityTemplate*, CShellPool*> TShellPools;
+	typedef TShellPools::iterator TShellPoolIter;
+
+	// An entry in the slot map from UIDs to entities. Each UID refers to a slot, which holds the
+	// index of the entity in the entity list and its positions in the entity registries
+	struct SEntitySlot
+	{
+		TUInt32 generation;  // Current generation, increased each time the slot's entity is destroyed
+		TUInt32 entityIndex; // Index into the entity list, or the next free slot if not in use
+		bool    inUse;       // Whether the slot currently refers to an entity
+
+		TUInt32 templatePos; // Position of the entity in its template's registry list
+		TUInt32 typePos;     // Position of the entity in its template type's registry list
+		TUInt32 team;        // Team of a tank entity, NoTeam for other entities
+		TUInt32 teamPos;     // Position of a tank entity in its team's registry list
+		TUInt32 gridEntry;   // Entry of a tank entity in the tank grid
+	};
+	typedef vector<SEntitySlot> TSlots;
+
+	// Marks the end of the list of free slots
+	static const TUInt32 NoSlot = 0xffffffff;
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Get a free slot for a new entity that will be added at the end of the entity list. Returns
+	// the UID for the new entity
+	TEntityUID AllocateSlot();
+
+	// Free the slot used by the given UID, the UID and any copies of it become stale. A slot
+	// whose generation has run out is retired rather than freed
+	void FreeSlot( TEntityUID UID );
+
+	// Store a new template in the template array at the index of its name symbol
+	void AddTemplate( CEntityTemplate* newTemplate );
+
+	// Delete an entity, returning it to its shell pool if it was created in one
+	void DeleteEntity( CEntity* entity );
+
+	// Delete all entities queued for destruction and remove them from the entity list and storage
+	void FlushDestroyedEntities();
+
+	// Test the paths moved along this frame by all the shells against the scenery and the tanks,
+	// destroying shells that hit something and sending hit messages to the tanks hit
+	void CollideShells();
+
+	// Return true if the given entity has been destroyed but is still waiting to be deleted
+	bool IsDestroyed( CEntity* entity )
+	{
+		return GetEntity( entity->GetUID() ) != entity;
+	}
+
+	// Delete the shell pool for the given template if there is one
+	void DestroyShellPool( CEntityTemplate* entityTemplate );
+
+	// Add a new entity to the entity registries - pass the team for tanks, NoTeam otherwise
+	void RegisterEntity( CEntity* entity, TUInt32 team );
+
+	// Remove an entity from the entity registries
+	void UnregisterEntity( CEntity* entity );
+
+	// Remove the entity at the given position in a registry list by moving the last entity in
+	// the list into its place. Returns the entity that moved, or 0 if none did
+	CEntity* RemoveFromRegistry( TEntityList& entities, TUInt32 pos );
+
+	// Return the smallest entity list that holds all entities of the given template name and
+	// type symbols, either of which may be NullSymbol
+	const TEntityList& SelectEntityList( TSymbol templateName, TSymbol templateType );
+
 
 	/////////////////////////////////////
 	// Template Data
 
-	// The map of template names / templates
+	// The templates, indexed by name symbol
 	TTemplates m_Templates;
 
+	// Pools for shell templates
+	TShellPools m_ShellPools;
+
 
 	/////////////////////////////////////
 	// Entity Data
 
-	// The main list of entities. This vector is kept packed - i.e. with no gaps. If an
-	// entity is removed from the middle of the list, the last entity is moved down to
-	// fill its space
-	TEntities m_Entities;
+	// Storage for the entity data (transforms, tank and shell data). Entities refer into this
+	// storage so it must outlive them
+	CEntityStorage m_Storage;
 
-	// A mapping from UIDs to indexes into the above array
-	CHashTable<TEntityUID, TUInt32>* m_EntityUIDMap;
+	// The main list of entities. This vector is kept packed - i.e. with no gaps. Destroyed
+	// entities are removed in a batch and the remaining entities are moved down to fill the
+	// gaps, keeping their order
+	TEntities m_Entities;
 
-	// Entity IDs are provided using a single increasing integer
-	TEntityUID m_NextUID;
+	// The slot map - a mapping from UIDs to indexes into the above array. UIDs contain a slot
+	// index so the look-up is a simple array access
+	TSlots m_Slots;
+
+	// Free slots are held in a list through the slot map, oldest first, so each slot's
+	// generation advances as slowly as possible. Slots whose generation has run out are retired
+	// and never return to this list, so a stale UID can never match a new entity
+	TUInt32 m_FreeSlotHead;
+	TUInt32 m_FreeSlotTail;
+
+	// Entity registries - lists of the entities of each template, template type and team
+	TTemplateRegistry m_TemplateRegistry;
+	TTypeRegistry     m_TypeRegistry;
+	TTeamRegistry     m_TeamRegistry;
+
+	// Empty list returned by registry queries that match no entities
+	TEntityList m_NoEntities;
+
+	// Grid of tank positions for finding the tanks near a point, and the results of the last
+	// GetTanksNearSegment, kept to avoid allocation on each call
+	CSpatialGrid       m_TankGrid;
+	vector<TEntityUID> m_NearbyTanks;
+
+	// Working space for CollideShells, kept to avoid allocation each frame. The shell data index
+	// of each path tested, its full and flattened end points, and its nearest contact and the tank
+	// hit there (NullUID for none). Then the tests of paths against the tanks near them, all made
+	// in one batch
+	vector<TUInt32>    m_ShellPaths;
+	vector<CVector3>   m_ShellPathFrom;
+	vector<CVector3>   m_ShellPathTo;
+	vector<CVector3>   m_ShellPathStarts;
+	vector<CVector3>   m_ShellPathEnds;
+	vector<TFloat32>   m_ShellPathT;
+	vector<TEntityUID> m_ShellPathHits;
+	vector<TUInt32>    m_ShellTestPaths;
+	vector<CVector3>   m_ShellTestCentres;
+	vector<TFloat32>   m_ShellTestRadii;
+	vector<TEntityUID> m_ShellTestTanks;
+	vector<TFloat32>   m_ShellTestT;
+
+	// Bounding volumes of static scenery
+	CCollisionWorld m_CollisionWorld;
+
+	// Destroyed entities are not deleted immediately. The indexes of these entities in the entity
+	// list are queued here, in the order they were destroyed, and deleted together once per frame
+	// at the end of the update
+	bool            m_IsUpdating;
+	vector<TUInt32> m_DestroyQueue;
 
 
 	/////////////////////////////////////
 	// Data for Entity Enumeration
 
-	bool        m_IsEnumerating;
-	TEntityIter m_EnumEntity;
-	string      m_EnumName;
-	string      m_EnumTemplateName;
-	string      m_EnumTemplateType;
+	bool          m_IsEnumerating;
+	CEntityCursor m_EnumCursor;
 };
 
 
@@ -0,0 +1,218 @@
+/*******************************************
+	EntityStorage.cpp
+
+	Component storage for entity data, held
+	in contiguous per-component arrays
+********************************************/
+
+#include "EntityStorage.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor reserves space for the component arrays. Transform pointers are invalidated when
+// the transform arrays grow, so reserve enough to avoid that in normal use
+CEntityStorage::CEntityStorage()
+{
+	m_RelTransforms.reserve( 4096 );
+	m_Matrices.reserve( 4096 );
+
+	m_TankOwners.reserve( 256 );
+	m_TankIndexRefs.reserve( 256 );
+	m_TankHP.reserve( 256 );
+	m_TankSpeed.reserve( 256 );
+	m_TankState.reserve( 256 );
+	m_TankTimer.reserve( 256 );
+
+	m_ShellOwners.reserve( 1024 );
+	m_ShellIndexRefs.reserve( 1024 );
+	m_ShellTimer.reserve( 1024 );
+	m_ShellDamage.reserve( 1024 );
+	m_ShellParent.reserve( 1024 );
+	m_ShellPrevPosition.reserve( 1024 );
+}
+
+
+/////////////////////////////////////
+// Transform components
+
+// Allocate a block of relative transforms and absolute matrices for an entity with the given
+// number of nodes. Returns the index of the first node in the block
+TUInt32 CEntityStorage::CreateTransforms( TUInt32 numNodes )
+{
+	// Reuse a freed block of the same size if there is one
+	TFreeTransformsIter freeBlocks = m_FreeTransforms.find( numNodes );
+	if (freeBlocks != m_FreeTransforms.end() && freeBlocks->second.size())
+	{
+		TUInt32 first = freeBlocks->second.back();
+		freeBlocks->second.pop_back();
+		return first;
+	}
+
+	// Otherwise add a new block to the end of the transform arrays
+	TUInt32 first = static_cast<TUInt32>(m_RelTransforms.size());
+	m_RelTransforms.resize( first + numNodes );
+	m_Matrices.resize( first + numNodes );
+	return first;
+}
+
+// Free a block of transforms previously allocated with CreateTransforms
+void CEntityStorage::DestroyTransforms( TUInt32 first, TUInt32 numNodes )
+{
+	m_FreeTransforms[numNodes].push_back( first );
+}
+
+// Allocate the given number of transform blocks for entities with the given number of nodes
+// up front, one after another. Returns the index of the first node in the first block. The
+// blocks are not added to the free blocks - they belong to the caller until released
+TUInt32 CEntityStorage::ReserveTransforms( TUInt32 numNodes, TUInt32 numBlocks )
+{
+	TUInt32 first = static_cast<TUInt32>(m_RelTransforms.size());
+	m_RelTransforms.resize( first + numNodes * numBlocks );
+	m_Matrices.resize( first + numNodes * numBlocks );
+	return first;
+}
+
+// Return transform blocks reserved with ReserveTransforms to the free blocks
+void CEntityStorage::ReleaseTransforms( TUInt32 first, TUInt32 numNodes, TUInt32 numBlocks )
+{
+	vector<TUInt32>& freeBlocks = m_FreeTransforms[numNodes];
+	freeBlocks.reserve( freeBlocks.size() + numBlocks );
+
+	// Add blocks to the free list in reverse so they are reused in memory order
+	for (TUInt32 block = numBlocks; block > 0; --block)
+	{
+		freeBlocks.push_back( first + (block - 1) * numNodes );
+	}
+}
+
+
+/////////////////////////////////////
+// Tank components
+
+// Add tank data for the given owner entity. Returns the index of the data in the tank arrays
+TUInt32 CEntityStorage::CreateTank( CEntity* owner, TUInt32* indexRef, TInt32 HP )
+{
+	TUInt32 index = static_cast<TUInt32>(m_TankOwners.size());
+	m_TankOwners.push_back( owner );
+	m_TankIndexRefs.push_back( indexRef );
+	m_TankHP.push_back( HP );
+	m_TankSpeed.push_back( 0.0f );
+	m_TankState.push_back( 0 );
+	m_TankTimer.push_back( 0.0f );
+	return index;
+}
+
+// Remove the tank data at the given index. The data is only marked as unused, the space is
+// reclaimed by the next call to Compact
+void CEntityStorage::DestroyTank( TUInt32 index )
+{
+	m_TankOwners[index] = 0;
+	m_TankIndexRefs[index] = 0;
+}
+
+
+/////////////////////////////////////
+// Shell components
+
+// Add shell data for the given owner entity. Returns the index of the data in the shell arrays
+TUInt32 CEntityStorage::CreateShell( CEntity* owner, TUInt32* indexRef, TEntityUID parent,
+                                     TInt32 damage, TFloat32 timer, const CVector3& position )
+{
+	TUInt32 index = static_cast<TUInt32>(m_ShellOwners.size());
+	m_ShellOwners.push_back( owner );
+	m_ShellIndexRefs.push_back( indexRef );
+	m_ShellTimer.push_back( timer );
+	m_ShellDamage.push_back( damage );
+	m_ShellParent.push_back( parent );
+	m_ShellPrevPosition.push_back( position );
+	return index;
+}
+
+// Remove the shell data at the given index. The data is only marked as unused, the space is
+// reclaimed by the next call to Compact
+void CEntityStorage::DestroyShell( TUInt32 index )
+{
+	m_ShellOwners[index] = 0;
+	m_ShellIndexRefs[index] = 0;
+}
+
+// Reserve space in the shell arrays for the given number of shells in addition to the space
+// already reserved
+void CEntityStorage::ReserveShells( TUInt32 numShells )
+{
+	TUInt32 capacity = static_cast<TUInt32>(m_ShellOwners.capacity()) + numShells;
+	m_ShellOwners.reserve( capacity );
+	m_ShellIndexRefs.reserve( capacity );
+	m_ShellTimer.reserve( capacity );
+	m_ShellDamage.reserve( capacity );
+	m_ShellParent.reserve( capacity );
+	m_ShellPrevPosition.reserve( capacity );
+}
+
+
+/////////////////////////////////////
+// Compaction
+
+// Remove the unused tank and shell data left by DestroyTank and DestroyShell. Remaining data is
+// moved down to fill the gaps, keeping its order, and the owners' indexes are updated
+void CEntityStorage::Compact()
+{
+	// Tanks
+	TUInt32 newIndex = 0;
+	for (TUInt32 index = 0; index < m_TankOwners.size(); ++index)
+	{
+		if (m_TankOwners[index])
+		{
+			if (newIndex != index)
+			{
+				m_TankOwners[newIndex]    = m_TankOwners[index];
+				m_TankIndexRefs[newIndex] = m_TankIndexRefs[index];
+				m_TankHP[newIndex]        = m_TankHP[index];
+				m_TankSpeed[newIndex]     = m_TankSpeed[index];
+				m_TankState[newIndex]     = m_TankState[index];
+				m_TankTimer[newIndex]     = m_TankTimer[index];
+				*m_TankIndexRefs[newIndex] = newIndex;
+			}
+			++newIndex;
+		}
+	}
+	m_TankOwners.resize( newIndex );
+	m_TankIndexRefs.resize( newIndex );
+	m_TankHP.resize( newIndex );
+	m_TankSpeed.resize( newIndex );
+	m_TankState.resize( newIndex );
+	m_TankTimer.resize( newIndex );
+
+	// Shells
+	newIndex = 0;
+	for (TUInt32 index = 0; index < m_ShellOwners.size(); ++index)
+	{
+		if (m_ShellOwners[index])
+		{
+			if (newIndex != index)
+			{
+				m_ShellOwners[newIndex]       = m_ShellOwners[index];
+				m_ShellIndexRefs[newIndex]    = m_ShellIndexRefs[index];
+				m_ShellTimer[newIndex]        = m_ShellTimer[index];
+				m_ShellDamage[newIndex]       = m_ShellDamage[index];
+				m_ShellParent[newIndex]       = m_ShellParent[index];
+				m_ShellPrevPosition[newIndex] = m_ShellPrevPosition[index];
+				*m_ShellIndexRefs[newIndex] = newIndex;
+			}
+			++newIndex;
+		}
+	}
+	m_ShellOwners.resize( newIndex );
+	m_ShellIndexRefs.resize( newIndex );
+	m_ShellTimer.resize( newIndex );
+	m_ShellDamage.resize( newIndex );
+	m_ShellParent.resize( newIndex );
+	m_ShellPrevPosition.resize( newIndex );
+}
+
+
+} // namespace gen
@@ -0,0 +1,256 @@
+/*******************************************
+	EntityStorage.h
+
+	Component storage for entity data, held
+	in contiguous per-component arrays
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <map>
+using namespace std;
+
+#include "Defines.h"
+#include "CMatrix4x4.h"
+#include "CQuatTransform.h"
+#include "EntityHandle.h"
+
+namespace gen
+{
+
+class CEntity;
+
+// Entity node transforms relative to their parent are held as quaternion transforms (rotation,
+// position and scale, see CQuatTransform.h). They are smaller than matrices, are composed more
+// cheaply and don't drift out of orthogonality with repeated rotation. Define
+// GEN_ENTITY_MATRIX_TRANSFORMS to hold them as matrices instead. Only uniform scaling is
+// supported by quaternion transforms - composing non-uniform scales gives no shear
+#ifdef GEN_ENTITY_MATRIX_TRANSFORMS
+	typedef CMatrix4x4 TNodeTransform;
+#else
+	typedef CQuatTransform TNodeTransform;
+#endif
+
+// The entity storage holds the frequently updated entity data (transforms, tank state and shell
+// state) in contiguous arrays - one array per component value, rather than one heap object per
+// entity. The entity classes are thin views over this data: each entity holds an index into the
+// arrays for each component it uses
+//
+// The tank and shell arrays are kept packed - i.e. with no gaps. Removing a component only marks
+// it as unused, the gaps are closed by Compact, which moves the remaining components down (in
+// order) and updates each owning entity's copy of its index. Transforms are allocated as a block
+// per entity (one relative transform and absolute matrix per mesh node) and freed blocks are
+// recycled for later entities with the same number of nodes
+class CEntityStorage
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor reserves space for the component arrays
+	CEntityStorage();
+
+	// No destructor needed
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CEntityStorage( const CEntityStorage& );
+	CEntityStorage& operator=( const CEntityStorage& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Transform components
+
+	// Index used to indicate no transform block
+	static const TUInt32 NoTransforms = 0xffffffff;
+
+	// Allocate a block of relative transforms and absolute matrices for an entity with the given
+	// number of nodes. Returns the index of the first node in the block. Pointers returned below
+	// are only valid until the next allocation
+	TUInt32 CreateTransforms( TUInt32 numNodes );
+
+	// Free a block of transforms previously allocated with CreateTransforms
+	void DestroyTransforms( TUInt32 first, TUInt32 numNodes );
+
+	// Allocate the given number of transform blocks for entities with the given number of nodes
+	// up front, one after another. Returns the index of the first node in the first block. The
+	// blocks belong to the caller - they are not added to the free blocks, so no other entity
+	// can take them. Return them with ReleaseTransforms when they are no longer needed
+	TUInt32 ReserveTransforms( TUInt32 numNodes, TUInt32 numBlocks );
+
+	// Return transform blocks reserved with ReserveTransforms to the free blocks
+	void ReleaseTransforms( TUInt32 first, TUInt32 numNodes, TUInt32 numBlocks );
+
+	// Return the relative transforms / absolute matrices of the block starting at the given index
+	TNodeTransform* RelTransforms( TUInt32 first )
+	{
+		return &m_RelTransforms[first];
+	}
+	CMatrix4x4* Matrices( TUInt32 first )
+	{
+		return &m_Matrices[first];
+	}
+
+	// Return working space for the absolute transforms of an entity's nodes while its matrices
+	// are calculated, with room for at least the given number of nodes. Only valid until the
+	// next call
+	TNodeTransform* WorldTransformScratch( TUInt32 numNodes )
+	{
+		if (m_WorldTransformScratch.size() < numNodes)
+		{
+			m_WorldTransformScratch.resize( numNodes );
+		}
+		return &m_WorldTransformScratch[0];
+	}
+
+
+	/////////////////////////////////////
+	// Tank components
+
+	// Add tank data for the given owner entity. Returns the index of the data in the tank arrays.
+	// The storage keeps a pointer to the owner's copy of the index to update it if the data moves
+	TUInt32 CreateTank( CEntity* owner, TUInt32* indexRef, TInt32 HP );
+
+	// Remove the tank data at the given index. The data stays in the arrays (with a null owner)
+	// until the next call to Compact
+	void DestroyTank( TUInt32 index );
+
+	TUInt32 NumTanks()
+	{
+		return static_cast<TUInt32>(m_TankOwners.size());
+	}
+
+	CEntity* GetTankOwner( TUInt32 index )
+	{
+		return m_TankOwners[index];
+	}
+
+	// Direct access to tank data
+	TInt32& TankHP( TUInt32 index )
+	{
+		return m_TankHP[index];
+	}
+	TFloat32& TankSpeed( TUInt32 index )
+	{
+		return m_TankSpeed[index];
+	}
+	TEnumInt& TankState( TUInt32 index )
+	{
+		return m_TankState[index];
+	}
+	TFloat32& TankTimer( TUInt32 index )
+	{
+		return m_TankTimer[index];
+	}
+
+
+	/////////////////////////////////////
+	// Shell components
+
+	// Add shell data for the given owner entity. Returns the index of the data in the shell arrays.
+	// The storage keeps a pointer to the owner's copy of the index to update it if the data moves
+	// The shell's previous position starts at the given position
+	TUInt32 CreateShell( CEntity* owner, TUInt32* indexRef, TEntityUID parent, TInt32 damage,
+	                     TFloat32 timer, const CVector3& position );
+
+	// Remove the shell data at the given index. The data stays in the arrays (with a null owner)
+	// until the next call to Compact
+	void DestroyShell( TUInt32 index );
+
+	// Reserve space in the shell arrays for the given number of shells in addition to the space
+	// already reserved
+	void ReserveShells( TUInt32 numShells );
+
+	TUInt32 NumShells()
+	{
+		return static_cast<TUInt32>(m_ShellOwners.size());
+	}
+
+	CEntity* GetShellOwner( TUInt32 index )
+	{
+		return m_ShellOwners[index];
+	}
+
+	// Direct access to shell data. The previous position is where the shell was before its last
+	// move, so its path over the last frame can be tested for collisions
+	TFloat32& ShellTimer( TUInt32 index )
+	{
+		return m_ShellTimer[index];
+	}
+	TInt32& ShellDamage( TUInt32 index )
+	{
+		return m_ShellDamage[index];
+	}
+	TEntityUID& ShellParent( TUInt32 index )
+	{
+		return m_ShellParent[index];
+	}
+	CVector3& ShellPrevPosition( TUInt32 index )
+	{
+		return m_ShellPrevPosition[index];
+	}
+
+
+	/////////////////////////////////////
+	// Compaction
+
+	// Remove the unused tank and shell data left by DestroyTank and DestroyShell. Remaining data
+	// is moved down to fill the gaps, keeping its order, and the owners' indexes are updated
+	void Compact();
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// Lists of free transform blocks are held in a map from number of nodes to block indexes
+	typedef map<TUInt32, vector<TUInt32> > TFreeTransforms;
+	typedef TFreeTransforms::iterator      TFreeTransformsIter;
+
+
+	/////////////////////////////////////
+	// Transform Data
+
+	// Relative transforms and absolute world matrices for each node of each entity
+	vector<TNodeTransform> m_RelTransforms;
+	vector<CMatrix4x4>     m_Matrices;
+
+	// Working space for WorldTransformScratch
+	vector<TNodeTransform> m_WorldTransformScratch;
+
+	// Freed transform blocks available for reuse
+	TFreeTransforms m_FreeTransforms;
+
+
+	/////////////////////////////////////
+	// Tank Data
+
+	vector<CEntity*> m_TankOwners;    // Entity using each set of tank data
+	vector<TUInt32*> m_TankIndexRefs; // Pointer to the owner's index for each set of tank data
+	vector<TInt32>   m_TankHP;        // Current hit points for the tank
+	vector<TFloat32> m_TankSpeed;     // Current speed (in facing direction)
+	vector<TEnumInt> m_TankState;     // Current state
+	vector<TFloat32> m_TankTimer;     // General purpose timer for tank behaviour
+
+
+	/////////////////////////////////////
+	// Shell Data
+
+	vector<CEntity*>   m_ShellOwners;       // Entity using each set of shell data
+	vector<TUInt32*>   m_ShellIndexRefs;    // Pointer to the owner's index for each set of shell data
+	vector<TFloat32>   m_ShellTimer;        // Time remaining before the shell expires
+	vector<TInt32>     m_ShellDamage;       // HP damage caused by the shell
+	vector<TEntityUID> m_ShellParent;       // UID of the tank that fired the shell
+	vector<CVector3>   m_ShellPrevPosition; // Position before the shell's last move
+};
+
+
+} // namespace gen
@@ -4,6 +4,9 @@
 	Entity messenger class implementation
 ********************************************/
 
+#include <algorithm>
+using namespace std;
+
 #include "Messenger.h"
 
 namespace gen
@@ -16,38 +19,605 @@ namespace gen
 CMessenger Messenger;
 
 
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Default constructor - no mailboxes are allocated until messages are sent
+CMessenger::CMessenger()
+{
+	for (TUInt32 page = 0; page < NumPages; ++page)
+	{
+		m_Pages[page].store( 0, memory_order_relaxed );
+	}
+	m_NumDropped.store( 0, memory_order_relaxed );
+	m_NumOverflowed.store( 0, memory_order_relaxed );
+
+	// No group messages. Records are marked as not ready by setting their sequence number to one
+	// that is never used for that record
+	for (TUInt32 record = 0; record < MaxGroupMessages; ++record)
+	{
+		m_GroupMessages[record].sequence.store( record - 1, memory_order_relaxed );
+	}
+	m_FirstGroupMessage = 0;
+	m_NextGroupMessage.store( 0, memory_order_relaxed );
+	m_GroupRetireMark = 0;
+	m_FirstGroupUID = 0;
+	m_NextGroupUID.store( 0, memory_order_relaxed );
+	m_GroupUIDRetireMark = 0;
+	m_FirstHiddenGroupMessage = 0;
+
+	// Immediate delivery by default
+	m_Buffered = false;
+	m_NumPendingMessages[0].store( 0, memory_order_relaxed );
+	m_NumPendingMessages[1].store( 0, memory_order_relaxed );
+	m_SendBuffer = 0;
+	m_SystemSendCount.store( 0, memory_order_relaxed );
+
+	m_PayloadUsed.store( 0, memory_order_relaxed );
+	m_Frame = 0;
+
+	m_NumSent.store( 0, memory_order_relaxed );
+	m_NumReceived.store( 0, memory_order_relaxed );
+	m_NumSentLastFrame = 0;
+	m_NumReceivedLastFrame = 0;
+}
+
+// Destructor frees the mailboxes
+CMessenger::~CMessenger()
+{
+	for (TUInt32 page = 0; page < NumPages; ++page)
+	{
+		delete m_Pages[page].load( memory_order_relaxed );
+	}
+}
+
+// Mailbox constructor - each cell's sequence number starts as its index, which marks it as free
+// for the sender at that position
+CMessenger::SMailbox::SMailbox()
+{
+	for (TUInt32 cell = 0; cell < MailboxSize; ++cell)
+	{
+		cells[cell].sequence.store( cell, memory_order_relaxed );
+	}
+	enqueuePos.store( 0, memory_order_relaxed );
+	dequeuePos = 0;
+	overflowPos = 0;
+	numOverflow.store( 0, memory_order_relaxed );
+	peekedOverflow = false;
+	groupCursor = 0;
+	owner = NullUID;
+	team = 0;
+	templateName = NoSymbol;
+	sendCount.store( 0, memory_order_relaxed );
+}
+
+
 /////////////////////////////////////
 // Message sending/receiving
 
 // Send the given message to a particular UID, does not check if the UID exists
 void CMessenger::SendMessage( TEntityUID to, const SMessage& msg )
 {
-	// Simply insert the UID/message pair into the message map. It will be inserted next
-	// to any other pairs with the same UID
-	m_Messages.insert( UIDMsgPair( to, msg ) );
+	// Record which group messages were sent before this one
+	SQueuedMessage queued;
+	queued.to = to;
+	queued.groupSeq = m_NextGroupMessage.load( memory_order_acquire );
+	queued.message = msg;
+
+	if (m_Buffered)
+	{
+		// Hold the message back until the start of the next frame, recording its position in the
+		// messages sent by its sender so delivery order can be made independent of thread timing
+		SPendingMessage pendingMessage;
+		pendingMessage.sendCount = NextSendCount( msg.from );
+		pendingMessage.queued = queued;
+
+		// Use the next place in the send buffer, or its overflow list if the buffer is full. The
+		// count keeps rising when full, it is clamped when the buffer is delivered
+		TUInt32 pending = m_NumPendingMessages[m_SendBuffer].fetch_add( 1, memory_order_relaxed );
+		if (pending < MaxPendingMessages)
+		{
+			m_PendingMessages[m_SendBuffer][pending] = pendingMessage;
+		}
+		else
+		{
+			lock_guard<mutex> lock( m_PendingOverflowLock );
+			m_PendingOverflow[m_SendBuffer].push_back( pendingMessage );
+		}
+	}
+	else
+	{
+		AddToMailbox( GetMailbox( to ), queued );
+	}
+
+	m_NumSent.fetch_add( 1, memory_order_relaxed );
 }
 
 
 // Fetch the next available message for the given UID, returns the message through the given 
-// pointer. Returns false if there are no messages for this UID
+// pointer. Returns false if there are no messages for this UID. Group messages and messages sent
+// directly to the UID are returned in the order they were sent
 bool CMessenger::FetchMessage( TEntityUID to, SMessage* msg )
 {
-	// Find the first message for this UID in the message map
-	TMessageIter itMessage = m_Messages.find( to );
+	SMailbox* mailbox = GetMailbox( to );
+
+	// Skip any retired group messages
+	if (static_cast<TInt32>(mailbox->groupCursor - m_FirstGroupMessage) < 0)
+	{
+		mailbox->groupCursor = m_FirstGroupMessage;
+	}
+
+	// In buffered mode group messages sent this frame are not visible yet
+	TUInt32 groupEnd = m_Buffered ? m_FirstHiddenGroupMessage :
+	                                m_NextGroupMessage.load( memory_order_acquire );
+
+	SQueuedMessage queued;
+	while (true)
+	{
+		// Group messages sent before the next direct message are fetched first
+		bool isQueued = PeekMailbox( mailbox, &queued );
+		TUInt32 end = groupEnd;
+		if (isQueued && static_cast<TInt32>(queued.groupSeq - end) < 0)
+		{
+			end = queued.groupSeq;
+		}
+		if (FetchGroupMessage( mailbox, to, end, msg ))
+		{
+			m_NumReceived.fetch_add( 1, memory_order_relaxed );
+			return true;
+		}
+
+		// Stop if a group message that must come first has not been published yet, or there are
+		// no more messages. Try again on the next fetch
+		if (static_cast<TInt32>(end - mailbox->groupCursor) > 0 || !isQueued)
+		{
+			return false;
+		}
+
+		PopMailbox( mailbox );
+
+		// Messages for an earlier entity using the same slot are discarded
+		if (queued.to == to)
+		{
+			*msg = queued.message;
+			m_NumReceived.fetch_add( 1, memory_order_relaxed );
+			return true;
+		}
+	}
+}
+
+// Prepare the mailbox for a new entity. Its group cursor starts at the next group message, so
+// group messages sent before the entity existed are not received
+void CMessenger::OpenMailbox( TEntityUID UID, TUInt32 team, TSymbol templateName )
+{
+	SMailbox* mailbox = GetMailbox( UID );
+	mailbox->owner = UID;
+	mailbox->team = team;
+	mailbox->templateName = templateName;
+	mailbox->groupCursor = m_NextGroupMessage.load( memory_order_acquire );
+}
+
+
+/////////////////////////////////////
+// Payloads
+
+// Allocate a payload of the given size for a message, returning a pointer to write the data
+// to, or 0 if there is no space. The message is set to use the block
+void* CMessenger::AllocatePayload( SMessage* msg, TUInt32 size )
+{
+	// Claim space in this frame's half of the arena, keeping each payload aligned
+	TUInt32 alignedSize = (size + PayloadAlignment - 1) & ~(PayloadAlignment - 1);
+	TUInt32 offset = m_PayloadUsed.fetch_add( alignedSize, memory_order_relaxed );
+	if (alignedSize > PayloadArenaSize || offset > PayloadArenaSize - alignedSize)
+	{
+		return 0;
+	}
+
+	msg->payloadType = Payload_Block;
+	msg->block.frame = m_Frame;
+	msg->block.offset = offset;
+	msg->block.size = size;
+	return &m_PayloadArena[m_Frame & 1][offset];
+}
 
-	// See if no messages for this UID
-	if (itMessage == m_Messages.end())
+// Return a pointer to the payload block of a message, or 0 if the message has no block or the
+// block has expired
+const void* CMessenger::GetPayload( const SMessage& msg )
+{
+	// Blocks are kept for the frame they were allocated in and the next one
+	if (msg.payloadType != Payload_Block ||
+	    (msg.block.frame != m_Frame && msg.block.frame != m_Frame - 1))
 	{
+		return 0;
+	}
+	return &m_PayloadArena[msg.block.frame & 1][msg.block.offset];
+}
+
+
+/////////////////////////////////////
+// Frames / buffered delivery
+
+// Start a new frame. In buffered mode this delivers the messages sent during the last frame.
+// Also starts the per-frame message counts
+void CMessenger::BeginFrame()
+{
+	if (m_Buffered)
+	{
+		// Swap buffers so messages sent from now on go to the other buffer, then deliver the
+		// messages sent during the last frame
+		TUInt32 deliverBuffer = m_SendBuffer;
+		m_SendBuffer ^= 1;
+		DeliverPendingMessages( deliverBuffer );
+		m_FirstHiddenGroupMessage = m_NextGroupMessage.load( memory_order_relaxed );
+	}
+
+	// Switch to the other half of the payload arena, discarding the payloads from two frames ago
+	++m_Frame;
+	m_PayloadUsed.store( 0, memory_order_relaxed );
+
+	m_NumSentLastFrame = m_NumSent.exchange( 0, memory_order_relaxed );
+	m_NumReceivedLastFrame = m_NumReceived.exchange( 0, memory_order_relaxed );
+}
+
+// Select buffered mode or immediate delivery. Messages held back when buffered mode is turned
+// off are delivered immediately
+void CMessenger::SetBuffered( bool buffered )
+{
+	if (m_Buffered && !buffered)
+	{
+		DeliverPendingMessages( m_SendBuffer );
+	}
+	m_FirstHiddenGroupMessage = m_NextGroupMessage.load( memory_order_relaxed );
+	m_Buffered = buffered;
+}
+
+// Return the position of a new message in the messages sent by the given UID. SystemUID has its
+// own count rather than a mailbox
+TUInt32 CMessenger::NextSendCount( TEntityUID from )
+{
+	if (from == SystemUID)
+	{
+		return m_SystemSendCount.fetch_add( 1, memory_order_relaxed );
+	}
+	return GetMailbox( from )->sendCount.fetch_add( 1, memory_order_relaxed );
+}
+
+// Deliver the messages held back in the given buffer in buffered mode, sorted by sender then
+// send order. Mailboxes don't lose messages, so neither does delivery
+void CMessenger::DeliverPendingMessages( TUInt32 buffer )
+{
+	SPendingMessage* pendingMessages = m_PendingMessages[buffer];
+	TUInt32 numPending = m_NumPendingMessages[buffer].load( memory_order_relaxed );
+	if (numPending > MaxPendingMessages)
+	{
+		// Some messages went to the overflow list - sort them all together in the list
+		vector<SPendingMessage>& overflow = m_PendingOverflow[buffer];
+		overflow.insert( overflow.end(), pendingMessages, pendingMessages + MaxPendingMessages );
+		pendingMessages = &overflow[0];
+		numPending = static_cast<TUInt32>(overflow.size());
+	}
+
+	sort( pendingMessages, pendingMessages + numPending, PendingMessageLess );
+	for (TUInt32 pending = 0; pending < numPending; ++pending)
+	{
+		const SQueuedMessage& queued = pendingMessages[pending].queued;
+		AddToMailbox( GetMailbox( queued.to ), queued );
+	}
+
+	m_PendingOverflow[buffer].clear();
+	m_NumPendingMessages[buffer].store( 0, memory_order_relaxed );
+}
+
+
+/////////////////////////////////////
+// Group messages
+
+// Send the given message to all entities
+bool CMessenger::SendMessageToAll( const SMessage& msg )
+{
+	TUInt32 seq = 0;
+	SGroupMessage* record = AddGroupMessage( 0, &seq );
+	if (!record)
+	{
+		m_NumDropped.fetch_add( 1, memory_order_relaxed );
 		return false;
 	}
+	PublishGroupMessage( record, seq, Group_All, 0, msg );
+	m_NumSent.fetch_add( 1, memory_order_relaxed );
+	return true;
+}
 
-	// Return message, then delete it
-	*msg = itMessage->second;
-	m_Messages.erase( itMessage );
+// Send the given message to all tanks on a team
+bool CMessenger::SendMessageToTeam( TUInt32 team, const SMessage& msg )
+{
+	TUInt32 seq = 0;
+	SGroupMessage* record = AddGroupMessage( 0, &seq );
+	if (!record)
+	{
+		m_NumDropped.fetch_add( 1, memory_order_relaxed );
+		return false;
+	}
+	PublishGroupMessage( record, seq, Group_Team, team, msg );
+	m_NumSent.fetch_add( 1, memory_order_relaxed );
+	return true;
+}
 
+// Send the given message to all entities of a template
+bool CMessenger::SendMessageToTemplate( TSymbol templateName, const SMessage& msg )
+{
+	TUInt32 seq = 0;
+	SGroupMessage* record = AddGroupMessage( 0, &seq );
+	if (!record)
+	{
+		m_NumDropped.fetch_add( 1, memory_order_relaxed );
+		return false;
+	}
+	PublishGroupMessage( record, seq, Group_Template, templateName, msg );
+	m_NumSent.fetch_add( 1, memory_order_relaxed );
 	return true;
 }
 
+// Send the given message to each UID in the given list
+bool CMessenger::SendMessageToList( const TEntityUID* UIDs, TUInt32 numUIDs, const SMessage& msg )
+{
+	TUInt32 seq = 0;
+	SGroupMessage* record = AddGroupMessage( numUIDs, &seq );
+	if (!record)
+	{
+		m_NumDropped.fetch_add( 1, memory_order_relaxed );
+		return false;
+	}
+
+	// Copy the UIDs and sort them so recipients can find themselves with a binary search
+	TEntityUID* firstUID = &m_GroupUIDs[record->firstUID & (MaxGroupUIDs - 1)];
+	copy( UIDs, UIDs + numUIDs, firstUID );
+	sort( firstUID, firstUID + numUIDs );
+
+	PublishGroupMessage( record, seq, Group_List, 0, msg );
+	m_NumSent.fetch_add( 1, memory_order_relaxed );
+	return true;
+}
+
+
+// Retire group messages that have been available for a whole entity update. Messages sent
+// before the previous call are retired
+void CMessenger::RetireGroupMessages()
+{
+	m_FirstGroupMessage = m_GroupRetireMark;
+	m_GroupRetireMark = m_NextGroupMessage.load( memory_order_relaxed );
+
+	m_FirstGroupUID = m_GroupUIDRetireMark;
+	m_GroupUIDRetireMark = m_NextGroupUID.load( memory_order_relaxed );
+}
+
+
+/////////////////////////////////////
+// Support functions
+
+// Add a message to a mailbox, using its overflow list if the mailbox is full
+void CMessenger::AddToMailbox( SMailbox* mailbox, const SQueuedMessage& queued )
+{
+	// Use the ring unless messages are waiting in the overflow list - they must be fetched first
+	if (mailbox->numOverflow.load( memory_order_acquire ) == 0)
+	{
+		// Claim the cell at the enqueue position. If the cell's sequence number equals the
+		// position it is free, if it is behind the mailbox is full, if it is ahead another sender
+		// has claimed it first - reload the position and try again
+		TUInt32 pos = mailbox->enqueuePos.load( memory_order_relaxed );
+		while (true)
+		{
+			SMailboxCell* cell = &mailbox->cells[pos & (MailboxSize - 1)];
+			TUInt32 sequence = cell->sequence.load( memory_order_acquire );
+			TInt32 diff = static_cast<TInt32>(sequence - pos);
+			if (diff == 0)
+			{
+				if (mailbox->enqueuePos.compare_exchange_weak( pos, pos + 1, memory_order_relaxed ))
+				{
+					// Write the message then publish it to the recipient by updating the sequence
+					// number
+					cell->queued = queued;
+					cell->sequence.store( pos + 1, memory_order_release );
+					return;
+				}
+			}
+			else if (diff < 0)
+			{
+				break; // Full
+			}
+			else
+			{
+				pos = mailbox->enqueuePos.load( memory_order_relaxed );
+			}
+		}
+	}
+
+	// The ring is full or the overflow list is in use, add the message to the overflow list
+	{
+		lock_guard<mutex> lock( mailbox->overflowLock );
+		mailbox->overflow.push_back( queued );
+		mailbox->numOverflow.fetch_add( 1, memory_order_release );
+	}
+	m_NumOverflowed.fetch_add( 1, memory_order_relaxed );
+}
+
+// Get a copy of the next message waiting in a mailbox without removing it. Returns false if the
+// mailbox is empty. Messages in the ring are older than those in the overflow list
+bool CMessenger::PeekMailbox( SMailbox* mailbox, SQueuedMessage* queued )
+{
+	// The cell at the dequeue position holds a message if its sequence number is one ahead of the
+	// position
+	TUInt32 pos = mailbox->dequeuePos;
+	SMailboxCell* cell = &mailbox->cells[pos & (MailboxSize - 1)];
+	if (cell->sequence.load( memory_order_acquire ) == pos + 1)
+	{
+		*queued = cell->queued;
+		mailbox->peekedOverflow = false;
+		return true;
+	}
+
+	if (mailbox->numOverflow.load( memory_order_acquire ) == 0)
+	{
+		return false;
+	}
+	lock_guard<mutex> lock( mailbox->overflowLock );
+	*queued = mailbox->overflow[mailbox->overflowPos];
+	mailbox->peekedOverflow = true;
+	return true;
+}
+
+// Remove the message returned by the last call to PeekMailbox
+void CMessenger::PopMailbox( SMailbox* mailbox )
+{
+	// Free the ring cell for the sender one lap of the ring later
+	if (!mailbox->peekedOverflow)
+	{
+		TUInt32 pos = mailbox->dequeuePos;
+		mailbox->dequeuePos = pos + 1;
+		mailbox->cells[pos & (MailboxSize - 1)].sequence.store( pos + MailboxSize,
+		                                                        memory_order_release );
+		return;
+	}
+
+	// Take from the overflow list, emptying the list when all its messages are fetched
+	lock_guard<mutex> lock( mailbox->overflowLock );
+	++mailbox->overflowPos;
+	if (mailbox->overflowPos == mailbox->overflow.size())
+	{
+		mailbox->overflow.clear();
+		mailbox->overflowPos = 0;
+	}
+	mailbox->numOverflow.fetch_sub( 1, memory_order_release );
+}
+
+// Return the mailbox for the given UID, allocating its page if necessary
+CMessenger::SMailbox* CMessenger::GetMailbox( TEntityUID to )
+{
+	TUInt32 index = EntityUIDIndex( to );
+	atomic<SMailboxPage*>& pageRef = m_Pages[index / PageSize];
+
+	SMailboxPage* page = pageRef.load( memory_order_acquire );
+	if (!page)
+	{
+		// Allocate the page and try to store it. If another thread stored a page first then
+		// use that one instead
+		SMailboxPage* newPage = new SMailboxPage;
+		if (pageRef.compare_exchange_strong( page, newPage, memory_order_acq_rel ))
+		{
+			page = newPage;
+		}
+		else
+		{
+			delete newPage;
+		}
+	}
+	return &page->mailboxes[index & (PageSize - 1)];
+}
+
+// Add a group message record, for list groups also reserve space for the UIDs. Returns the
+// record to fill in, or 0 if there is no space
+CMessenger::SGroupMessage* CMessenger::AddGroupMessage( TUInt32 numUIDs, TUInt32* seq )
+{
+	// Reserve UIDs first - if there is then no space for the record, the UIDs are just left
+	// unused until they are retired. The UIDs for one message must not wrap round the end of the
+	// ring so they can be sorted and searched in place
+	TUInt32 firstUID = 0;
+	if (numUIDs > 0)
+	{
+		if (numUIDs > MaxGroupUIDs)
+		{
+			return 0;
+		}
+		TUInt32 pos = m_NextGroupUID.load( memory_order_relaxed );
+		TUInt32 first;
+		do
+		{
+			first = pos;
+			if ((first & (MaxGroupUIDs - 1)) + numUIDs > MaxGroupUIDs)
+			{
+				first = (first + MaxGroupUIDs - 1) & ~(MaxGroupUIDs - 1); // Start of next lap
+			}
+			if (first + numUIDs - m_FirstGroupUID > MaxGroupUIDs)
+			{
+				return 0;
+			}
+		} while (!m_NextGroupUID.compare_exchange_weak( pos, first + numUIDs, memory_order_relaxed ));
+		firstUID = first;
+	}
+
+	// Reserve the record
+	TUInt32 pos = m_NextGroupMessage.load( memory_order_relaxed );
+	do
+	{
+		if (pos - m_FirstGroupMessage >= MaxGroupMessages)
+		{
+			return 0;
+		}
+	} while (!m_NextGroupMessage.compare_exchange_weak( pos, pos + 1, memory_order_relaxed ));
+
+	SGroupMessage* record = &m_GroupMessages[pos & (MaxGroupMessages - 1)];
+	record->firstUID = firstUID;
+	record->numUIDs = numUIDs;
+	*seq = pos;
+	return record;
+}
+
+// Fill in and publish a group message record added with AddGroupMessage
+void CMessenger::PublishGroupMessage( SGroupMessage* record, TUInt32 seq, EMessageGroup group,
+                                      TUInt32 value, const SMessage& msg )
+{
+	record->group = group;
+	record->value = value;
+	record->message = msg;
+	record->sequence.store( seq, memory_order_release );
+}
+
+
+// Fetch the next group message for the given UID from its mailbox, only checking group messages
+// before the given sequence number
+bool CMessenger::FetchGroupMessage( SMailbox* mailbox, TEntityUID to, TUInt32 end, SMessage* msg )
+{
+	while (static_cast<TInt32>(end - mailbox->groupCursor) > 0)
+	{
+		// Stop at a record that has been reserved but not yet published, try again next fetch
+		SGroupMessage& record = m_GroupMessages[mailbox->groupCursor & (MaxGroupMessages - 1)];
+		if (record.sequence.load( memory_order_acquire ) != mailbox->groupCursor)
+		{
+			return false;
+		}
+
+		++mailbox->groupCursor;
+		if (IsInGroup( record, mailbox, to ))
+		{
+			*msg = record.message;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Return true if the given UID, using the given mailbox, is in the group of a group message.
+// Team and template membership were given when the mailbox was opened
+bool CMessenger::IsInGroup( const SGroupMessage& record, const SMailbox* mailbox, TEntityUID to )
+{
+	switch (record.group)
+	{
+		case Group_All:
+			return true;
+
+		case Group_Team:
+			return mailbox->owner == to && mailbox->team == record.value;
+
+		case Group_Template:
+			return mailbox->owner == to && mailbox->templateName == record.value;
+
+		case Group_List:
+		{
+			const TEntityUID* firstUID = &m_GroupUIDs[record.firstUID & (MaxGroupUIDs - 1)];
+			return binary_search( firstUID, firstUID + record.numUIDs, to );
+		}
+	}
+	return false;
+}
 
 
 } // namespace gen
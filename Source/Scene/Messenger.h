@@ -6,10 +6,14 @@
 
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <mutex>
+#include <vector>
 using namespace std;
 
 #include "Defines.h"
+#include "StringTable.h"
+#include "EntityHandle.h"
 #include "Entity.h"
 
 namespace gen
@@ -26,14 +30,51 @@ enum EMessageType
 	Msg_Hit
 };
 
-// A message contains a type and the UID that sent it.
-// The message types for this exercise don't currently require extra data, but it is possible
-// to use a union to add additional data for new message types (see the space game code)
+// Types of data that can be carried by a message (the payload)
+enum EPayloadType
+{
+	Payload_Int,    // A single integer - data
+	Payload_UID,    // An entity UID - uid, e.g. a target
+	Payload_Vector, // A vector - vector, e.g. a velocity
+	Payload_Hit,    // Damage and position - hit
+	Payload_Block   // Any other data, held in the messenger's payload arena - block
+};
+
+// Payload structures must be data only (no constructors), so they can be held in a union. The
+// vector type is a plain version of CVector3 for this reason
+struct SVectorPayload
+{
+	TFloat32 x, y, z;
+};
+
+struct SHitPayload
+{
+	TInt32         damage; // First so that data also holds the damage
+	SVectorPayload position;
+};
+
+// A block of payload data in the messenger's payload arena, see CMessenger::AllocatePayload
+struct SPayloadBlock
+{
+	TUInt32 frame;  // Frame the block was allocated in
+	TUInt32 offset; // Position in the arena
+	TUInt32 size;   // Size in bytes
+};
+
+
+// A message contains a type and the UID that sent it, and a payload of extra data. The payload
+// is a union of the possible payload types, selected by payloadType. Read the payload in place,
+// e.g. msg.hit.position, or use the helper functions. Larger payloads are allocated in the
+// messenger and read with CMessenger::GetPayload, they are not copied with the message
 struct SMessage
 {
-	// Need to provide copy constructor and assignment operator in case you later add a union to this structure
+	// Need to provide copy constructor and assignment operator as this structure contains a union
 	// The compiler does not know which of the union contents are in use so it cannot provide default versions
-	SMessage() {} // Need to explicitly write default constructor when other constructors are provided
+	SMessage() // Need to explicitly write default constructor when other constructors are provided
+	{
+		payloadType = Payload_Int;
+		data = 0;
+	}
 	SMessage(const SMessage& o)
 	{
 		memcpy(this, &o, sizeof(SMessage)); // Use of memcpy is only safe if SMessage is a "POD" type - data
@@ -46,23 +87,97 @@ struct SMessage
 	}
 
 
+	//*** Payload helpers
+
+	void SetUID( TEntityUID payloadUID )
+	{
+		payloadType = Payload_UID;
+		uid = payloadUID;
+	}
+
+	void SetVector( const CVector3& v )
+	{
+		payloadType = Payload_Vector;
+		vector.x = v.x;
+		vector.y = v.y;
+		vector.z = v.z;
+	}
+	CVector3 GetVector() const
+	{
+		return CVector3( vector.x, vector.y, vector.z );
+	}
+
+	void SetHit( TInt32 damage, const CVector3& position )
+	{
+		payloadType = Payload_Hit;
+		hit.damage = damage;
+		hit.position.x = position.x;
+		hit.position.y = position.y;
+		hit.position.z = position.z;
+	}
+	CVector3 GetHitPosition() const
+	{
+		return CVector3( hit.position.x, hit.position.y, hit.position.z );
+	}
+
+
 	//*** Message data
 	EMessageType type;
 	TEntityUID   from;
-	TInt32		 data;
+	EPayloadType payloadType;
+	union
+	{
+		TInt32         data;   // Payload_Int
+		TEntityUID     uid;    // Payload_UID
+		SVectorPayload vector; // Payload_Vector
+		SHitPayload    hit;    // Payload_Hit
+		SPayloadBlock  block;  // Payload_Block
+	};
+};
+
+
+// Groups of entities that a single message can be sent to
+enum EMessageGroup
+{
+	Group_All,      // All entities
+	Group_Team,     // All tanks on a team
+	Group_Template, // All entities of a template
+	Group_List      // An explicit list of UIDs
 };
 
 
 // Messenger class allows the sending and receipt of messages between entities - addressed by UID
+//
+// Each recipient has its own mailbox, a fixed-size ring buffer of messages. Messages can be sent
+// from several threads at once without a lock (multiple producers), but only one thread may
+// fetch the messages for a given UID (single consumer) - normally the recipient itself during its
+// update. If a mailbox is full, messages go to an overflow list (with a lock) until the recipient
+// has caught up, so no message is lost. Mailboxes are found from the slot index in the
+// recipient's UID, so a UID's mailbox is reused by later entities in the same slot - messages
+// for a destroyed entity are discarded when the new entity fetches its messages
+//
+// A message can also be sent to a group of entities. Only one record is stored for the whole
+// group, each recipient picks it up when it next fetches its messages. Group messages stay
+// available for one full entity update, see RetireGroupMessages. An entity's team and template
+// are given to the messenger when the entity is created (OpenMailbox), and an entity only
+// receives group messages sent after that. Group and direct messages are fetched in the order
+// they were sent
+//
+// In buffered mode, messages are not delivered as soon as they are sent. Messages sent during a
+// frame are held back and delivered together by BeginFrame at the start of the next frame,
+// sorted by sender and the order each sender sent them. So what an entity receives does not
+// depend on the order entities are updated or which thread sent first. Messages are held in two
+// buffers that swap roles each frame - one receives new messages while the other is delivered
 class CMessenger
 {
 /////////////////////////////////////
 //	Constructors/Destructors
 public:
 	// Default constructor
-	CMessenger() {}
+	CMessenger();
 
-	// No destructor needed
+	// Destructor frees the mailboxes
+	~CMessenger();
 
 private:
 	// Disallow use of copy constructor and assignment operator (private and not defined)
@@ -77,28 +192,332 @@ public:
 	/////////////////////////////////////
 	// Message sending/receiving
 
-	// Send the given message to a particular UID, does not check if the UID exists
+	// Send the given message to a particular UID, does not check if the UID exists. Messages sent
+	// directly to a UID are never lost. Can be called from several threads at once
 	void SendMessage( TEntityUID to, const SMessage& msg );
 
 	// Fetch the next available message for the given UID, returns the message through the given 
-	// pointer. Returns false if there are no messages for this UID
+	// pointer. Returns false if there are no messages for this UID. Only one thread at a time may
+	// fetch messages for a given UID
 	bool FetchMessage( TEntityUID to, SMessage* msg );
 
+	// Prepare the mailbox for a new entity with the given UID, team (or any other value if not a
+	// tank) and template name symbol. The team and template decide which group messages the
+	// entity receives, and group messages sent before this call are not received. Call when the
+	// entity is created, before it fetches any messages
+	void OpenMailbox( TEntityUID UID, TUInt32 team, TSymbol templateName );
+
+
+	/////////////////////////////////////
+	// Payloads
+
+	// Allocate a payload of the given size for a message, returning a pointer to write the data
+	// to, or 0 if there is no space. The message is set to use the block. Payloads are held in
+	// an arena that is cleared in two halves, so the data remains available for the frame it is
+	// allocated in and the next one (enough for buffered delivery). Can be called from several
+	// threads at once
+	void* AllocatePayload( SMessage* msg, TUInt32 size );
+
+	// Typed version of the above - the type must be data only
+	template <class T>
+	T* AllocatePayload( SMessage* msg )
+	{
+		return static_cast<T*>(AllocatePayload( msg, sizeof(T) ));
+	}
+
+	// Return a pointer to the payload block of a message, or 0 if the message has no block or the
+	// block has expired. The data is read directly from the arena, it is not copied
+	const void* GetPayload( const SMessage& msg );
+
+	// Typed version of the above
+	template <class T>
+	const T* GetPayload( const SMessage& msg )
+	{
+		return static_cast<const T*>(GetPayload( msg ));
+	}
+
+
+	/////////////////////////////////////
+	// Frames / buffered delivery
+
+	// Start a new frame - call once per frame before updating the entities, when no other thread
+	// is using the messenger. In buffered mode this delivers the messages sent during the last
+	// frame. Also starts the per-frame message counts
+	void BeginFrame();
+
+	// Select buffered mode (see class comment) or immediate delivery. Messages held back when
+	// buffered mode is turned off are delivered immediately
+	void SetBuffered( bool buffered );
+
+	bool IsBuffered()
+	{
+		return m_Buffered;
+	}
+
+
+	/////////////////////////////////////
+	// Group messages
+
+	// Send the given message to all entities, to all tanks on a team, or to all entities of a
+	// template. Membership is checked when each entity fetches its messages, using the team and
+	// template given to OpenMailbox. Returns false if too many group messages are waiting, in
+	// which case the message is lost. Can be called from several threads at once
+	bool SendMessageToAll( const SMessage& msg );
+	bool SendMessageToTeam( TUInt32 team, const SMessage& msg );
+	bool SendMessageToTemplate( TSymbol templateName, const SMessage& msg );
+
+	// Send the given message to each UID in the given list. The list is copied
+	bool SendMessageToList( const TEntityUID* UIDs, TUInt32 numUIDs, const SMessage& msg );
+
+	// Retire group messages that have been available for a whole entity update. Call once per
+	// frame after updating the entities, when no other thread is using the messenger. Group
+	// messages sent before the previous call are retired - so each group message is seen by every
+	// entity update whether sent before or during the update
+	void RetireGroupMessages();
+
+
+	/////////////////////////////////////
+	// Statistics
+
+	// Return the number of group messages lost because too many were waiting
+	TUInt32 GetNumDropped()
+	{
+		return m_NumDropped.load( memory_order_relaxed );
+	}
+
+	// Return the number of messages that have gone to a mailbox's overflow list because the
+	// mailbox was full. If this is often non-zero, MailboxSize is too small
+	TUInt32 GetNumOverflowed()
+	{
+		return m_NumOverflowed.load( memory_order_relaxed );
+	}
+
+	// Return the number of messages sent / received in the last complete frame. A group message
+	// counts as one send, but one receive for each recipient
+	TUInt32 GetNumSentLastFrame()
+	{
+		return m_NumSentLastFrame;
+	}
+	TUInt32 GetNumReceivedLastFrame()
+	{
+		return m_NumReceivedLastFrame;
+	}
+
 
 /////////////////////////////////////
 //	Private interface
 private:
 
-	// A multimap has properties similar to a hash map - mapping a key to a value. Here we
-	// have the key as an entity UID and the value as a message for that UID. The stored
-	// key/value pairs in a multimap are sorted by key, which means all the messages for a
-	// particular UID are together. Key look-up is somewhat slower than for a hash map though
-	// Define some types to make usage easier
-	typedef multimap<TEntityUID, SMessage> TMessages;
-	typedef TMessages::iterator TMessageIter;
-    typedef pair<TEntityUID, SMessage> UIDMsgPair; // The type stored by the multimap
+	/////////////////////////////////////
+	// Types
+
+	// Number of messages each mailbox can hold - must be a power of 2
+	static const TUInt32 MailboxSize = 32;
+
+	// Number of group messages and total number of UIDs in group message lists that can be
+	// waiting at once - must be powers of 2
+	static const TUInt32 MaxGroupMessages = 64;
+	static const TUInt32 MaxGroupUIDs = 4096;
+
+	// Number of messages that can be held back for delivery in each buffer in buffered mode
+	// without a lock. Any more are added to the buffer's overflow list
+	static const TUInt32 MaxPendingMessages = 8192;
+
+	// Size in bytes of each half of the payload arena, and the alignment of payloads in it
+	static const TUInt32 PayloadArenaSize = 65536;
+	static const TUInt32 PayloadAlignment = 16;
+
+	// Mailboxes are allocated in pages of this many - must be a power of 2
+	static const TUInt32 PageSize = 64;
+	static const TUInt32 NumPages = (EntityIndexMask + 1) / PageSize;
+
+	// A message waiting in a mailbox, with the UID it was sent to. The group sequence number is
+	// the sequence number the next group message had when this message was sent, so group
+	// messages sent earlier can be fetched first
+	struct SQueuedMessage
+	{
+		TEntityUID to;
+		TUInt32    groupSeq;
+		SMessage   message;
+	};
+
+	// A place for a message in a mailbox. The sequence number tells senders and the recipient
+	// whether the cell is free or holds a message ready to fetch
+	struct SMailboxCell
+	{
+		atomic<TUInt32> sequence;
+		SQueuedMessage  queued;
+	};
+
+	// A mailbox is a bounded multi-producer single-consumer queue (a ring buffer). Senders
+	// claim a cell by advancing the enqueue position with a compare-and-swap, the recipient owns
+	// the dequeue position
+	//
+	// When the ring is full, messages are added to the overflow list instead, which is protected
+	// by a lock. While the overflow list holds messages, all new messages are added to it too, so
+	// messages are still fetched in the order they were sent. The recipient fetches from the
+	// overflow list once the ring is empty
+	struct SMailbox
+	{
+		SMailbox();
+
+		SMailboxCell    cells[MailboxSize];
+		atomic<TUInt32> enqueuePos;
+		TUInt32         dequeuePos;
+
+		mutex                  overflowLock;
+		vector<SQueuedMessage> overflow;
+		TUInt32                overflowPos;  // Next message to fetch from the overflow list
+		atomic<TUInt32>        numOverflow;  // Number of messages waiting in the overflow list
+
+		// Whether the last message peeked by the recipient came from the overflow list. A sender
+		// may fill the ring between a peek and the following pop, so the pop can't just recheck
+		bool            peekedOverflow;
+
+		// Sequence number of the next group message to check for this mailbox
+		TUInt32         groupCursor;
+
+		// The entity the mailbox was last opened for, and its team and template name symbol. Used
+		// to decide which group messages it receives
+		TEntityUID      owner;
+		TUInt32         team;
+		TSymbol         templateName;
+
+		// Number of messages sent by this mailbox's UID in buffered mode, used to sort messages
+		atomic<TUInt32> sendCount;
+	};
+
+	// A message held back for delivery in buffered mode
+	struct SPendingMessage
+	{
+		TUInt32        sendCount; // Position of this message in the messages sent by its sender
+		SQueuedMessage queued;
+	};
+
+	// Sort order for messages held back in buffered mode - by sender then by send order
+	static bool PendingMessageLess( const SPendingMessage& a, const SPendingMessage& b )
+	{
+		if (a.queued.message.from != b.queued.message.from)
+		{
+			return a.queued.message.from < b.queued.message.from;
+		}
+		return a.sendCount < b.sendCount;
+	}
+
+	// A message sent to a group of entities. For list groups the UIDs are held (sorted) in the
+	// group UID ring. The record is ready once the sequence number equals the group message's
+	// own sequence number
+	struct SGroupMessage
+	{
+		atomic<TUInt32> sequence;
+		EMessageGroup   group;
+		TUInt32         value;     // Team or template name symbol
+		TUInt32         firstUID;  // Position of the first UID in the group UID ring (list groups)
+		TUInt32         numUIDs;
+		SMessage        message;
+	};
+
+	// A page of mailboxes, pages are allocated when first used
+	struct SMailboxPage
+	{
+		SMailbox mailboxes[PageSize];
+	};
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Return the mailbox for the given UID, allocating its page if necessary
+	SMailbox* GetMailbox( TEntityUID to );
+
+	// Add a message to a mailbox, using its overflow list if the mailbox is full
+	void AddToMailbox( SMailbox* mailbox, const SQueuedMessage& queued );
+
+	// Get a copy of the next message waiting in a mailbox without removing it. Returns false if
+	// the mailbox is empty. Only called by the recipient
+	bool PeekMailbox( SMailbox* mailbox, SQueuedMessage* queued );
+
+	// Remove the message returned by the last call to PeekMailbox. Only called by the recipient
+	void PopMailbox( SMailbox* mailbox );
+
+	// Return the position of a new message in the messages sent by the given UID, for sorting in
+	// buffered mode
+	TUInt32 NextSendCount( TEntityUID from );
+
+	// Deliver the messages held back in the given buffer in buffered mode, in sorted order
+	void DeliverPendingMessages( TUInt32 buffer );
+
+	// Add a group message record, for list groups also reserve space for the UIDs. Returns the
+	// record to fill in, or 0 if there is no space. The record must be published with
+	// PublishGroupMessage
+	SGroupMessage* AddGroupMessage( TUInt32 numUIDs, TUInt32* seq );
+
+	// Fill in and publish a group message record added with AddGroupMessage
+	void PublishGroupMessage( SGroupMessage* record, TUInt32 seq, EMessageGroup group,
+	                          TUInt32 value, const SMessage& msg );
+
+	// Fetch the next group message for the given UID from its mailbox, only checking group
+	// messages before the given sequence number. Stops early at a group message that has not
+	// been published yet
+	bool FetchGroupMessage( SMailbox* mailbox, TEntityUID to, TUInt32 end, SMessage* msg );
+
+	// Return true if the given UID, using the given mailbox, is in the group of a group message
+	bool IsInGroup( const SGroupMessage& record, const SMailbox* mailbox, TEntityUID to );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Pages of mailboxes indexed by the slot index in the recipient UID divided by the page size.
+	// Null until a page is first used, pages are added with a compare-and-swap
+	atomic<SMailboxPage*> m_Pages[NumPages];
+
+	// Number of messages lost, and number of messages added to a mailbox's overflow list
+	atomic<TUInt32> m_NumDropped;
+	atomic<TUInt32> m_NumOverflowed;
+
+	// Group messages are held in a ring, addressed by sequence number. Records from the first
+	// to the last sequence number are available, records before the retire mark are retired
+	// on the next call to RetireGroupMessages
+	SGroupMessage   m_GroupMessages[MaxGroupMessages];
+	TUInt32         m_FirstGroupMessage;
+	atomic<TUInt32> m_NextGroupMessage;
+	TUInt32         m_GroupRetireMark;
+
+	// UIDs for list group messages, in a ring in the same way
+	TEntityUID      m_GroupUIDs[MaxGroupUIDs];
+	TUInt32         m_FirstGroupUID;
+	atomic<TUInt32> m_NextGroupUID;
+	TUInt32         m_GroupUIDRetireMark;
+
+	// Group messages from this sequence number on are not visible to recipients yet (buffered
+	// mode only)
+	TUInt32         m_FirstHiddenGroupMessage;
+
+	// Buffered mode and the messages held back for delivery. New messages are added to the send
+	// buffer, the other buffer is the one delivered by BeginFrame. Messages that don't fit in the
+	// fixed array go to the buffer's overflow list, protected by a lock
+	bool                    m_Buffered;
+	SPendingMessage         m_PendingMessages[2][MaxPendingMessages];
+	atomic<TUInt32>         m_NumPendingMessages[2];
+	mutex                   m_PendingOverflowLock;
+	vector<SPendingMessage> m_PendingOverflow[2];
+	TUInt32                 m_SendBuffer;
+
+	// Number of messages sent in buffered mode by SystemUID. Kept here as SystemUID has no mailbox
+	atomic<TUInt32> m_SystemSendCount;
+
+	// Payload arena in two halves, one for this frame and one for the last. The halves are used
+	// alternately, one frame each, and a half is cleared when it is reused
+	GEN_ALIGN(16) TUInt8 m_PayloadArena[2][PayloadArenaSize];
+	atomic<TUInt32>     m_PayloadUsed;
+	TUInt32             m_Frame;
 
-	TMessages m_Messages;
+	// Per-frame message counts
+	atomic<TUInt32> m_NumSent;
+	atomic<TUInt32> m_NumReceived;
+	TUInt32         m_NumSentLastFrame;
+	TUInt32         m_NumReceivedLastFrame;
 };
 
 
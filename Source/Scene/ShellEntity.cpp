@@ -26,8 +26,6 @@ extern TEntityUID GetTankUID( int team, int pos );
 
 extern int GetNumTanksPerTeam();
 
-extern bool PointToSphere(const int radius, const CVector3 currentPos, const CVector3 target);
-extern bool PointToAABB(const int xSize, const int zSize, const CVector3 currentPos, const CVector3 target);
 
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
@@ -39,20 +37,27 @@ extern bool PointToAABB(const int xSize, const int zSize, const CVector3 current
 // class constructor
 CShellEntity::CShellEntity
 (
+	CEntityStorage*  storage,
 	CEntityTemplate* entityTemplate,
 	TEntityUID       UID,
-	const string&    name /*=""*/,
+	TSymbol          name,
 	const TEntityUID parent,
 	const TInt32	 damage,
 	const CVector3&  position /*= CVector3::kOrigin*/, 
 	const CVector3&  rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
-	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
-) : CEntity( entityTemplate, UID, name, position, rotation, scale )
+	const CVector3&  scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/,
+	TUInt32          transforms /*= CEntityStorage::NoTransforms*/
+) : CEntity( storage, entityTemplate, UID, name, position, rotation, scale, transforms )
 {
-	// Initialise any shell data you add
-	m_Timer = 3.0f;
-	m_ParentTank = parent;
-	m_ShellDamage = damage;
+	// Add shell data to the entity storage
+	m_ShellIndex = Storage()->CreateShell( this, &m_ShellIndex, parent, damage, 3.0f,
+	                                       position );
+}
+
+// Destructor removes the shell data from the entity storage
+CShellEntity::~CShellEntity()
+{
+	Storage()->DestroyShell( m_ShellIndex );
 }
 
 
@@ -61,59 +66,22 @@ CShellEntity::CShellEntity
 // Return false if the entity is to be destroyed
 bool CShellEntity::Update( TFloat32 updateTime )
 {
-	m_Timer -= updateTime;
+	TFloat32& timer = Storage()->ShellTimer( m_ShellIndex );
+	timer -= updateTime;
 
-	if (m_Timer < 0.0f)
+	if (timer < 0.0f)
 	{
 		return false;
 	}
 
-	if (PointToAABB(5.0f, 5.0f, Matrix().Position(), CVector3(0.0f, 0.0f, 40.0f))) return false;
-
-	for (int i = 0; i < GetNumTanksPerTeam(); i++)
-	{
-		CEntity* tank = EntityManager.GetEntity(GetTankUID(0, i));
-
-		if (tank)
-		{
-			if (tank->GetUID() != m_ParentTank)
-			{
-				if (PointToSphere(1.0f, Matrix().Position(), tank->Matrix().Position()))
-				{
-					SMessage msg;
-					msg.type = Msg_Hit;
-					msg.from = GetUID();
-					msg.data = m_ShellDamage;
-					Messenger.SendMessageA(tank->GetUID(), msg);
-					return false;
-				}
-			}
-		}
-	}
-
-	for (int i = 0; i < GetNumTanksPerTeam(); i++)
-	{
-		CEntity* tank = EntityManager.GetEntity(GetTankUID(1, i));
-
-		if (tank)
-		{
-			if (tank && tank->GetUID() != m_ParentTank)
-			{
-				if (PointToSphere(1.0f, Matrix().Position(), tank->Matrix().Position()))
-				{
-					SMessage msg;
-					msg.type = Msg_Hit;
-					msg.from = GetUID();
-					msg.data = m_ShellDamage;
-					Messenger.SendMessageA(tank->GetUID(), msg);
-					return false;
-				}
-			}
-		}
-	}
+	// Move the shell, keeping its previous position. The entity manager tests the path it moved
+	// along this frame, for all shells together, once they have all been updated. Testing the
+	// path rather than just the new position stops shells passing straight through tanks at low
+	// frame rates or high time scales
+	Storage()->ShellPrevPosition( m_ShellIndex ) = Position();
+	MoveLocalZ(100.0f * updateTime);
 
-	Matrix().MoveLocalZ(100.0f * updateTime);
-	return true; // Placeholder
+	return true;
 }
 
 
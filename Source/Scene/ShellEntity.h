@@ -27,7 +27,8 @@ namespace gen
 
 // A shell entity inherits the ID/positioning/rendering support of the base entity class
 // and adds instance and state data. It overrides the update function to perform the shell
-// entity behaviour
+// entity behaviour. The shell data (timer, damage and parent tank) is held in the entity storage
+// rather than in the shell entity itself
 // The shell code contains no behaviour and must be rewritten as one of the assignment
 // requirements. You may wish to alter other parts of the class to suit your game additions
 // E.g extra member variables, constructor parameters, getters etc.
@@ -37,20 +38,23 @@ class CShellEntity : public CEntity
 //	Constructors/Destructors
 public:
 	// Shell constructor intialises shell-specific data and passes its parameters to the base
-	// class constructor
+	// class constructor. A reserved transform block may be passed, see CEntity
 	CShellEntity
 	(
+		CEntityStorage*  storage,
 		CEntityTemplate* entityTemplate,
 		TEntityUID       UID,
-		const string&    name /*= ""*/,
+		TSymbol          name,
 		const TEntityUID parent,
 		const TInt32	 damage,
 		const CVector3&  position = CVector3::kOrigin, 
 		const CVector3&  rotation = CVector3( 0.0f, 0.0f, 0.0f ),
-		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f )
+		const CVector3&  scale = CVector3( 1.0f, 1.0f, 1.0f ),
+		TUInt32          transforms = CEntityStorage::NoTransforms
 	);
 
-	// No destructor needed
+	// Destructor removes the shell data from the entity storage
+	virtual ~CShellEntity();
 
 
 /////////////////////////////////////
@@ -72,9 +76,9 @@ private:
 
 	/////////////////////////////////////
 	// Data
-	TEntityUID m_ParentTank;
-	TInt32 m_ShellDamage;
-	float m_Timer;
+
+	// Index of this shell's data (timer, damage and parent tank) in the entity storage
+	TUInt32 m_ShellIndex;
 	// Add your shell data here
 };
 
@@ -0,0 +1,109 @@
+/*******************************************
+	ShellPool.cpp
+
+	Fixed-capacity pool of shell entities
+********************************************/
+
+#include <new>
+using namespace std;
+
+#include "ShellPool.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor allocates memory for the given number of shells of the given template and
+// reserves the matrices and shell data they will use in the entity storage
+CShellPool::CShellPool( CEntityStorage* storage, CEntityTemplate* shellTemplate, TUInt32 capacity )
+{
+	m_Storage = storage;
+	m_Template = shellTemplate;
+	m_Capacity = capacity;
+
+	// Allocate raw memory for the shells - they are constructed when they are fired
+	m_Memory = new TUInt8[m_Capacity * sizeof(CShellEntity)];
+
+	// All places are initially free, push them in reverse so the first shells use the start of
+	// the memory
+	m_FreePlaces.reserve( m_Capacity );
+	for (TUInt32 place = m_Capacity; place > 0; --place)
+	{
+		m_FreePlaces.push_back( place - 1 );
+	}
+
+	// Allocate the matrices and shell data the shells will use, so firing a shell does not resize
+	// the arrays in the entity storage. Each place uses its own transform block
+	m_NumNodes = m_Template->Mesh()->GetNumNodes();
+	m_Transforms = m_Storage->ReserveTransforms( m_NumNodes, m_Capacity );
+	m_Storage->ReserveShells( m_Capacity );
+
+	m_HighWaterMark = 0;
+	m_NumOverflows = 0;
+}
+
+// Destructor frees the pool memory and returns the reserved matrices to the entity storage -
+// all shells must have been destroyed first
+CShellPool::~CShellPool()
+{
+	m_Storage->ReleaseTransforms( m_Transforms, m_NumNodes, m_Capacity );
+	delete[] m_Memory;
+}
+
+
+/////////////////////////////////////
+// Shell creation / destruction
+
+// Construct a shell in a free place in the pool, parameters are as for the CShellEntity
+// constructor. Returns 0 if the pool is full
+CShellEntity* CShellPool::Create
+(
+	TEntityUID       UID,
+	TSymbol          name,
+	const TEntityUID parent,
+	const TInt32     damage,
+	const CVector3&  position,
+	const CVector3&  rotation,
+	const CVector3&  scale
+)
+{
+	if (m_FreePlaces.empty())
+	{
+		++m_NumOverflows;
+		return 0;
+	}
+
+	// Take a free place and construct the shell in it (placement new), using the place's
+	// transform block
+	TUInt32 place = m_FreePlaces.back();
+	m_FreePlaces.pop_back();
+	void* address = m_Memory + place * sizeof(CShellEntity);
+	CShellEntity* shell = new (address) CShellEntity( m_Storage, m_Template, UID, name, parent,
+	                                                  damage, position, rotation, scale,
+	                                                  m_Transforms + place * m_NumNodes );
+
+	// Update statistics
+	if (GetNumInUse() > m_HighWaterMark)
+	{
+		m_HighWaterMark = GetNumInUse();
+	}
+
+	return shell;
+}
+
+// Destroy a shell previously created by this pool and recycle its place
+void CShellPool::Destroy( CEntity* shell )
+{
+	// Find place from address before destroying the shell
+	TUInt32 place = static_cast<TUInt32>((reinterpret_cast<TUInt8*>(shell) - m_Memory) /
+	                                     sizeof(CShellEntity));
+
+	// Call destructor directly as memory was not allocated with new
+	shell->~CEntity();
+	m_FreePlaces.push_back( place );
+}
+
+
+} // namespace gen
@@ -0,0 +1,137 @@
+/*******************************************
+	ShellPool.h
+
+	Fixed-capacity pool of shell entities
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "Entity.h"
+#include "ShellEntity.h"
+
+namespace gen
+{
+
+// A shell pool holds memory for a fixed number of shell entities of a single template. Shells
+// are short-lived and fired at a high rate, so rather than using new and delete for each one,
+// shells are constructed in free places in the pool and the places are recycled when they are
+// destroyed. The pool also reserves a block of matrices in the entity storage for each place up
+// front - these blocks belong to the pool, so other entities can't use them
+//
+// The pool keeps usage statistics - the high-water mark (the most shells in use at once) can be
+// used to choose a suitable capacity. If the pool is full, no shell is created and the overflow
+// is counted - the caller should fall back to normal allocation
+class CShellPool
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor allocates memory for the given number of shells of the given template and
+	// reserves the matrices and shell data they will use in the entity storage
+	CShellPool( CEntityStorage* storage, CEntityTemplate* shellTemplate, TUInt32 capacity );
+
+	// Destructor frees the pool memory and returns the reserved matrices to the entity storage -
+	// all shells must have been destroyed first
+	~CShellPool();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CShellPool( const CShellPool& );
+	CShellPool& operator=( const CShellPool& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Shell creation / destruction
+
+	// Construct a shell in a free place in the pool, parameters are as for the CShellEntity
+	// constructor. Returns 0 if the pool is full
+	CShellEntity* Create
+	(
+		TEntityUID       UID,
+		TSymbol          name,
+		const TEntityUID parent,
+		const TInt32     damage,
+		const CVector3&  position,
+		const CVector3&  rotation,
+		const CVector3&  scale
+	);
+
+	// Destroy a shell previously created by this pool and recycle its place
+	void Destroy( CEntity* shell );
+
+	// Return true if the given entity was created by this pool
+	bool Owns( CEntity* entity )
+	{
+		TUInt8* address = reinterpret_cast<TUInt8*>(entity);
+		return address >= m_Memory && address < m_Memory + m_Capacity * sizeof(CShellEntity);
+	}
+
+
+	/////////////////////////////////////
+	// Getters
+
+	CEntityTemplate* GetTemplate()
+	{
+		return m_Template;
+	}
+
+	TUInt32 GetCapacity()
+	{
+		return m_Capacity;
+	}
+
+	// Number of shells currently in use
+	TUInt32 GetNumInUse()
+	{
+		return m_Capacity - static_cast<TUInt32>(m_FreePlaces.size());
+	}
+
+	// Largest number of shells that have been in use at once
+	TUInt32 GetHighWaterMark()
+	{
+		return m_HighWaterMark;
+	}
+
+	// Number of times a shell was requested when the pool was full
+	TUInt32 GetNumOverflows()
+	{
+		return m_NumOverflows;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Storage and template for the shells in this pool
+	CEntityStorage*  m_Storage;
+	CEntityTemplate* m_Template;
+
+	// Raw memory for the shells, shells are constructed in place in this memory
+	TUInt8*          m_Memory; // Dynamically allocated array
+	TUInt32          m_Capacity;
+
+	// Transform blocks reserved in the entity storage, one per place in the pool in place order
+	TUInt32          m_Transforms;
+	TUInt32          m_NumNodes;
+
+	// Indexes of unused places in the pool, used as a stack so recently freed (cache-warm)
+	// places are reused first
+	vector<TUInt32>  m_FreePlaces;
+
+	// Usage statistics
+	TUInt32          m_HighWaterMark;
+	TUInt32          m_NumOverflows;
+};
+
+
+} // namespace gen
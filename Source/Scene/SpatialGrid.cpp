@@ -0,0 +1,336 @@
+/*******************************************
+	SpatialGrid.cpp
+
+	Uniform grid over the XZ plane for
+	finding entities near a point
+********************************************/
+
+#include <algorithm>
+using namespace std;
+
+#include "SpatialGrid.h"
+#include "BaseMath.h"
+#include "Error.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Constructors/Destructors
+
+// Constructor takes the width of the grid cells
+CSpatialGrid::CSpatialGrid( TFloat32 cellSize ) :
+	m_Cells( 256, CHashPolicy<TUInt32>(), 0.7f, kFlatStorage )
+{
+	GEN_GUARD;
+
+	GEN_ASSERT( cellSize > 0.0f, "Invalid grid cell size" );
+	m_CellSize = cellSize;
+	m_InvCellSize = 1.0f / cellSize;
+
+	m_FreeEntry = NoEntry;
+	m_NumEntities = 0;
+
+	GEN_ENDGUARD;
+}
+
+
+/////////////////////////////////////
+// Entities
+
+// Add an entity at the given position to the grid, returns the entity's entry
+TUInt32 CSpatialGrid::Insert( TEntityUID UID, const CVector3& position )
+{
+	// Reuse a free entry if there is one
+	TUInt32 entry;
+	if (m_FreeEntry != NoEntry)
+	{
+		entry = m_FreeEntry;
+		m_FreeEntry = m_Entries[entry].next;
+	}
+	else
+	{
+		entry = static_cast<TUInt32>(m_Entries.size());
+		m_Entries.push_back( SGridEntry() );
+	}
+
+	SGridEntry& gridEntry = m_Entries[entry];
+	gridEntry.UID = UID;
+	gridEntry.x = position.x;
+	gridEntry.z = position.z;
+	gridEntry.cell = CellKey( CellCoord( position.x ), CellCoord( position.z ) );
+	LinkEntry( entry );
+
+	++m_NumEntities;
+	return entry;
+}
+
+// Update the position of the entity with the given entry. The entity only changes list if it has
+// moved into a different cell
+void CSpatialGrid::Move( TUInt32 entry, const CVector3& position )
+{
+	SGridEntry& gridEntry = m_Entries[entry];
+	gridEntry.x = position.x;
+	gridEntry.z = position.z;
+
+	TUInt32 cell = CellKey( CellCoord( position.x ), CellCoord( position.z ) );
+	if (cell != gridEntry.cell)
+	{
+		UnlinkEntry( entry );
+		gridEntry.cell = cell;
+		LinkEntry( entry );
+	}
+}
+
+// Remove the entity with the given entry from the grid
+void CSpatialGrid::Remove( TUInt32 entry )
+{
+	UnlinkEntry( entry );
+
+	// Add entry to the free list
+	m_Entries[entry].UID = NullUID;
+	m_Entries[entry].next = m_FreeEntry;
+	m_FreeEntry = entry;
+
+	--m_NumEntities;
+}
+
+// Remove all entities from the grid
+void CSpatialGrid::Clear()
+{
+	m_Entries.clear();
+	m_Cells.RemoveAllKeys();
+	m_FreeEntry = NoEntry;
+	m_NumEntities = 0;
+}
+
+
+/////////////////////////////////////
+// Queries
+
+// Find the entities within the given distance of a point in the XZ plane. Returns the number
+// found, up to the given maximum are written to the results array
+TUInt32 CSpatialGrid::Query( const CVector3& centre, TFloat32 radius, TEntityUID* results,
+                             TUInt32 maxResults )
+{
+	TFloat32 radiusSquared = radius * radius;
+	TUInt32 numFound = 0;
+
+	// A search too wide for the cell keys tests every entity instead
+	if (IsAreaTooWide( centre.x - radius, centre.x + radius, centre.z - radius, centre.z + radius ))
+	{
+		for (TUInt32 entry = 0; entry < m_Entries.size(); ++entry)
+		{
+			const SGridEntry& gridEntry = m_Entries[entry];
+			TFloat32 dx = gridEntry.x - centre.x;
+			TFloat32 dz = gridEntry.z - centre.z;
+			if (gridEntry.UID != NullUID && dx * dx + dz * dz <= radiusSquared)
+			{
+				if (numFound < maxResults)
+				{
+					results[numFound] = gridEntry.UID;
+				}
+				++numFound;
+			}
+		}
+		return numFound;
+	}
+
+	// Range of cells overlapping the square around the search circle
+	TInt32 minCellX = CellCoord( centre.x - radius );
+	TInt32 maxCellX = CellCoord( centre.x + radius );
+	TInt32 minCellZ = CellCoord( centre.z - radius );
+	TInt32 maxCellZ = CellCoord( centre.z + radius );
+
+	for (TInt32 cellZ = minCellZ; cellZ <= maxCellZ; ++cellZ)
+	{
+		for (TInt32 cellX = minCellX; cellX <= maxCellX; ++cellX)
+		{
+			TUInt32 entry;
+			if (!m_Cells.LookUpKey( CellKey( cellX, cellZ ), &entry ))
+			{
+				continue;
+			}
+
+			// Test the distance to each entity in the cell, the cell may contain entities that are
+			// outside the circle
+			while (entry != NoEntry)
+			{
+				const SGridEntry& gridEntry = m_Entries[entry];
+				TFloat32 dx = gridEntry.x - centre.x;
+				TFloat32 dz = gridEntry.z - centre.z;
+				if (dx * dx + dz * dz <= radiusSquared)
+				{
+					if (numFound < maxResults)
+					{
+						results[numFound] = gridEntry.UID;
+					}
+					++numFound;
+				}
+				entry = gridEntry.next;
+			}
+		}
+	}
+	return numFound;
+}
+
+// Find the entities within the given distance of a line segment in the XZ plane. The results
+// vector is cleared, then all the UIDs found are added
+void CSpatialGrid::QuerySegment( const CVector3& start, const CVector3& end, TFloat32 radius,
+                                 vector<TEntityUID>& results )
+{
+	results.clear();
+
+	TFloat32 minX = Min( start.x, end.x ) - radius;
+	TFloat32 maxX = Max( start.x, end.x ) + radius;
+	TFloat32 minZ = Min( start.z, end.z ) - radius;
+	TFloat32 maxZ = Max( start.z, end.z ) + radius;
+
+	// A search too wide for the cell keys tests every entity instead
+	TFloat32 radiusSquared = radius * radius;
+	if (IsAreaTooWide( minX, maxX, minZ, maxZ ))
+	{
+		for (TUInt32 entry = 0; entry < m_Entries.size(); ++entry)
+		{
+			const SGridEntry& gridEntry = m_Entries[entry];
+			if (gridEntry.UID != NullUID &&
+			    SegmentDistanceSquared( gridEntry, start, end ) <= radiusSquared)
+			{
+				results.push_back( gridEntry.UID );
+			}
+		}
+		return;
+	}
+
+	// Step through the columns of cells the search covers. An entity in a column is within the
+	// radius of the segment only if the part of the segment within the radius of the column
+	// comes within the radius of it, so only the cells around that part need to be visited.
+	// Each cell is visited once, so no entity is found twice
+	TFloat32 dx = end.x - start.x;
+	TFloat32 dz = end.z - start.z;
+	TInt32 minCellX = CellCoord( minX );
+	TInt32 maxCellX = CellCoord( maxX );
+	for (TInt32 cellX = minCellX; cellX <= maxCellX; ++cellX)
+	{
+		// Range of Z covered by the part of the segment within the radius of the column
+		TFloat32 columnMinZ = minZ;
+		TFloat32 columnMaxZ = maxZ;
+		if (dx != 0.0f)
+		{
+			TFloat32 t0 = (static_cast<TFloat32>(cellX) * m_CellSize - radius - start.x) / dx;
+			TFloat32 t1 = (static_cast<TFloat32>(cellX + 1) * m_CellSize + radius - start.x) / dx;
+			if (t0 > t1)
+			{
+				swap( t0, t1 );
+			}
+			t0 = Max( t0, 0.0f );
+			t1 = Min( t1, 1.0f );
+			if (t0 > t1)
+			{
+				continue;
+			}
+			TFloat32 z0 = start.z + t0 * dz;
+			TFloat32 z1 = start.z + t1 * dz;
+			columnMinZ = Min( z0, z1 ) - radius;
+			columnMaxZ = Max( z0, z1 ) + radius;
+		}
+
+		TInt32 maxCellZ = CellCoord( columnMaxZ );
+		for (TInt32 cellZ = CellCoord( columnMinZ ); cellZ <= maxCellZ; ++cellZ)
+		{
+			QuerySegmentCell( CellKey( cellX, cellZ ), start, end, radius, results );
+		}
+	}
+}
+
+
+/////////////////////////////////////
+// Support functions
+
+// Add an entry to the front of the list for its cell
+void CSpatialGrid::LinkEntry( TUInt32 entry )
+{
+	SGridEntry& gridEntry = m_Entries[entry];
+	gridEntry.prev = NoEntry;
+
+	TUInt32 first;
+	if (m_Cells.LookUpKey( gridEntry.cell, &first ))
+	{
+		m_Entries[first].prev = entry;
+		gridEntry.next = first;
+	}
+	else
+	{
+		gridEntry.next = NoEntry;
+	}
+	m_Cells.SetKeyValue( gridEntry.cell, entry );
+}
+
+// Remove an entry from the list for its cell. The cell is removed from the cell table when its
+// last entry is removed
+void CSpatialGrid::UnlinkEntry( TUInt32 entry )
+{
+	SGridEntry& gridEntry = m_Entries[entry];
+	if (gridEntry.next != NoEntry)
+	{
+		m_Entries[gridEntry.next].prev = gridEntry.prev;
+	}
+
+	if (gridEntry.prev != NoEntry)
+	{
+		m_Entries[gridEntry.prev].next = gridEntry.next;
+	}
+	else if (gridEntry.next != NoEntry)
+	{
+		m_Cells.SetKeyValue( gridEntry.cell, gridEntry.next );
+	}
+	else
+	{
+		m_Cells.RemoveKey( gridEntry.cell );
+	}
+}
+
+// Add the entities in the given cell within the given distance of a segment to the results
+void CSpatialGrid::QuerySegmentCell( TUInt32 cell, const CVector3& start, const CVector3& end,
+                                     TFloat32 radius, vector<TEntityUID>& results )
+{
+	TUInt32 entry;
+	if (!m_Cells.LookUpKey( cell, &entry ))
+	{
+		return;
+	}
+
+	TFloat32 radiusSquared = radius * radius;
+	while (entry != NoEntry)
+	{
+		const SGridEntry& gridEntry = m_Entries[entry];
+		if (SegmentDistanceSquared( gridEntry, start, end ) <= radiusSquared)
+		{
+			results.push_back( gridEntry.UID );
+		}
+		entry = gridEntry.next;
+	}
+}
+
+// Return the squared distance in the XZ plane from an entry to a segment
+TFloat32 CSpatialGrid::SegmentDistanceSquared( const SGridEntry& gridEntry,
+                                               const CVector3& start, const CVector3& end )
+{
+	// Find the nearest point on the segment, as a fraction along it
+	TFloat32 dx = end.x - start.x;
+	TFloat32 dz = end.z - start.z;
+	TFloat32 lengthSquared = dx * dx + dz * dz;
+	TFloat32 t = 0.0f;
+	if (lengthSquared > 0.0f)
+	{
+		t = ((gridEntry.x - start.x) * dx + (gridEntry.z - start.z) * dz) / lengthSquared;
+		t = Min( Max( t, 0.0f ), 1.0f );
+	}
+
+	TFloat32 offsetX = gridEntry.x - (start.x + t * dx);
+	TFloat32 offsetZ = gridEntry.z - (start.z + t * dz);
+	return offsetX * offsetX + offsetZ * offsetZ;
+}
+
+
+} // namespace gen
@@ -0,0 +1,174 @@
+/*******************************************
+	SpatialGrid.h
+
+	Uniform grid over the XZ plane for
+	finding entities near a point
+********************************************/
+
+#pragma once
+
+#include <math.h>
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CHashTable.h"
+#include "EntityHandle.h"
+
+namespace gen
+{
+
+// The spatial grid divides the XZ plane into square cells and keeps a list of the entities in
+// each cell. To find the entities near a point, only the cells overlapping the search area are
+// visited, so the cost depends on the number of entities nearby rather than the total number.
+// The grid is unbounded - only cells that contain entities are stored, in a hash table keyed on
+// the cell coordinates
+//
+// Each entity added to the grid is given an entry, whose index is returned to the caller. The
+// caller keeps this index (e.g. in the entity's slot) and passes it to Move and Remove, so no
+// search is needed to find an entity's entry. Entities must be moved in the grid whenever they
+// move in the world, but an entity is only relinked when it crosses into a different cell
+class CSpatialGrid
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+
+	// Constructor takes the width of the grid cells. Choose a cell size a little larger than the
+	// usual search radius, then most searches visit only a few cells
+	CSpatialGrid( TFloat32 cellSize );
+
+	// No destructor needed
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CSpatialGrid( const CSpatialGrid& );
+	CSpatialGrid& operator=( const CSpatialGrid& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Marks an entity that is not in the grid
+	static const TUInt32 NoEntry = 0xffffffff;
+
+
+	// Add an entity at the given position to the grid (only X and Z are used). Returns the
+	// entity's entry, pass it to Move and Remove
+	TUInt32 Insert( TEntityUID UID, const CVector3& position );
+
+	// Update the position of the entity with the given entry
+	void Move( TUInt32 entry, const CVector3& position );
+
+	// Remove the entity with the given entry from the grid, the entry may be reused by a later
+	// Insert
+	void Remove( TUInt32 entry );
+
+	// Remove all entities from the grid
+	void Clear();
+
+
+	// Find the entities within the given distance of a point in the XZ plane. The UIDs found are
+	// written to the given array, up to the given maximum. Returns the number of entities found,
+	// which may be more than the maximum (only the first maximum are written)
+	TUInt32 Query( const CVector3& centre, TFloat32 radius, TEntityUID* results,
+	               TUInt32 maxResults );
+
+	// Find the entities within the given distance of the line segment from start to end in the
+	// XZ plane. Only the cells along the segment are visited, column by column, rather than all
+	// the cells in the square around it. The results vector is cleared, then all the UIDs found
+	// are added to it
+	void QuerySegment( const CVector3& start, const CVector3& end, TFloat32 radius,
+	                   vector<TEntityUID>& results );
+
+	// Return the number of entities in the grid
+	TUInt32 NumEntities()
+	{
+		return m_NumEntities;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// An entity in the grid. Entries in the same cell are linked in a list, the first entry in
+	// each cell's list is held in the cell table. Unused entries are linked in a free list
+	struct SGridEntry
+	{
+		TEntityUID UID;   // NullUID for unused entries
+		TFloat32   x, z;  // Position in the XZ plane
+		TUInt32    cell;  // Key of the cell containing the entity
+		TUInt32    next;  // Next entry in the cell's list (or free list), NoEntry at the end
+		TUInt32    prev;  // Previous entry in the cell's list, NoEntry at the start
+	};
+
+	// Map from cell key to the first entry in the cell. Cell keys are small integers, so use the
+	// inline integer hash with flat storage
+	typedef CHashTable<TUInt32, TUInt32, CHashPolicy<TUInt32> > TCellTable;
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Return the cell coordinate containing the given X or Z coordinate
+	TInt32 CellCoord( TFloat32 coord )
+	{
+		return static_cast<TInt32>(floorf( coord * m_InvCellSize ));
+	}
+
+	// Return the key of the cell with the given coordinates. The coordinates wrap around every
+	// 65536 cells, which only means distant cells can share a list
+	static TUInt32 CellKey( TInt32 cellX, TInt32 cellZ )
+	{
+		return (static_cast<TUInt32>(cellX) & 0xffff) | (static_cast<TUInt32>(cellZ) << 16);
+	}
+
+	// Return true if a search of the given area would visit cells that wrap around to the same
+	// key, so would find the same entities twice. Such searches test every entity instead
+	bool IsAreaTooWide( TFloat32 minX, TFloat32 maxX, TFloat32 minZ, TFloat32 maxZ )
+	{
+		const TFloat32 MaxCells = 65535.0f;
+		return (maxX - minX) * m_InvCellSize >= MaxCells || (maxZ - minZ) * m_InvCellSize >= MaxCells;
+	}
+
+	// Add an entry to the front of the list for its cell
+	void LinkEntry( TUInt32 entry );
+
+	// Remove an entry from the list for its cell
+	void UnlinkEntry( TUInt32 entry );
+
+	// Add the entities in the given cell within the given distance of the segment from start to
+	// end (in the XZ plane) to the results
+	void QuerySegmentCell( TUInt32 cell, const CVector3& start, const CVector3& end,
+	                       TFloat32 radius, vector<TEntityUID>& results );
+
+	// Return the squared distance in the XZ plane from the given entry to the segment from start
+	// to end
+	TFloat32 SegmentDistanceSquared( const SGridEntry& gridEntry, const CVector3& start,
+	                                 const CVector3& end );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Width of a cell, and its reciprocal
+	TFloat32 m_CellSize;
+	TFloat32 m_InvCellSize;
+
+	// Grid entries, unused entries are linked from m_FreeEntry
+	vector<SGridEntry> m_Entries;
+	TUInt32            m_FreeEntry;
+	TUInt32            m_NumEntities;
+
+	// First entry in each non-empty cell
+	TCellTable m_Cells;
+};
+
+
+} // namespace gen
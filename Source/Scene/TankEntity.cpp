@@ -44,8 +44,8 @@ extern CMessenger Messenger;
 
 extern int NumTanksPerTeam = 3;
 extern int NumPoints = 7;
-extern CVector3 FrontPatrolPoints[];
-extern CVector3 BackPatrolPoints[];
+extern const CVector3 FrontPatrolPoints[];
+extern const CVector3 BackPatrolPoints[];
 
 // Helper function made available from TankAssignment.cpp - gets UID of tank A (team 0) or B (team 1).
 // Will be needed to implement the required tank behaviour in the Update function below
@@ -53,8 +53,6 @@ extern TEntityUID GetTankUID( int team, int pos );
 
 extern bool PointToSphere(const int radius, const CVector3 currentPos, const CVector3 target);
 
-extern bool PointToAABB(const int xSize, const int zSize, const CVector3 currentPos, const CVector3 target);
-
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
 	Tank Entity Class
@@ -65,31 +63,41 @@ extern bool PointToAABB(const int xSize, const int zSize, const CVector3 current
 // class constructor
 CTankEntity::CTankEntity
 (
+	CEntityStorage* storage,
 	CTankTemplate*  tankTemplate,
 	TEntityUID      UID,
 	TUInt32         team,
-	const string&   name /*=""*/,
+	TSymbol         name /*= NullSymbol*/,
 	const CVector3& position /*= CVector3::kOrigin*/, 
 	const CVector3& rotation /*= CVector3( 0.0f, 0.0f, 0.0f )*/,
 	const CVector3& scale /*= CVector3( 1.0f, 1.0f, 1.0f )*/
-) : CEntity( tankTemplate, UID, name, position, rotation, scale )
+) : CEntity( storage, tankTemplate, UID, name, position, rotation, scale )
 {
 	m_TankTemplate = tankTemplate;
+	m_ShellTemplate = InternName( "Shell Type 1" );
+	m_ShellName = InternName( "Name" );
 
 	// Tanks are on teams so they know who the enemy is
 	m_Team = team;
 
+	// Add tank data to the entity storage - initially no speed, inactive state and zero timer
+	m_TankIndex = Storage()->CreateTank( this, &m_TankIndex, m_TankTemplate->GetMaxHP() );
+	SetState( Inactive );
+
 	// Initialise other tank data and state
-	m_Speed = 0.0f;
-	m_HP = m_TankTemplate->GetMaxHP();
-	m_State = Inactive;
 	m_PatrolPointCounter = 0;
+	m_TargetTank = NullUID;
 	if (m_Team == 0) { m_PatrolType = Front; m_TargetPoint = FrontPatrolPoints[0]; }
 	else { m_PatrolType = Back; m_TargetPoint = BackPatrolPoints[0];  }
-	m_Timer = 0.0f;
 	m_ShellsFired = 0;
 }
 
+// Destructor removes the tank data from the entity storage
+CTankEntity::~CTankEntity()
+{
+	Storage()->DestroyTank( m_TankIndex );
+}
+
 
 // Update the tank - controls its behaviour. The shell code just performs some test behaviour, it
 // is to be rewritten as one of the assignment requirements
@@ -104,14 +112,14 @@ bool CTankEntity::Update( TFloat32 updateTime )
 		switch (msg.type)
 		{
 			case Msg_Go:
-				m_State = Patrol;
+				SetState(Patrol);
 				break;
 			case Msg_Stop:
-				m_State = Inactive;
+				SetState(Inactive);
 				break;
 			case Msg_Hit:
-				m_HP -= msg.data;
-				if (m_HP <= 0)
+				HP() -= msg.hit.damage;
+				if (HP() <= 0)
 				{ 
 					return false;
 				}
@@ -121,125 +129,126 @@ bool CTankEntity::Update( TFloat32 updateTime )
 
 	// Tank behaviour
 	// Only move if in Go state
-	if (m_State == Patrol)
+	if (GetState() == Patrol)
 	{
 		if (TankInTurretRange())
 		{
-			m_Speed = 0.0f;
-			m_Timer = 1.0f;
-			m_State = Aim;
+			Speed() = 0.0f;
+			Timer() = 1.0f;
+			SetState(Aim);
 		}
 
-		if (PointToSphere(5.0f, Matrix().Position(), m_TargetPoint)) { ChangePatrolPoint(); }
+		if (PointToSphere(5.0f, Position(), m_TargetPoint)) { ChangePatrolPoint(); }
 
 		if (GetTurnAmount(m_TargetPoint, Matrix()) > 0.1)
 		{
-			Matrix().RotateLocalY(m_TankTemplate->GetTurnSpeed() * updateTime);
+			RotateLocalY(m_TankTemplate->GetTurnSpeed() * updateTime);
 		}
 		else if (GetTurnAmount(m_TargetPoint, Matrix()) < -0.1)
 		{
-			Matrix().RotateLocalY(-m_TankTemplate->GetTurnSpeed() * updateTime);
+			RotateLocalY(-m_TankTemplate->GetTurnSpeed() * updateTime);
 		}
 
-		Matrix(2).RotateLocalY(m_TankTemplate->GetTurretTurnSpeed() * updateTime);
-		if (m_Speed < m_TankTemplate->GetMaxSpeed())
+		RotateLocalY(m_TankTemplate->GetTurretTurnSpeed() * updateTime, 2);
+		if (Speed() < m_TankTemplate->GetMaxSpeed())
 		{
-			m_Speed += m_TankTemplate->GetAcceleration() * updateTime;
+			Speed() += m_TankTemplate->GetAcceleration() * updateTime;
 		}
 		else
 		{
-			m_Speed = m_TankTemplate->GetMaxSpeed();
+			Speed() = m_TankTemplate->GetMaxSpeed();
 		}
 	}
-	else if (m_State == Aim)
+	else if (GetState() == Aim)
 	{
-		m_Timer -= updateTime;
+		Timer() -= updateTime;
 
-		if (m_TargetTank)
+		CEntity* targetEntity = EntityManager.GetEntity(m_TargetTank);
+		if (targetEntity)
 		{
-			const CVector3 targetTank = m_TargetTank->Position();
+			const CVector3 targetTank = targetEntity->Position();
 
 			if (GetTurnAmount(targetTank, (Matrix(2) * Matrix())) > 0)
 			{
-				Matrix(2).RotateLocalY(m_TankTemplate->GetTurretTurnSpeed() * 1.5f * updateTime);
+				RotateLocalY(m_TankTemplate->GetTurretTurnSpeed() * 1.5f * updateTime, 2);
 			}
 			else
 			{
-				Matrix(2).RotateLocalY(-m_TankTemplate->GetTurretTurnSpeed() * 1.5f * updateTime);
+				RotateLocalY(-m_TankTemplate->GetTurretTurnSpeed() * 1.5f * updateTime, 2);
 			}
 
-			if (m_Timer < 0.0f)
+			if (Timer() < 0.0f)
 			{
 				CVector3 position;
 				CVector3 rotation;
 				CVector3 scale;
 				(Matrix(2) * Matrix()).DecomposeAffineEuler(&position, &rotation, &scale);
-				EntityManager.CreateShell("Shell Type 1", "Name", GetUID(), m_TankTemplate->GetShellDamage(), position, rotation, scale);
+				EntityManager.CreateShell(m_ShellTemplate, m_ShellName, GetUID(), m_TankTemplate->GetShellDamage(), position, rotation, scale);
 				m_ShellsFired += 1;
 				m_TargetPoint.x = Random(Matrix().GetX() - 40.0f, Matrix().GetX() + 40.0f);
 				m_TargetPoint.z = Random(Matrix().GetZ() - 40.0f, Matrix().GetZ() + 40.0f);
-				m_State = Evade;
+				SetState(Evade);
 			}
 		}
-	}
-	else if (m_State == Evade)
-	{
-		float turretTargetDir = 0.0f;
-		const CVector3 turretXAxis = Normalise((Matrix(2) * Matrix()).XAxis());
-		const CVector3 turretZAxis = Normalise((Matrix(2) * Matrix()).ZAxis());
-		const CVector3 turretTarget = Normalise(Matrix().ZAxis());
-
-		if (Dot(turretXAxis, turretTarget) > 0)
-		{
-			turretTargetDir = ACos(Dot(turretZAxis, turretTarget));
-		}
 		else
 		{
-			turretTargetDir = -ACos(Dot(turretZAxis, turretTarget));
+			// Target has been destroyed, go back to patrolling
+			SetState(Patrol);
 		}
+	}
+	else if (GetState() == Evade)
+	{
+		// Turn the turret to face the tank's forward direction - the turn towards a point ahead
+		// of the turret along the tank's Z axis
+		const CMatrix4x4 turretMatrix = Matrix(2) * Matrix();
+		float turretTargetDir = GetTurnAmount(turretMatrix.Position() + Matrix().ZAxis(), turretMatrix);
 
 		if (turretTargetDir > 0.01)
 		{
-			Matrix(2).RotateLocalY(m_TankTemplate->GetTurnSpeed() * 1.5f * updateTime);
+			RotateLocalY(m_TankTemplate->GetTurnSpeed() * 1.5f * updateTime, 2);
 		}
 		else if (turretTargetDir < -0.01)
 		{
-			Matrix(2).RotateLocalY(-m_TankTemplate->GetTurnSpeed() * 1.5f * updateTime);
+			RotateLocalY(-m_TankTemplate->GetTurnSpeed() * 1.5f * updateTime, 2);
 		}
 
 		if (GetTurnAmount(m_TargetPoint, Matrix()) > 0.1)
 		{
-			Matrix().RotateLocalY(m_TankTemplate->GetTurnSpeed() * updateTime);
+			RotateLocalY(m_TankTemplate->GetTurnSpeed() * updateTime);
 		}
 		else if (GetTurnAmount(m_TargetPoint, Matrix()) < -0.1)
 		{
-			Matrix().RotateLocalY(-m_TankTemplate->GetTurnSpeed() * updateTime);
+			RotateLocalY(-m_TankTemplate->GetTurnSpeed() * updateTime);
 		}
 
-		if (PointToSphere(5.0f, Matrix().Position(), m_TargetPoint))
+		if (PointToSphere(5.0f, Position(), m_TargetPoint))
 		{ 
 			if (m_PatrolType == Front) { m_TargetPoint = FrontPatrolPoints[m_PatrolPointCounter]; }
 			else { m_TargetPoint = BackPatrolPoints[m_PatrolPointCounter]; }
-			m_State = Patrol;
+			SetState(Patrol);
 		}
 
-		if (m_Speed < m_TankTemplate->GetMaxSpeed())
+		if (Speed() < m_TankTemplate->GetMaxSpeed())
 		{
-			m_Speed += m_TankTemplate->GetAcceleration() * updateTime;
+			Speed() += m_TankTemplate->GetAcceleration() * updateTime;
 		}
 		else
 		{
-			m_Speed = m_TankTemplate->GetMaxSpeed();
+			Speed() = m_TankTemplate->GetMaxSpeed();
 		}
 	}
 	else
 	{
-		m_Speed = 0.0f;
+		Speed() = 0.0f;
 	}
 
 	// Perform movement...
 	// Move along local Z axis scaled by update time
-	Matrix().MoveLocalZ( m_Speed * updateTime );
+	MoveLocalZ( Speed() * updateTime );
+
+	// Scenery blocks movement - push the tank back out of any obstacles, letting it slide along them
+	EntityManager.CollisionWorld().PushOutSphere( Position(),
+	                                              m_TankTemplate->Mesh()->BoundingRadius() );
 
 	return true; // Don't destroy the entity
 }
@@ -278,48 +287,71 @@ void CTankEntity::ChangePatrolPoint()
 
 float CTankEntity::GetTurnAmount(CVector3 target, CMatrix4x4 matrix)
 {
-	target = Normalise(target - matrix.Position());
-
-	if (Dot(Normalise(matrix.XAxis()), target) > 0)
-	{
-		return ACos(Dot(Normalise(matrix.ZAxis()), target));
-	}
-	else
-	{
-		return -ACos(Dot(Normalise(matrix.ZAxis()), target));
-	}
+	// Angle between the matrix's Z axis and the direction to the target. The cosine is the dot
+	// product over both lengths, using one approximate inverse square root rather than
+	// normalising each vector. The sign of the turn only needs the sign of the X axis dot product
+	const CVector3 toTarget = target - matrix.Position();
+	const CVector3 zAxis = matrix.ZAxis();
+	TFloat32 cosAngle = Dot(zAxis, toTarget) *
+	                    FastInvSqrt(LengthSquared(zAxis) * LengthSquared(toTarget));
+	TFloat32 angle = FastACos(cosAngle);
+
+	return (Dot(matrix.XAxis(), toTarget) > 0) ? angle : -angle;
 }
 
+// Look for a visible enemy tank within 15 degrees of the turret's facing, setting it as the target
+// if one is found. Enemies in the turret's view are tested for line of sight in batches against
+// the static scenery, the nearest visible enemy is chosen
 bool CTankEntity::TankInTurretRange()
 {
-	//CVector3(0.0f, 0.0f, 40.0f)
-	for (int i = 0; i < NumTanksPerTeam; i++)
+	// World matrix of the turret, calculated once for all the enemies
+	CMatrix4x4 turretMatrix = Matrix(2) * Matrix(1) * Matrix();
+	CVector3 turretPos = turretMatrix.Position();
+	CVector3 turretFacing = Normalise(turretMatrix.ZAxis());
+	TFloat32 turretHeight = turretPos.y - Position().y;
+	const TFloat32 cosViewAngle = Cos(ToRadians(15.0f));
+
+	const TUInt32 MaxSightLines = 16;
+	SLineOfSight sightLines[MaxSightLines];
+	TEntityUID sightTargets[MaxSightLines];
+	TFloat32 nearestDistance = 0.0f;
+	m_TargetTank = NullUID;
+
+	const CEntityManager::TEntityList& enemyTanks = EntityManager.GetTanksOnTeam(1 - m_Team);
+	TUInt32 enemy = 0;
+	while (enemy < enemyTanks.size())
 	{
-		CVector3 turretVector = (Matrix(2) * Matrix(1) * Matrix()).ZAxis();
-		CEntity* enemyTank = EntityManager.GetEntity(GetTankUID(1 - m_Team, i));
-
-		if (enemyTank)
+		// Collect a batch of lines of sight from the turret to the enemies in its view, at turret
+		// height so the ground is not in the way
+		TUInt32 numLines = 0;
+		for (; enemy < enemyTanks.size() && numLines < MaxSightLines; ++enemy)
 		{
-			CVector3 enemyPos = enemyTank->Position();
-			float angle = acos(Dot(turretVector, enemyPos) / (turretVector.Length() * enemyPos.Length()));
-
-			if (angle < ToRadians(15.0f))
+			CVector3 enemyPos = enemyTanks[enemy]->Position();
+			enemyPos.y += turretHeight;
+			CVector3 toEnemy = enemyPos - turretPos;
+			TFloat32 enemyDistance = Length(toEnemy);
+			if (enemyDistance > kfEpsilon && Dot(turretFacing, toEnemy) > cosViewAngle * enemyDistance)
 			{
-				CVector3 currentPos = Normalise(enemyPos - Matrix(2).ZAxis());
-
-				while (currentPos.DistanceTo(enemyPos) > 5.0f)
-				{
-					if (PointToAABB(5.0f, 5.0f, Matrix(2).ZAxis(), CVector3(0.0f, 0.0f, 40.0f))) return false;
-					else { currentPos += Normalise(enemyPos - Matrix(2).ZAxis()); }
-				}
+				sightLines[numLines].from = turretPos;
+				sightLines[numLines].to = enemyPos;
+				sightTargets[numLines] = enemyTanks[enemy]->GetUID();
+				++numLines;
+			}
+		}
 
-				m_TargetTank = enemyTank;
-				return true;
+		EntityManager.CollisionWorld().LineOfSightBatch(sightLines, numLines);
+		for (TUInt32 line = 0; line < numLines; ++line)
+		{
+			if (sightLines[line].visible &&
+			    (m_TargetTank == NullUID || sightLines[line].distance < nearestDistance))
+			{
+				m_TargetTank = sightTargets[line];
+				nearestDistance = sightLines[line].distance;
 			}
 		}
 	}
 
-	return false;
+	return m_TargetTank != NullUID;
 }
 
 } // namespace gen
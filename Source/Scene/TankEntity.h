@@ -112,7 +112,8 @@ private:
 
 // A tank entity inherits the ID/positioning/rendering support of the base entity class
 // and adds instance and state data. It overrides the update function to perform the tank
-// entity behaviour
+// entity behaviour. The frequently updated tank data (HP, speed, state and timer) is held in
+// the entity storage rather than in the tank entity itself
 // The shell code performs very limited behaviour to be rewritten as one of the assignment
 // requirements. You may wish to alter other parts of the class to suit your game additions
 // E.g extra member variables, constructor parameters, getters etc.
@@ -125,16 +126,18 @@ public:
 	// class constructor
 	CTankEntity
 	(
+		CEntityStorage* storage,
 		CTankTemplate*  tankTemplate,
 		TEntityUID      UID,
 		TUInt32         team,
-		const string&   name = "",
+		TSymbol         name = NullSymbol,
 		const CVector3& position = CVector3::kOrigin, 
 		const CVector3& rotation = CVector3( 0.0f, 0.0f, 0.0f ),
 		const CVector3& scale = CVector3( 1.0f, 1.0f, 1.0f )
 	);
 
-	// No destructor needed
+	// Destructor removes the tank data from the entity storage
+	virtual ~CTankEntity();
 
 
 /////////////////////////////////////
@@ -154,12 +157,12 @@ public:
 
 	TFloat32 GetSpeed()
 	{
-		return m_Speed;
+		return Storage()->TankSpeed( m_TankIndex );
 	}
 
 	TInt32 GetHP()
 	{
-		return m_HP;
+		return Storage()->TankHP( m_TankIndex );
 	}
 
 	TInt32 GetShellsFired()
@@ -169,12 +172,12 @@ public:
 
 	EState GetState()
 	{
-		return m_State;
+		return static_cast<EState>(Storage()->TankState( m_TankIndex ));
 	}
 
 	void SetState(EState state)
 	{
-		m_State = state;
+		Storage()->TankState( m_TankIndex ) = state;
 	}
 
 
@@ -207,6 +210,20 @@ private:
 	virtual void ChangePatrolPoint();
 	virtual bool TankInTurretRange();
 
+	// Direct access to the tank data held in the entity storage
+	TInt32& HP()
+	{
+		return Storage()->TankHP( m_TankIndex );
+	}
+	TFloat32& Speed()
+	{
+		return Storage()->TankSpeed( m_TankIndex );
+	}
+	TFloat32& Timer()
+	{
+		return Storage()->TankTimer( m_TankIndex );
+	}
+
 
 	/////////////////////////////////////
 	// Data
@@ -214,19 +231,21 @@ private:
 	// The template holding common data for all tank entities
 	CTankTemplate* m_TankTemplate;
 
+	// Index of this tank's data (HP, speed, state and timer) in the entity storage
+	TUInt32  m_TankIndex;
+
+	// Template and entity name used for shells fired by this tank, as name table symbols so
+	// firing doesn't need any string look-ups
+	TSymbol  m_ShellTemplate;
+	TSymbol  m_ShellName;
+
 	// Tank data
-	TInt32   m_HP;    // Current hit points for the tank
 	TUInt32  m_Team;  // Team number for tank (to know who the enemy is)
-	TFloat32 m_Speed; // Current speed (in facing direction)
 	TInt32	 m_ShellsFired;
-
-	// Tank state
-	EState   m_State; // Current state
-	TFloat32 m_Timer; // A timer used in the example update function   
 public:
 	EPatrolType m_PatrolType;
 	CVector3 m_TargetPoint;
-    CEntity* m_TargetTank;
+    TEntityUID m_TargetTank; // UID of the enemy tank being aimed at, checked before use as it may be destroyed
 	int m_PatrolPointCounter = 0;
 };
 
@@ -17,6 +17,11 @@ using namespace std;
 #include "Light.h"
 #include "EntityManager.h"
 #include "Messenger.h"
+#include "HashTableStats.h"
+#include "MathBenchmark.h"
+#include "MatrixKernels.h"
+#include "BatchKernels.h"
+#include "MathIO.h"
 #include "TankAssignment.h"
 
 namespace gen
@@ -68,12 +73,31 @@ CEntityManager EntityManager;
 const int NumTanksPerTeam = 3;
 TEntityUID ATanks[NumTanksPerTeam];
 TEntityUID BTanks[NumTanksPerTeam];
-CEntity* selectedTank;
+TEntityUID selectedTank = NullUID; // UID of the selected tank, may no longer exist
 
-// Patrol Points
+// Patrol Points - constant initialised (CVector3 constructors are constexpr) so no setup code
+// is needed. Declared extern so they can be shared with the tank entities
 const int NumPoints = 7;
-CVector3 FrontPatrolPoints[NumPoints];
-CVector3 BackPatrolPoints[NumPoints];
+extern const CVector3 FrontPatrolPoints[NumPoints] =
+{
+	CVector3(-70.0f, 0.0f, 35.0f),
+	CVector3(-50.0f, 0.0f, -10.0f),
+	CVector3(-30.0f, 0.0f, 20.0f),
+	CVector3(0.0f, 0.0f, -25.0f),
+	CVector3(30.0f, 0.0f, 20.0f),
+	CVector3(50.0f, 0.0f, -10.0f),
+	CVector3(70.0f, 0.0f, 35.0f)
+};
+extern const CVector3 BackPatrolPoints[NumPoints] =
+{
+	CVector3(70.0f, 0.0f, 45.0f),
+	CVector3(50.0f, 0.0f, 90.0f),
+	CVector3(30.0f, 0.0f, 60.0f),
+	CVector3(0.0f, 0.0f, 105.0f),
+	CVector3(-30.0f, 0.0f, 60.0f),
+	CVector3(-50.0f, 0.0f, 90.0f),
+	CVector3(-70.0f, 0.0f, 45.0f)
+};
 
 // Cameras
 enum ECamera
@@ -103,6 +127,31 @@ SColourRGBA AmbientLight;
 bool ShowExtraUI = true;
 CVector3 mousePos;
 
+// Results of the entity UID hash table benchmark, run on request (key H) and shown in the extra UI
+const TUInt32 BenchmarkEntities = 1024;
+const TUInt32 BenchmarkFrames = 300;
+SHashTableBenchmarkResult HashTableBenchmark[kiNumHashTableBenchmarks];
+bool HashTableBenchmarkRun = false;
+
+// Results of the fast math benchmark, run on request (key J) and shown in the extra UI
+const TUInt32 BenchmarkValues = 1000000;
+SFastMathBenchmarkResult FastMathBenchmark[kiNumFastMathBenchmarks];
+bool FastMathBenchmarkRun = false;
+
+// Results of the math kernel validation, run on request (key K) and shown in the extra UI. These
+// are the largest errors of the SSE matrix and batch kernels relative to the scalar reference
+// kernels. Only rounding should differ, so anything over the tolerance means an SSE kernel is wrong
+const TUInt32 KernelValidationTests = 10000;
+const TFloat32 KernelValidationTolerance = 1e-4f;
+TFloat32 MatrixKernelError = 0.0f;
+TFloat32 BatchKernelError = 0.0f;
+
+// Number of random hard-to-round float texts that the math text decoding reads differently to
+// strtof, checked with the math kernels (key K). Should be 0
+const TUInt32 FloatTextValidationTests = 100000;
+TUInt32 FloatTextMismatches = 0;
+bool KernelValidationRun = false;
+
 // Sum of recent update times and number of times in the sum - used to calculate
 // average over a given time period
 float SumUpdateTimes = 0.0f;
@@ -146,6 +195,12 @@ bool SceneSetup()
 			                        CVector3(0.0f, Random(0.0f, 2.0f * kfPi), 0.0f) );
 	}
 
+	// Buildings and trees are obstacles for tanks and shells. The collision world is built once
+	// here, the scenery does not move
+	EntityManager.AddToCollisionWorld("Building");
+	EntityManager.AddToCollisionWorld("Tree");
+	EntityManager.BuildCollisionWorld();
+
 
 	/////////////////////////////////
 	// Create tank templates
@@ -160,24 +215,13 @@ bool SceneSetup()
 	// Template for tank shell
 	EntityManager.CreateTemplate("Projectile", "Shell Type 1", "Bullet.x");
 
-	/////////////////////////////
-	// Create Patrol Points
-
-	FrontPatrolPoints[0] = CVector3(-70.0f, 0.0f, 35.0f);
-	FrontPatrolPoints[1] = CVector3(-50.0f, 0.0f, -10.0f);
-	FrontPatrolPoints[2] = CVector3(-30.0f, 0.0f, 20.0f);
-	FrontPatrolPoints[3] = CVector3(0.0f, 0.0f, -25.0f);
-	FrontPatrolPoints[4] = CVector3(30.0f, 0.0f, 20.0f);
-	FrontPatrolPoints[5] = CVector3(50.0f, 0.0f, -10.0f);
-	FrontPatrolPoints[6] = CVector3(70.0f, 0.0f, 35.0f);
-
-	BackPatrolPoints[0] = CVector3(70.0f, 0.0f, 45.0f);
-	BackPatrolPoints[1] = CVector3(50.0f, 0.0f, 90.0f);
-	BackPatrolPoints[2] = CVector3(30.0f, 0.0f, 60.0f);
-	BackPatrolPoints[3] = CVector3(0.0f, 0.0f, 105.0f);
-	BackPatrolPoints[4] = CVector3(-30.0f, 0.0f, 60.0f);
-	BackPatrolPoints[5] = CVector3(-50.0f, 0.0f, 90.0f);
-	BackPatrolPoints[6] = CVector3(-70.0f, 0.0f, 45.0f);
+	// Shells are created in a pool to avoid allocating memory for every shot. Capacity is the
+	// most shells expected to be in flight at once, check the high-water mark on screen
+	EntityManager.CreateShellPool("Shell Type 1", 256);
+
+	// Deliver messages at the start of the frame after they are sent, so entity behaviour does
+	// not depend on update order (toggle with M)
+	Messenger.SetBuffered(true);
 
 	////////////////////////////////
 	// Create tank entities
@@ -267,10 +311,8 @@ int GetNumTanksPerTeam()
 
 bool PointToSphere(const int radius, const CVector3 currentPos, const CVector3 target)
 {
-	const float distance = Sqrt((currentPos.x - target.x) * (currentPos.x - target.x) +
-		(currentPos.z - target.z) * (currentPos.z - target.z));
-
-	return distance < radius;
+	// Compare squared distances on the ground plane, no square root needed
+	return IsWithinDistanceXZ(currentPos, target, static_cast<TFloat32>(radius));
 }
 
 bool PointToAABB(const int xSize, const int zSize, const CVector3 currentPos, const CVector3 target)
@@ -402,6 +444,77 @@ void RenderSceneText( float updateTime )
 		outText << mousePos.x << ", " << mousePos.y << ", " << mousePos.z;
 		RenderText(outText.str(), 2, 40, 1.0f, 0.0f, 0.0f, false);
 		outText.str("");
+
+		// Shell pool usage - shells in use, capacity, high-water mark and overflows
+		CShellPool* shellPool = EntityManager.GetShellPool("Shell Type 1");
+		if (ShowExtraUI && shellPool)
+		{
+			outText << "Shells: " << shellPool->GetNumInUse() << "/" << shellPool->GetCapacity()
+			        << " Peak: " << shellPool->GetHighWaterMark()
+			        << " Overflows: " << shellPool->GetNumOverflows();
+			RenderText(outText.str(), 2, 55, 1.0f, 1.0f, 0.0f, false);
+			outText.str("");
+		}
+
+		// Messages sent and received last frame
+		if (ShowExtraUI)
+		{
+			outText << "Messages: " << Messenger.GetNumSentLastFrame() << " sent "
+			        << Messenger.GetNumReceivedLastFrame() << " received"
+			        << (Messenger.IsBuffered() ? " (buffered)" : " (immediate)");
+			RenderText(outText.str(), 2, 70, 1.0f, 1.0f, 0.0f, false);
+			outText.str("");
+		}
+
+		// Entity UID hash table benchmark results, once run - times per frame in microseconds
+		if (ShowExtraUI && HashTableBenchmarkRun)
+		{
+			for (TUInt32 i = 0; i < kiNumHashTableBenchmarks; ++i)
+			{
+				const SHashTableBenchmarkResult& result = HashTableBenchmark[i];
+				outText << result.sSetup << ": build " << result.fBuildTime * 1000.0f << "ms, frame "
+				        << result.fFrameTime * 1000000.0f << "us (max "
+				        << result.fMaxFrameTime * 1000000.0f << "us)";
+				RenderText(outText.str(), 2, 85 + i * 15, 1.0f, 1.0f, 0.0f, false);
+				outText.str("");
+			}
+		}
+
+		// Fast math benchmark results, once run - times for all the values in milliseconds
+		if (ShowExtraUI && FastMathBenchmarkRun)
+		{
+			for (TUInt32 i = 0; i < kiNumFastMathBenchmarks; ++i)
+			{
+				const SFastMathBenchmarkResult& result = FastMathBenchmark[i];
+				outText << result.sFunction << ": exact " << result.fExactTime * 1000.0f
+				        << "ms, fast " << result.fFastTime * 1000.0f << "ms, max error "
+				        << result.fMaxError;
+				RenderText(outText.str(), 2, 150 + i * 15, 1.0f, 1.0f, 0.0f, false);
+				outText.str("");
+			}
+		}
+
+		// Math kernel validation result, once run - shown in red if over the tolerance
+		if (ShowExtraUI && KernelValidationRun)
+		{
+			bool passed = (MatrixKernelError <= KernelValidationTolerance);
+			outText << "Matrix kernels: max error " << MatrixKernelError
+			        << (passed ? " (OK)" : " (FAILED)");
+			RenderText(outText.str(), 2, 225, 1.0f, passed ? 1.0f : 0.0f, 0.0f, false);
+			outText.str("");
+
+			passed = (BatchKernelError <= KernelValidationTolerance);
+			outText << "Batch kernels: max error " << BatchKernelError
+			        << (passed ? " (OK)" : " (FAILED)");
+			RenderText(outText.str(), 2, 240, 1.0f, passed ? 1.0f : 0.0f, 0.0f, false);
+			outText.str("");
+
+			passed = (FloatTextMismatches == 0);
+			outText << "Float text: " << FloatTextMismatches << " of " << FloatTextValidationTests
+			        << " differ from strtof" << (passed ? " (OK)" : " (FAILED)");
+			RenderText(outText.str(), 2, 255, 1.0f, passed ? 1.0f : 0.0f, 0.0f, false);
+			outText.str("");
+		}
 	}
 
 	for (int i = 0; i < NumTanksPerTeam; i++)
@@ -424,7 +537,7 @@ void RenderSceneText( float updateTime )
 				RenderText(outText.str(), x, y + textSpacer, 0.0f, 0.0f, 1.0f, true);
 				outText.str("");
 
-				if (entity == selectedTank)
+				if (entity->GetUID() == selectedTank)
 				{
 					outText << "SELECTED";
 					RenderText(outText.str(), x, y, 1.0f, 0.0f, 0.0f, true);
@@ -487,7 +600,7 @@ void RenderSceneText( float updateTime )
 				RenderText(outText.str(), x, y + textSpacer, 0.0f, 0.0f, 1.0f, true);
 				outText.str("");
 
-				if (entity == selectedTank)
+				if (entity->GetUID() == selectedTank)
 				{
 					outText << "SELECTED";
 					RenderText(outText.str(), x, y, 1.0f, 0.0f, 0.0f, true);
@@ -535,8 +648,12 @@ void RenderSceneText( float updateTime )
 // Update the scene between rendering
 void UpdateScene( float updateTime )
 {
-	// Call all entity update functions
+	// Deliver messages sent last frame (in buffered mode)
+	Messenger.BeginFrame();
+
+	// Call all entity update functions, then retire group messages all entities have now seen
 	EntityManager.UpdateAllEntities( updateTime );
+	Messenger.RetireGroupMessages();
 	MoveChaseCameras(updateTime);
 
 	// Set camera speeds
@@ -544,58 +661,23 @@ void UpdateScene( float updateTime )
 	if (KeyHit(Key_F2)) CameraMoveSpeed = 5.0f;
 	if (KeyHit(Key_F3)) CameraMoveSpeed = 40.0f;
 
+	// Send go / stop messages to all tanks on both teams
 	if (KeyHit(Key_1))
 	{
-		for (int i = 0; i < NumTanksPerTeam; i++)
-		{
-			CEntity* entity = EntityManager.GetEntity(ATanks[i]);
-			if (entity)
-			{
-				SMessage msg;
-				msg.type = Msg_Go;
-				msg.from = SystemUID;
-				Messenger.SendMessageA(entity->GetUID(), msg);
-			}
-		}
-
-		for (int i = 0; i < NumTanksPerTeam; i++)
-		{
-			CEntity* entity = EntityManager.GetEntity(BTanks[i]);
-			if (entity)
-			{
-				SMessage msg;
-				msg.type = Msg_Go;
-				msg.from = SystemUID;
-				Messenger.SendMessageA(entity->GetUID(), msg);
-			}
-		}
+		SMessage msg;
+		msg.type = Msg_Go;
+		msg.from = SystemUID;
+		Messenger.SendMessageToTeam(0, msg);
+		Messenger.SendMessageToTeam(1, msg);
 	}
 
 	if (KeyHit(Key_2))
 	{
-		for (int i = 0; i < NumTanksPerTeam; i++)
-		{
-			CEntity* entity = EntityManager.GetEntity(ATanks[i]);
-			if (entity)
-			{
-				SMessage msg;
-				msg.type = Msg_Stop;
-				msg.from = SystemUID;
-				Messenger.SendMessageA(entity->GetUID(), msg);
-			}
-		}
-
-		for (int i = 0; i < NumTanksPerTeam; i++)
-		{
-			CEntity* entity = EntityManager.GetEntity(BTanks[i]);
-			if (entity)
-			{
-				SMessage msg;
-				msg.type = Msg_Stop;
-				msg.from = SystemUID;
-				Messenger.SendMessageA(entity->GetUID(), msg);
-			}
-		}
+		SMessage msg;
+		msg.type = Msg_Stop;
+		msg.from = SystemUID;
+		Messenger.SendMessageToTeam(0, msg);
+		Messenger.SendMessageToTeam(1, msg);
 	}
 
 	if (KeyHit(Key_3)) currentCam = Main;
@@ -612,6 +694,37 @@ void UpdateScene( float updateTime )
 		else { ShowExtraUI = true; }
 	}
 
+	// Toggle buffered message delivery
+	if (KeyHit(Key_M))
+	{
+		Messenger.SetBuffered(!Messenger.IsBuffered());
+	}
+
+	// Run the entity UID hash table benchmark, results are shown in the extra UI. Stalls for a
+	// moment while it runs
+	if (KeyHit(Key_H))
+	{
+		BenchmarkEntityUIDHashTables(BenchmarkEntities, BenchmarkFrames, HashTableBenchmark);
+		HashTableBenchmarkRun = true;
+	}
+
+	// Run the fast math benchmark, results are shown in the extra UI
+	if (KeyHit(Key_J))
+	{
+		BenchmarkFastMath(BenchmarkValues, FastMathBenchmark);
+		FastMathBenchmarkRun = true;
+	}
+
+	// Validate the SSE math kernels against the scalar reference kernels, and the math text
+	// decoding against strtof, the results are shown in the extra UI
+	if (KeyHit(Key_K))
+	{
+		MatrixKernelError = ValidateMatrixKernels(KernelValidationTests);
+		BatchKernelError = ValidateBatchKernels(KernelValidationTests);
+		FloatTextMismatches = ValidateFloatText(FloatTextValidationTests);
+		KernelValidationRun = true;
+	}
+
 	if (KeyHit(Mouse_LButton))
 	{
 		for (int i = 0; i < NumTanksPerTeam; i++)
@@ -626,7 +739,7 @@ void UpdateScene( float updateTime )
 				GetCamera()->PixelFromWorldPt(entity->Position(), ViewportWidth, ViewportHeight, &x, &y);
 				if (mousePos.DistanceTo(CVector2(x, y)) < 30.0f)
 				{
-					selectedTank = entity;
+					selectedTank = entity->GetUID();
 				}
 			}
 		}
@@ -642,7 +755,7 @@ void UpdateScene( float updateTime )
 				GetCamera()->PixelFromWorldPt(entity->Position(), ViewportWidth, ViewportHeight, &x, &y);
 				if (mousePos.DistanceTo(CVector2(x, y)) < 30.0f)
 				{
-					selectedTank = entity;
+					selectedTank = entity->GetUID();
 				}
 			}
 		}
@@ -655,7 +768,13 @@ void UpdateScene( float updateTime )
 		movePos.y = 0.0f;
 		movePos *= 100;
 		mousePos = movePos;
-		selectedTank->Matrix().SetPosition(movePos);
+
+		// The selected tank may have been destroyed since it was selected
+		CEntity* entity = EntityManager.GetEntity(selectedTank);
+		if (entity)
+		{
+			entity->Position() = movePos;
+		}
 	}
 
 	// Move the camera